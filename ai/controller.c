@@ -13,6 +13,7 @@
 #include "ai/controller.h"
 #include "bus/address.h"
 #include "bus/controller.h"
+#include "fpu/fpu.h"
 #include "ri/controller.h"
 #include "rsp/rsp.h"
 #include "vr4300/interface.h"
@@ -28,8 +29,6 @@ const char *ai_register_mnemonics[NUM_AI_REGISTERS] = {
 #endif
 
 static void ai_dma(struct ai_controller *ai);
-static const uint8_t *byteswap_audio_buffer(const uint8_t *input,
-    uint8_t *output, uint32_t length);
 
 // Advances the controller by one clock cycle.
 void ai_cycle_(struct ai_controller *ai) {
@@ -60,6 +59,7 @@ void ai_dma(struct ai_controller *ai) {
   memcpy(&bus, ai, sizeof(bus));
 
   if (ai->fifo[ai->fifo_ri].length > 0) {
+    fpu_state_t fpu_state = fpu_get_state();
     unsigned freq = (double) NTSC_DAC_FREQ / (ai->regs[AI_DACRATE_REG] + 1);
     unsigned samples = ai->fifo[ai->fifo_ri].length / 4;
 
@@ -124,7 +124,21 @@ void ai_dma(struct ai_controller *ai) {
       cen64_align(uint8_t buf[0x40000], 16);
       uint32_t length = ai->fifo[ai->fifo_ri].length;
       uint8_t *input = bus->ri->ram + ai->fifo[ai->fifo_ri].address;
+#if RDRAM_BYTE_XOR
+      const uint8_t *buf_ptr = buf;
+      uint32_t i;
+
+      // Words are already in host order; swap the two samples back.
+      for (i = 0; i < length; i += sizeof(uint32_t)) {
+        uint32_t word;
+
+        memcpy(&word, input + i, sizeof(word));
+        word = word >> 16 | word << 16;
+        memcpy(buf + i, &word, sizeof(word));
+      }
+#else
       const uint8_t *buf_ptr = byteswap_audio_buffer(input, buf, length);
+#endif
 
       ai->ctx.unqueued_buffers--;
       buffer = ai->ctx.buffers[ai->ctx.unqueued_buffers];
@@ -135,8 +149,16 @@ void ai_dma(struct ai_controller *ai) {
 
     alGetSourcei(ai->ctx.source, AL_SOURCE_STATE, &val);
 
-    if (val != AL_PLAYING)
+    // A stopped source has played out everything we queued.
+    if (val != AL_PLAYING) {
+      if (val == AL_STOPPED)
+        ai->underruns++;
+
       alSourcePlay(ai->ctx.source);
+    }
+
+    // Keep the host's floating point out of the guest's FCR31.
+    fpu_set_state(fpu_state);
   }
 
   // If the length was zero, just interrupt now?
@@ -251,6 +273,8 @@ int write_ai_regs(void *opaque, uint32_t address, uint32_t word, uint32_t dqm) {
   return 0;
 }
 
+// Byteswaps samples (16-bit BE -> host) into output. Returns a pointer
+// to the first sample, which is output + 8 if input was misaligned.
 const uint8_t *byteswap_audio_buffer(const uint8_t *input,
     uint8_t *output, uint32_t length) {
   uint32_t i = 0;
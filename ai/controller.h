@@ -40,6 +40,7 @@ struct ai_controller {
 
   unsigned fifo_count, fifo_wi, fifo_ri;
   struct ai_fifo_entry fifo[2];
+  unsigned long underruns;
   bool no_output;
 };
 
@@ -54,6 +55,9 @@ cen64_flatten cen64_hot static inline void ai_cycle(struct ai_controller *ai) {
     ai_cycle_(ai);
 }
 
+cen64_hot const uint8_t *byteswap_audio_buffer(const uint8_t *input,
+    uint8_t *output, uint32_t length);
+
 int read_ai_regs(void *opaque, uint32_t address, uint32_t *word);
 int write_ai_regs(void *opaque, uint32_t address, uint32_t word, uint32_t dqm);
 
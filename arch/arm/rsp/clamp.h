@@ -0,0 +1,39 @@
+//
+// arch/arm/rsp/clamp.h
+//
+// This file is subject to the terms and conditions defined in
+// 'LICENSE', which is part of this source code package.
+//
+
+static inline uint16x8_t rsp_sclamp_acc_tomd(
+  uint16x8_t acc_md, uint16x8_t acc_hi) {
+  uint16x8x2_t acc = vzipq_u16(acc_md, acc_hi);
+  int16x4_t l = vqmovn_s32(vreinterpretq_s32_u16(acc.val[0]));
+  int16x4_t h = vqmovn_s32(vreinterpretq_s32_u16(acc.val[1]));
+  return rsp_u16(vcombine_s16(l, h));
+}
+
+static inline uint16x8_t rsp_uclamp_acc(uint16x8_t val,
+  uint16x8_t acc_md, uint16x8_t acc_hi, uint16x8_t zero) {
+  uint16x8_t clamp_mask, clamped_val;
+  uint16x8_t hi_sign_check, md_sign_check;
+  uint16x8_t md_negative, hi_negative;
+
+  hi_negative = rsp_u16(vshrq_n_s16(rsp_s16(acc_hi), 15));
+  md_negative = rsp_u16(vshrq_n_s16(rsp_s16(acc_md), 15));
+
+  // We don't have to clamp if the HI part of the
+  // accumulator is sign-extended down to the MD part.
+  hi_sign_check = vceqq_u16(hi_negative, acc_hi);
+  md_sign_check = vceqq_u16(hi_negative, md_negative);
+  clamp_mask = vandq_u16(md_sign_check, hi_sign_check);
+
+  // Generate the value in the event we need to clamp.
+  //   * hi_negative, mid_sign => xxxx
+  //   * hi_negative, !mid_sign => 0000
+  //   * !hi_negative, mid_sign => FFFF
+  //   * !hi_negative, !mid_sign => xxxx
+  clamped_val = vceqq_u16(hi_negative, zero);
+  return vbslq_u16(clamp_mask, val, clamped_val);
+}
+
@@ -12,15 +12,62 @@
 #include "common.h"
 #include <arm_neon.h>
 
+struct rsp;
 typedef uint16x8_t rsp_vect_t;
 
+// Gives the architecture backend a chance to initialize the RSP.
+cen64_cold void arch_rsp_destroy(struct rsp *rsp);
+cen64_cold int arch_rsp_init(struct rsp *rsp);
+
+// Masks for AND/OR/XOR and NAND/NOR/NXOR.
+extern const uint16_t rsp_vlogic_mask[2][8];
+
+// Reinterprets a vector as signed or unsigned lanes.
+static inline int16x8_t rsp_s16(uint16x8_t v) {
+  return vreinterpretq_s16_u16(v);
+}
+
+static inline uint16x8_t rsp_u16(int16x8_t v) {
+  return vreinterpretq_u16_s16(v);
+}
+
+// Upper halves of the signed and unsigned 16x16 products.
+static inline uint16x8_t rsp_mulhi_s16(uint16x8_t vs, uint16x8_t vt) {
+  int32x4_t lo = vmull_s16(vget_low_s16(rsp_s16(vs)),
+    vget_low_s16(rsp_s16(vt)));
+  int32x4_t hi = vmull_s16(vget_high_s16(rsp_s16(vs)),
+    vget_high_s16(rsp_s16(vt)));
+
+  return rsp_u16(vcombine_s16(vshrn_n_s32(lo, 16), vshrn_n_s32(hi, 16)));
+}
+
+static inline uint16x8_t rsp_mulhi_u16(uint16x8_t vs, uint16x8_t vt) {
+  uint32x4_t lo = vmull_u16(vget_low_u16(vs), vget_low_u16(vt));
+  uint32x4_t hi = vmull_u16(vget_high_u16(vs), vget_high_u16(vt));
+
+  return vcombine_u16(vshrn_n_u32(lo, 16), vshrn_n_u32(hi, 16));
+}
+
+// Permutes the bytes of a vector like PSHUFB: keys are the x86 tables,
+// and any index with the high bit set selects zero.
+static inline uint8x16_t rsp_vtbl(uint8x16_t v, const uint16_t *keys) {
+  const uint8x16_t k = vld1q_u8((const uint8_t *) keys);
+  uint8x8x2_t table;
+
+  table.val[0] = vget_low_u8(v);
+  table.val[1] = vget_high_u8(v);
+
+  return vcombine_u8(vtbl2_u8(table, vget_low_u8(k)),
+    vtbl2_u8(table, vget_high_u8(k)));
+}
+
 // Loads and shuffles a 16x8 vector according to element.
 extern const uint8_t shuffle_keys[16][16];
 
 static inline uint16x8_t rsp_vect_load_and_shuffle_operand(
-  const uint8_t *src, unsigned element) {
+  const uint16_t *src, unsigned element) {
   const uint8x16_t keys = vld1q_u8(shuffle_keys[element]);
-  const uint8x8x2_t packed_operand = vld2_u8(src);
+  const uint8x8x2_t packed_operand = vld2_u8((const uint8_t *) src);
 
   uint8x8_t operand_lo_8x8 = vtbl2_u8(packed_operand, vget_low_u8(keys));
   uint8x8_t operand_hi_8x8 = vtbl2_u8(packed_operand, vget_high_u8(keys));
@@ -30,21 +77,138 @@ static inline uint16x8_t rsp_vect_load_and_shuffle_operand(
 }
 
 // Loads a vector without shuffling its elements.
-static inline uint16x8_t rsp_vect_load_unshuffled_operand(const uint8_t *src) {
-  return vreinterpretq_u16_u8(vld1q_u8(src));
+static inline uint16x8_t rsp_vect_load_unshuffled_operand(
+  const uint16_t *src) {
+  return vld1q_u16(src);
 }
 
 // Writes an operand back to memory.
-static inline void rsp_vect_write_operand(uint8_t *dest, uint16x8_t src) {
-  vst1q_u8(dest, vreinterpretq_u8_u16(src));
+static inline void rsp_vect_write_operand(uint16_t *dest, uint16x8_t src) {
+  vst1q_u16(dest, src);
+}
+
+// Functions for reading/writing the accumulator.
+static inline uint16x8_t read_acc_lo(const uint16_t *acc) {
+  return rsp_vect_load_unshuffled_operand(acc + 16);
+}
+static inline uint16x8_t read_acc_md(const uint16_t *acc) {
+  return rsp_vect_load_unshuffled_operand(acc + 8);
+}
+static inline uint16x8_t read_acc_hi(const uint16_t *acc) {
+  return rsp_vect_load_unshuffled_operand(acc);
+}
+static inline uint16x8_t read_vcc_lo(const uint16_t *vcc) {
+  return rsp_vect_load_unshuffled_operand(vcc + 8);
+}
+static inline uint16x8_t read_vcc_hi(const uint16_t *vcc) {
+  return rsp_vect_load_unshuffled_operand(vcc);
+}
+static inline uint16x8_t read_vco_lo(const uint16_t *vco) {
+  return rsp_vect_load_unshuffled_operand(vco + 8);
+}
+static inline uint16x8_t read_vco_hi(const uint16_t *vco) {
+  return rsp_vect_load_unshuffled_operand(vco);
+}
+static inline uint16x8_t read_vce(const uint16_t *vce) {
+  return rsp_vect_load_unshuffled_operand(vce + 8);
 }
+static inline void write_acc_lo(uint16_t *acc, uint16x8_t acc_lo) {
+  rsp_vect_write_operand(acc + 16, acc_lo);
+}
+static inline void write_acc_md(uint16_t *acc, uint16x8_t acc_md) {
+  rsp_vect_write_operand(acc + 8, acc_md);
+}
+static inline void write_acc_hi(uint16_t *acc, uint16x8_t acc_hi) {
+  rsp_vect_write_operand(acc, acc_hi);
+}
+static inline void write_vcc_lo(uint16_t *vcc, uint16x8_t vcc_lo) {
+  rsp_vect_write_operand(vcc + 8, vcc_lo);
+}
+static inline void write_vcc_hi(uint16_t *vcc, uint16x8_t vcc_hi) {
+  rsp_vect_write_operand(vcc, vcc_hi);
+}
+static inline void write_vco_lo(uint16_t *vco, uint16x8_t vco_lo) {
+  rsp_vect_write_operand(vco + 8, vco_lo);
+}
+static inline void write_vco_hi(uint16_t *vco, uint16x8_t vco_hi) {
+  rsp_vect_write_operand(vco, vco_hi);
+}
+static inline void write_vce(uint16_t *vce, uint16x8_t vce_r) {
+  rsp_vect_write_operand(vce + 8, vce_r);
+}
+
+// Returns scalar bitmasks for VCO/VCC/VCE.
+static inline int16_t rsp_get_flags(const uint16_t *flags) {
+  static const int16_t lane_shifts[8] = {0, 1, 2, 3, 4, 5, 6, 7};
+  const int16x8_t shifts = vld1q_s16(lane_shifts);
+  uint16x8_t lo, hi;
+  uint64x2_t bits;
+
+  // Gather the sign bits, low flags in the low byte.
+  lo = vshlq_u16(vshrq_n_u16(vld1q_u16(flags + 8), 15), shifts);
+  hi = vshlq_u16(vshrq_n_u16(vld1q_u16(flags + 0), 15), shifts);
+  bits = vpaddlq_u32(vpaddlq_u16(vorrq_u16(lo, vshlq_n_u16(hi, 8))));
+
+  return (int16_t) (vgetq_lane_u64(bits, 0) | vgetq_lane_u64(bits, 1));
+}
+
+void rsp_set_flags(uint16_t *flags, uint16_t rt);
 
+// Zeroes out a vector register.
+static inline uint16x8_t rsp_vzero(void) {
+  return vdupq_n_u16(0);
+}
+
+// Load and store functions.
+void rsp_vload_group1(struct rsp *rsp, uint32_t addr, unsigned element,
+  uint16_t *regp, rsp_vect_t reg, rsp_vect_t dqm);
+
+void rsp_vload_group2(struct rsp *rsp, uint32_t addr, unsigned element,
+  uint16_t *regp, rsp_vect_t reg, rsp_vect_t dqm);
+
+void rsp_vload_group4(struct rsp *rsp, uint32_t addr, unsigned element,
+  uint16_t *regp, rsp_vect_t reg, rsp_vect_t dqm);
+
+void rsp_vstore_group1(struct rsp *rsp, uint32_t addr, unsigned element,
+  uint16_t *regp, rsp_vect_t reg, rsp_vect_t dqm);
+
+void rsp_vstore_group2(struct rsp *rsp, uint32_t addr, unsigned element,
+  uint16_t *regp, rsp_vect_t reg, rsp_vect_t dqm);
+
+void rsp_vstore_group4(struct rsp *rsp, uint32_t addr, unsigned element,
+  uint16_t *regp, rsp_vect_t reg, rsp_vect_t dqm);
+
+#include "arch/arm/rsp/clamp.h"
+#include "arch/arm/rsp/vabs.h"
+#include "arch/arm/rsp/vadd.h"
+#include "arch/arm/rsp/vaddc.h"
 #include "arch/arm/rsp/vand.h"
-#include "arch/arm/rsp/vnand.h"
-#include "arch/arm/rsp/vnor.h"
+#include "arch/arm/rsp/vch.h"
+#include "arch/arm/rsp/vcmp.h"
+#include "arch/arm/rsp/vcl.h"
+#include "arch/arm/rsp/vcr.h"
+#include "arch/arm/rsp/vmac.h"
+#include "arch/arm/rsp/vmrg.h"
+#include "arch/arm/rsp/vmul.h"
+#include "arch/arm/rsp/vmulh.h"
+#include "arch/arm/rsp/vmull.h"
+#include "arch/arm/rsp/vmulm.h"
+#include "arch/arm/rsp/vmuln.h"
 #include "arch/arm/rsp/vor.h"
-#include "arch/arm/rsp/vnxor.h"
+#include "arch/arm/rsp/vsub.h"
+#include "arch/arm/rsp/vsubc.h"
 #include "arch/arm/rsp/vxor.h"
 
+extern const uint16_t vdiv_mask_table[8][8];
+
+uint16x8_t rsp_vdivh(struct rsp *rsp,
+  unsigned src, unsigned e, unsigned dest, unsigned de);
+
+uint16x8_t rsp_vmov(struct rsp *rsp,
+  unsigned src, unsigned e, unsigned dest, unsigned de);
+
+uint16x8_t rsp_vrcp_vrsq(struct rsp *rsp, uint32_t iw, int dp,
+  unsigned src, unsigned e, unsigned dest, unsigned de);
+
 #endif
 
@@ -0,0 +1,22 @@
+//
+// arch/arm/rsp/vabs.h
+//
+// This file is subject to the terms and conditions defined in
+// 'LICENSE', which is part of this source code package.
+//
+
+#include "common.h"
+
+static inline uint16x8_t rsp_vabs(uint16x8_t vs, uint16x8_t vt,
+  uint16x8_t zero, uint16x8_t *acc_lo) {
+  uint16x8_t vs_zero = vceqq_u16(vs, zero);
+  uint16x8_t sign_lt = rsp_u16(vshrq_n_s16(rsp_s16(vs), 15));
+  uint16x8_t vd = vbicq_u16(vt, vs_zero);
+
+  // Careful: if VT = 0x8000 and VS is negative,
+  // acc_lo will be 0x8000 but vd will be 0x7FFF.
+  vd = veorq_u16(vd, sign_lt);
+  *acc_lo = vsubq_u16(vd, sign_lt);
+  return rsp_u16(vqsubq_s16(rsp_s16(vd), rsp_s16(sign_lt)));
+}
+
@@ -0,0 +1,26 @@
+//
+// arch/arm/rsp/vadd.h
+//
+// This file is subject to the terms and conditions defined in
+// 'LICENSE', which is part of this source code package.
+//
+
+#include "common.h"
+
+static inline uint16x8_t rsp_vadd(uint16x8_t vs, uint16x8_t vt,
+  uint16x8_t carry, uint16x8_t *acc_lo) {
+  int16x8_t minimum, maximum;
+  uint16x8_t vd;
+
+  // VCC uses unsaturated arithmetic.
+  vd = vaddq_u16(vs, vt);
+  *acc_lo = vsubq_u16(vd, carry);
+
+  // VD is the signed sum of the two sources and the carry. Since we
+  // have to saturate the sum of all three, we have to be clever.
+  minimum = vminq_s16(rsp_s16(vs), rsp_s16(vt));
+  maximum = vmaxq_s16(rsp_s16(vs), rsp_s16(vt));
+  minimum = vqsubq_s16(minimum, rsp_s16(carry));
+  return rsp_u16(vqaddq_s16(minimum, maximum));
+}
+
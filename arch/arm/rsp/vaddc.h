@@ -0,0 +1,22 @@
+//
+// arch/arm/rsp/vaddc.h
+//
+// This file is subject to the terms and conditions defined in
+// 'LICENSE', which is part of this source code package.
+//
+
+#include "common.h"
+
+static inline uint16x8_t rsp_vaddc(uint16x8_t vs, uint16x8_t vt,
+  uint16x8_t zero, uint16x8_t *sn) {
+  uint16x8_t sat_sum, unsat_sum;
+
+  sat_sum = vqaddq_u16(vs, vt);
+  unsat_sum = vaddq_u16(vs, vt);
+
+  *sn = vceqq_u16(sat_sum, unsat_sum);
+  *sn = vceqq_u16(*sn, zero);
+
+  return unsat_sum;
+}
+
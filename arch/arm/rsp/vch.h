@@ -0,0 +1,49 @@
+//
+// arch/arm/rsp/vch.h
+//
+// This file is subject to the terms and conditions defined in
+// 'LICENSE', which is part of this source code package.
+//
+
+static inline uint16x8_t rsp_vch(uint16x8_t vs, uint16x8_t vt,
+  uint16x8_t zero, uint16x8_t *ge, uint16x8_t *le, uint16x8_t *eq,
+  uint16x8_t *sign, uint16x8_t *vce) {
+
+  uint16x8_t sign_negvt, vt_neg;
+  uint16x8_t diff, diff_zero, diff_sel_mask;
+  uint16x8_t diff_gez, diff_lez;
+
+  // sign = (vs ^ vt) < 0
+  *sign = veorq_u16(vs, vt);
+  *sign = vcltq_s16(rsp_s16(*sign), rsp_s16(zero));
+
+  // sign_negvt = sign ? -vt : vt
+  sign_negvt = veorq_u16(vt, *sign);
+  sign_negvt = vsubq_u16(sign_negvt, *sign);
+
+  // Compute diff, diff_zero:
+  diff = vsubq_u16(vs, sign_negvt);
+  diff_zero = vceqq_u16(diff, zero);
+
+  // Compute le/ge:
+  vt_neg = vcltq_s16(rsp_s16(vt), rsp_s16(zero));
+  diff_lez = vcgtq_s16(rsp_s16(diff), rsp_s16(zero));
+  diff_gez = vorrq_u16(diff_lez, diff_zero);
+  diff_lez = vceqq_u16(zero, diff_lez);
+
+  *ge = vbslq_u16(*sign, vt_neg, diff_gez);
+  *le = vbslq_u16(*sign, diff_lez, vt_neg);
+
+  // Compute vce:
+  *vce = vceqq_u16(diff, *sign);
+  *vce = vandq_u16(*vce, *sign);
+
+  // Compute !eq:
+  *eq = vorrq_u16(diff_zero, *vce);
+  *eq = vceqq_u16(*eq, zero);
+
+  // Compute result:
+  diff_sel_mask = vbslq_u16(*sign, *le, *ge);
+  return vbslq_u16(diff_sel_mask, sign_negvt, vs);
+}
+
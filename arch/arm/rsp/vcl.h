@@ -0,0 +1,51 @@
+//
+// arch/arm/rsp/vcl.h
+//
+// This file is subject to the terms and conditions defined in
+// 'LICENSE', which is part of this source code package.
+//
+
+static inline uint16x8_t rsp_vcl(uint16x8_t vs, uint16x8_t vt,
+  uint16x8_t zero, uint16x8_t *ge, uint16x8_t *le, uint16x8_t eq,
+  uint16x8_t sign, uint16x8_t vce) {
+
+  uint16x8_t sign_negvt, diff, ncarry, nvce, diff_zero;
+  uint16x8_t le_case1, le_case2, le_eq, do_le;
+  uint16x8_t ge_eq, do_ge, mux_mask;
+
+  // sign_negvt = sign ? -vt : vt
+  sign_negvt = veorq_u16(vt, sign);
+  sign_negvt = vsubq_u16(sign_negvt, sign);
+
+  // Compute diff, diff_zero, ncarry, and nvce:
+  // Note: diff = sign ? (vs + vt) : (vs - vt).
+  diff = vsubq_u16(vs, sign_negvt);
+  ncarry = vqaddq_u16(vs, vt);
+  ncarry = vceqq_u16(diff, ncarry);
+  nvce = vceqq_u16(vce, zero);
+  diff_zero = vceqq_u16(diff, zero);
+
+  // Compute results for if (sign && ne):
+  le_case1 = vandq_u16(diff_zero, ncarry);
+  le_case1 = vandq_u16(nvce, le_case1);
+  le_case2 = vorrq_u16(diff_zero, ncarry);
+  le_case2 = vandq_u16(vce, le_case2);
+  le_eq = vorrq_u16(le_case1, le_case2);
+
+  // Compute results for if (!sign && ne):
+  ge_eq = vqsubq_u16(vt, vs);
+  ge_eq = vceqq_u16(ge_eq, zero);
+
+  // Blend everything together. Caveat: we don't update
+  // the results of ge/le if ne is false, so be careful.
+  do_le = vbicq_u16(sign, eq);
+  *le = vbslq_u16(do_le, le_eq, *le);
+
+  do_ge = vorrq_u16(sign, eq);
+  *ge = vbslq_u16(do_ge, *ge, ge_eq);
+
+  // Mux the result based on the value of sign.
+  mux_mask = vbslq_u16(sign, *le, *ge);
+  return vbslq_u16(mux_mask, sign_negvt, vs);
+}
+
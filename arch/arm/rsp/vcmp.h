@@ -0,0 +1,51 @@
+//
+// arch/arm/rsp/vcmp.h
+//
+// This file is subject to the terms and conditions defined in
+// 'LICENSE', which is part of this source code package.
+//
+
+static inline uint16x8_t rsp_veq_vge_vlt_vne(uint32_t iw, uint16x8_t vs,
+  uint16x8_t vt, uint16x8_t zero, uint16x8_t *le, uint16x8_t eq,
+  uint16x8_t sign) {
+  uint16x8_t equal = vceqq_u16(vs, vt);
+
+  // VNE & VGE
+  if (iw & 0x2) {
+    // VGE
+    if (iw & 0x1) {
+      uint16x8_t gt = vcgtq_s16(rsp_s16(vs), rsp_s16(vt));
+      uint16x8_t equalsign = vandq_u16(eq, sign);
+
+      equal = vbicq_u16(equal, equalsign);
+      *le = vorrq_u16(gt, equal);
+    }
+
+    // VNE
+    else {
+      uint16x8_t nequal = vceqq_u16(equal, zero);
+
+      *le = vandq_u16(eq, equal);
+      *le = vorrq_u16(*le, nequal);
+    }
+  }
+
+  // VEQ & VLT
+  else {
+    // VEQ
+    if (iw & 0x1)
+      *le = vbicq_u16(equal, eq);
+
+    // VLT
+    else {
+      uint16x8_t lt = vcltq_s16(rsp_s16(vs), rsp_s16(vt));
+
+      equal = vandq_u16(eq, equal);
+      equal = vandq_u16(sign, equal);
+      *le = vorrq_u16(lt, equal);
+    }
+  }
+
+  return vbslq_u16(*le, vs, vt);
+}
+
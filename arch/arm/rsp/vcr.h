@@ -0,0 +1,34 @@
+//
+// arch/arm/rsp/vcr.h
+//
+// This file is subject to the terms and conditions defined in
+// 'LICENSE', which is part of this source code package.
+//
+
+static inline uint16x8_t rsp_vcr(uint16x8_t vs, uint16x8_t vt,
+  uint16x8_t zero, uint16x8_t *ge, uint16x8_t *le) {
+  uint16x8_t diff_sel_mask, diff_gez, diff_lez;
+  uint16x8_t sign, sign_notvt;
+
+  // sign = (vs ^ vt) < 0
+  sign = veorq_u16(vs, vt);
+  sign = rsp_u16(vshrq_n_s16(rsp_s16(sign), 15));
+
+  // Compute le
+  diff_lez = vandq_u16(vs, sign);
+  diff_lez = vaddq_u16(diff_lez, vt);
+  *le = rsp_u16(vshrq_n_s16(rsp_s16(diff_lez), 15));
+
+  // Compute ge
+  diff_gez = vorrq_u16(vs, sign);
+  diff_gez = rsp_u16(vminq_s16(rsp_s16(diff_gez), rsp_s16(vt)));
+  *ge = vceqq_u16(diff_gez, vt);
+
+  // sign_notvt = sn ? ~vt : vt
+  sign_notvt = veorq_u16(vt, sign);
+
+  // Compute result:
+  diff_sel_mask = vbslq_u16(sign, *le, *ge);
+  return vbslq_u16(diff_sel_mask, sign_notvt, vs);
+}
+
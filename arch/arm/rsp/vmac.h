@@ -0,0 +1,66 @@
+//
+// arch/arm/rsp/vmac.h
+//
+// This file is subject to the terms and conditions defined in
+// 'LICENSE', which is part of this source code package.
+//
+
+static inline uint16x8_t rsp_vmacf_vmacu(uint32_t iw, uint16x8_t vs,
+  uint16x8_t vt, uint16x8_t zero, uint16x8_t *acc_lo, uint16x8_t *acc_md,
+  uint16x8_t *acc_hi) {
+  uint16x8_t overflow_hi_mask, overflow_md_mask;
+  uint16x8_t lo, md, hi, carry, overflow_mask;
+
+  // Get the product and shift it over
+  // being sure to save the carries.
+  lo = vmulq_u16(vs, vt);
+  hi = rsp_mulhi_s16(vs, vt);
+
+  md = vshlq_n_u16(hi, 1);
+  carry = vshrq_n_u16(lo, 15);
+  hi = rsp_u16(vshrq_n_s16(rsp_s16(hi), 15));
+  md = vorrq_u16(md, carry);
+  lo = vshlq_n_u16(lo, 1);
+
+  // Tricky part: start accumulating everything.
+  // Get/keep the carry as we'll add it in later.
+  overflow_mask = vqaddq_u16(*acc_lo, lo);
+  *acc_lo = vaddq_u16(*acc_lo, lo);
+
+  overflow_mask = vceqq_u16(*acc_lo, overflow_mask);
+  overflow_mask = vceqq_u16(overflow_mask, zero);
+
+  // Add in the carry. If the middle portion is
+  // already 0xFFFF and we have a carry, we have
+  // to carry the all the way up to hi.
+  md = vsubq_u16(md, overflow_mask);
+  carry = vceqq_u16(md, zero);
+  carry = vandq_u16(carry, overflow_mask);
+  hi = vsubq_u16(hi, carry);
+
+  // Accumulate the middle portion.
+  overflow_mask = vqaddq_u16(*acc_md, md);
+  *acc_md = vaddq_u16(*acc_md, md);
+
+  overflow_mask = vceqq_u16(*acc_md, overflow_mask);
+  overflow_mask = vceqq_u16(overflow_mask, zero);
+
+  // Finish up the accumulation of the... accumulator.
+  *acc_hi = vaddq_u16(*acc_hi, hi);
+  *acc_hi = vsubq_u16(*acc_hi, overflow_mask);
+
+  // VMACU
+  if (iw & 0x1) {
+    overflow_hi_mask = rsp_u16(vshrq_n_s16(rsp_s16(*acc_hi), 15));
+    overflow_md_mask = rsp_u16(vshrq_n_s16(rsp_s16(*acc_md), 15));
+    md = vorrq_u16(overflow_md_mask, *acc_md);
+    overflow_mask = vcgtq_s16(rsp_s16(*acc_hi), rsp_s16(zero));
+    md = vbicq_u16(md, overflow_hi_mask);
+    return vorrq_u16(overflow_mask, md);
+  }
+
+  // VMACF
+  else
+    return rsp_sclamp_acc_tomd(*acc_md, *acc_hi);
+}
+
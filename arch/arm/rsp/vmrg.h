@@ -0,0 +1,14 @@
+//
+// arch/arm/rsp/vmrg.h
+//
+// This file is subject to the terms and conditions defined in
+// 'LICENSE', which is part of this source code package.
+//
+
+#include "common.h"
+
+static inline uint16x8_t rsp_vmrg(uint16x8_t vs, uint16x8_t vt,
+  uint16x8_t le) {
+  return vbslq_u16(le, vs, vt);
+}
+
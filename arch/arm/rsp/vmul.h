@@ -0,0 +1,42 @@
+//
+// arch/arm/rsp/vmul.h
+//
+// This file is subject to the terms and conditions defined in
+// 'LICENSE', which is part of this source code package.
+//
+
+static inline uint16x8_t rsp_vmulf_vmulu(uint32_t iw, uint16x8_t vs,
+  uint16x8_t vt, uint16x8_t zero, uint16x8_t *acc_lo, uint16x8_t *acc_md,
+  uint16x8_t *acc_hi) {
+  uint16x8_t lo, hi, round, sign1, sign2, eq, neq, neg;
+
+  lo = vmulq_u16(vs, vt);
+  round = vdupq_n_u16(0x8000);
+  sign1 = vshrq_n_u16(lo, 15);
+  lo = vaddq_u16(lo, lo);
+  hi = rsp_mulhi_s16(vs, vt);
+  sign2 = vshrq_n_u16(lo, 15);
+  *acc_lo = vaddq_u16(round, lo);
+  sign1 = vaddq_u16(sign1, sign2);
+
+  hi = vshlq_n_u16(hi, 1);
+  neq = eq = vceqq_u16(vs, vt);
+  *acc_md = vaddq_u16(hi, sign1);
+
+  neg = rsp_u16(vshrq_n_s16(rsp_s16(*acc_md), 15));
+
+  // VMULU
+  if (iw & 0x1) {
+    *acc_hi = vbicq_u16(neg, eq);
+    hi = vorrq_u16(*acc_md, neg);
+    return vbicq_u16(hi, *acc_hi);
+  }
+
+  // VMULF
+  else {
+    eq = vandq_u16(eq, neg);
+    *acc_hi = vbicq_u16(neg, neq);
+    return vaddq_u16(*acc_md, eq);
+  }
+}
+
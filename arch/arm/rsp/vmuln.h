@@ -0,0 +1,65 @@
+//
+// arch/arm/rsp/vmuln.h
+//
+// This file is subject to the terms and conditions defined in
+// 'LICENSE', which is part of this source code package.
+//
+
+static inline uint16x8_t rsp_vmadn_vmudn(uint32_t iw, uint16x8_t vs,
+  uint16x8_t vt, uint16x8_t zero, uint16x8_t *acc_lo, uint16x8_t *acc_md,
+  uint16x8_t *acc_hi) {
+  uint16x8_t lo, hi, sign, overflow_mask;
+
+  lo = vmulq_u16(vs, vt);
+  hi = rsp_mulhi_u16(vs, vt);
+
+  // What we're really want to do is unsigned vs * signed vt.
+  // However, we have no such instructions to do so.
+  //
+  // There's a trick to "fix" an unsigned product, though:
+  // If vt was negative, take the upper 16-bits of the product
+  // and subtract vs.
+  sign = rsp_u16(vshrq_n_s16(rsp_s16(vt), 15));
+  vs = vandq_u16(vs, sign);
+  hi = vsubq_u16(hi, vs);
+
+  // VMADN
+  if (iw & 0x8) {
+    // Tricky part: start accumulate everything.
+    // Get/keep the carry as we'll add it in later.
+    overflow_mask = vqaddq_u16(*acc_lo, lo);
+    *acc_lo = vaddq_u16(*acc_lo, lo);
+
+    overflow_mask = vceqq_u16(*acc_lo, overflow_mask);
+    overflow_mask = vceqq_u16(overflow_mask, zero);
+
+    // This is REALLY clever. Since the product results from
+    // two 16-bit components, one positive and one negative,
+    // we don't have to worry about carrying the 1 (we can
+    // only borrow) past 32-bits. So we can just add it here.
+    hi = vsubq_u16(hi, overflow_mask);
+
+    // Check for overflow of the upper sum.
+    overflow_mask = vqaddq_u16(*acc_md, hi);
+    *acc_md = vaddq_u16(*acc_md, hi);
+
+    overflow_mask = vceqq_u16(*acc_md, overflow_mask);
+    overflow_mask = vceqq_u16(overflow_mask, zero);
+
+    // Finish up the accumulation of the... accumulator.
+    *acc_hi = vaddq_u16(*acc_hi, rsp_u16(vshrq_n_s16(rsp_s16(hi), 15)));
+    *acc_hi = vsubq_u16(*acc_hi, overflow_mask);
+
+    return rsp_uclamp_acc(*acc_lo, *acc_md, *acc_hi, zero);
+  }
+
+  // VMUDN
+  else {
+    *acc_lo = lo;
+    *acc_md = hi;
+    *acc_hi = rsp_u16(vshrq_n_s16(rsp_s16(hi), 15));
+
+    return lo;
+  }
+}
+
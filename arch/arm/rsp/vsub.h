@@ -0,0 +1,27 @@
+//
+// arch/arm/rsp/vsub.h
+//
+// This file is subject to the terms and conditions defined in
+// 'LICENSE', which is part of this source code package.
+//
+
+#include "common.h"
+
+static inline uint16x8_t rsp_vsub(uint16x8_t vs, uint16x8_t vt,
+  uint16x8_t carry, uint16x8_t *acc_lo) {
+  int16x8_t unsat_diff, sat_diff, vd;
+  uint16x8_t overflow;
+
+  // acc_lo uses saturated arithmetic.
+  unsat_diff = vsubq_s16(rsp_s16(vt), rsp_s16(carry));
+  sat_diff = vqsubq_s16(rsp_s16(vt), rsp_s16(carry));
+
+  *acc_lo = vsubq_u16(vs, rsp_u16(unsat_diff));
+  vd = vqsubq_s16(rsp_s16(vs), sat_diff);
+
+  // VD is the signed diff of the two sources and the carry. Since we
+  // have to saturate the diff of all three, we have to be clever.
+  overflow = vcgtq_s16(sat_diff, unsat_diff);
+  return rsp_u16(vqaddq_s16(vd, rsp_s16(overflow)));
+}
+
@@ -0,0 +1,23 @@
+//
+// arch/arm/rsp/vsubc.h
+//
+// This file is subject to the terms and conditions defined in
+// 'LICENSE', which is part of this source code package.
+//
+
+#include "common.h"
+
+static inline uint16x8_t rsp_vsubc(uint16x8_t vs, uint16x8_t vt,
+  uint16x8_t zero, uint16x8_t *eq, uint16x8_t *sn) {
+  uint16x8_t equal, sat_udiff, sat_udiff_zero;
+
+  sat_udiff = vqsubq_u16(vs, vt);
+  equal = vceqq_u16(vs, vt);
+  sat_udiff_zero = vceqq_u16(sat_udiff, zero);
+
+  *eq = vceqq_u16(equal, zero);
+  *sn = vbicq_u16(sat_udiff_zero, equal);
+
+  return vsubq_u16(vs, vt);
+}
+
@@ -15,6 +15,14 @@ typedef uint32_t fpu_state_t;
 
 #define FPU_MASK_EXCPS    0x1F80
 
+// Sticky exception flags; set by the host, cleared only by us.
+#define FPU_EXCPS           0x003F
+#define FPU_EXCP_INVALID    0x0001
+#define FPU_EXCP_DIVBYZERO  0x0004
+#define FPU_EXCP_OVERFLOW   0x0008
+#define FPU_EXCP_UNDERFLOW  0x0010
+#define FPU_EXCP_INEXACT    0x0020
+
 #define FPU_ROUND_MASK    0x6000
 #define FPU_ROUND_NEAREST 0x0000
 #define FPU_ROUND_NEGINF  0x2000
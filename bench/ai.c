@@ -0,0 +1,77 @@
+//
+// bench/ai.c: Audio interface microbenchmarks.
+//
+// CEN64: Cycle-Accurate Nintendo 64 Emulator.
+// Copyright (C) 2015, Tyler J. Stachecki.
+//
+// This file is subject to the terms and conditions defined in
+// 'LICENSE', which is part of this source code package.
+//
+
+#include "common.h"
+#include "ai/controller.h"
+#include "bench/bench.h"
+
+// One NTSC field's worth of 44.1kHz stereo samples, rounded up.
+#define BENCH_AI_BUFFER_LEN 0x1000
+
+static cen64_align(uint8_t input[BENCH_AI_BUFFER_LEN + 16], 16);
+static cen64_align(uint8_t output[BENCH_AI_BUFFER_LEN + 16], 16);
+
+static int bench_ai_init(void);
+
+static uint64_t bench_byteswap(unsigned long count);
+static uint64_t bench_byteswap_unaligned(unsigned long count);
+
+static const struct bench_case bench_ai_cases[] = {
+  {"byteswap_audio_buffer", bench_byteswap},
+  {"byteswap_audio_buffer_unaligned", bench_byteswap_unaligned},
+  {NULL, NULL}
+};
+
+const struct bench_suite bench_ai_suite = {
+  "ai", bench_ai_init, NULL, bench_ai_cases
+};
+
+// Fills the input buffer with random samples.
+int bench_ai_init(void) {
+  unsigned i;
+
+  bench_srand(BENCH_SEED);
+
+  for (i = 0; i < sizeof(input); i++)
+    input[i] = (uint8_t) bench_rand();
+
+  return 0;
+}
+
+// Byteswaps a 16-byte aligned buffer.
+uint64_t bench_byteswap(unsigned long count) {
+  uint64_t sum = 0;
+  unsigned long i;
+
+  for (i = 0; i < count; i++) {
+    const uint8_t *buf = byteswap_audio_buffer(input,
+      output, BENCH_AI_BUFFER_LEN);
+
+    sum += buf[i & (BENCH_AI_BUFFER_LEN - 1)];
+  }
+
+  return sum;
+}
+
+// Byteswaps a buffer that's only 8-byte aligned (the DMA minimum).
+uint64_t bench_byteswap_unaligned(unsigned long count) {
+  uint64_t sum = 0;
+  unsigned long i;
+
+  for (i = 0; i < count; i++) {
+    const uint8_t *buf = byteswap_audio_buffer(input + 8,
+      output, BENCH_AI_BUFFER_LEN);
+
+    sum += buf[i & (BENCH_AI_BUFFER_LEN - 1)];
+  }
+
+  return sum;
+}
+
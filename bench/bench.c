@@ -0,0 +1,253 @@
+//
+// bench/bench.c: Microbenchmark harness.
+//
+// CEN64: Cycle-Accurate Nintendo 64 Emulator.
+// Copyright (C) 2015, Tyler J. Stachecki.
+//
+// This file is subject to the terms and conditions defined in
+// 'LICENSE', which is part of this source code package.
+//
+
+#include "common.h"
+#include "bench/bench.h"
+#include "timer.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BENCH_DEFAULT_MIN_MS 200
+#define BENCH_MAX_BASELINE 256
+#define BENCH_REPETITIONS 5
+#define BENCH_CHECKSUM_COUNT 64
+
+struct bench_result {
+  char name[64];
+  double ns_per_op;
+};
+
+static const struct bench_suite *bench_suites[] = {
+  &bench_ai_suite,
+  &bench_cpu_suite,
+  &bench_rdp_suite,
+#ifdef __SSE2__
+  &bench_rsp_suite,
+#endif
+};
+
+static uint64_t bench_state = BENCH_SEED;
+static volatile uint64_t bench_sink;
+
+static int bench_checksum(const struct bench_suite *suite,
+  const struct bench_case *bench_case, uint64_t *checksum);
+static double bench_measure(const struct bench_case *bench_case,
+  unsigned long min_ns);
+static const struct bench_result *bench_find(
+  const struct bench_result *results, unsigned count, const char *name);
+static unsigned bench_load(const char *path,
+  struct bench_result *results, unsigned max_results);
+static void print_usage(const char *argv0);
+
+// Reseeds the fixture PRNG.
+void bench_srand(uint64_t seed) {
+  bench_state = seed ? seed : BENCH_SEED;
+}
+
+// Returns the next value from a xorshift64* sequence.
+uint64_t bench_rand(void) {
+  bench_state ^= bench_state >> 12;
+  bench_state ^= bench_state << 25;
+  bench_state ^= bench_state >> 27;
+  return bench_state * 0x2545F4914F6CDD1DULL;
+}
+
+// Looks up a result by name.
+const struct bench_result *bench_find(
+  const struct bench_result *results, unsigned count, const char *name) {
+  unsigned i;
+
+  for (i = 0; i < count; i++) {
+    if (!strcmp(results[i].name, name))
+      return results + i;
+  }
+
+  return NULL;
+}
+
+// Loads "name ns_per_op" lines written by -save.
+unsigned bench_load(const char *path,
+  struct bench_result *results, unsigned max_results) {
+  unsigned count = 0;
+  char line[128];
+  FILE *f;
+
+  if ((f = fopen(path, "r")) == NULL)
+    return 0;
+
+  while (count < max_results && fgets(line, sizeof(line), f)) {
+    if (line[0] == '#')
+      continue;
+
+    if (sscanf(line, "%63s %lf", results[count].name,
+      &results[count].ns_per_op) == 2)
+      count++;
+  }
+
+  fclose(f);
+  return count;
+}
+
+// Runs a case a fixed number of times on a freshly built fixture, so
+// the checksum depends neither on host speed nor on earlier cases.
+int bench_checksum(const struct bench_suite *suite,
+  const struct bench_case *bench_case, uint64_t *checksum) {
+  if (suite->destroy)
+    suite->destroy();
+
+  if (suite->init && suite->init())
+    return 1;
+
+  bench_srand(BENCH_SEED);
+  *checksum = bench_case->run(BENCH_CHECKSUM_COUNT);
+  return 0;
+}
+
+// Grows the iteration count until a run takes at least min_ns, then
+// returns the fastest of several runs at that count in ns/op. Results
+// only feed a sink; the timed counts vary from host to host.
+double bench_measure(const struct bench_case *bench_case,
+  unsigned long min_ns) {
+  unsigned long long elapsed, best;
+  unsigned long count = 1;
+  cen64_time start, end;
+  unsigned i;
+
+  while (1) {
+    bench_srand(BENCH_SEED);
+    get_time(&start);
+    bench_sink ^= bench_case->run(count);
+    get_time(&end);
+
+    if ((elapsed = compute_time_difference(&end, &start)) >= min_ns / 4)
+      break;
+
+    count <<= 1;
+  }
+
+  // Scale the count so a single run hits the target.
+  if (elapsed < min_ns)
+    count = (unsigned long) ((double) count * min_ns / (elapsed ? elapsed : 1));
+
+  for (i = 0, best = ~0ULL; i < BENCH_REPETITIONS; i++) {
+    bench_srand(BENCH_SEED);
+    get_time(&start);
+    bench_sink ^= bench_case->run(count);
+    get_time(&end);
+
+    if ((elapsed = compute_time_difference(&end, &start)) < best)
+      best = elapsed;
+  }
+
+  return (double) best / count;
+}
+
+// Prints the command line usage.
+void print_usage(const char *argv0) {
+  printf("%s [Options]\n\n"
+    "Options:\n"
+      "  -baseline <file>           : Compare against results saved with -save.\n"
+      "  -filter <substring>        : Only run benchmarks whose name matches.\n"
+      "  -min-time <ms>             : Target duration of each timed run.\n"
+      "  -save <file>               : Write results (name ns/op) to a file.\n",
+    argv0);
+}
+
+// Runs every benchmark, optionally comparing against a baseline.
+int main(int argc, const char *argv[]) {
+  static struct bench_result baseline[BENCH_MAX_BASELINE];
+  const char *baseline_path = NULL, *save_path = NULL, *filter = NULL;
+  unsigned long min_ns = BENCH_DEFAULT_MIN_MS * 1000000UL;
+  unsigned num_baseline = 0, i;
+  FILE *save = NULL;
+  int status = 0;
+
+  for (i = 1; i < (unsigned) argc; i++) {
+    if (!strcmp(argv[i], "-baseline") && i + 1 < (unsigned) argc)
+      baseline_path = argv[++i];
+
+    else if (!strcmp(argv[i], "-filter") && i + 1 < (unsigned) argc)
+      filter = argv[++i];
+
+    else if (!strcmp(argv[i], "-min-time") && i + 1 < (unsigned) argc)
+      min_ns = strtoul(argv[++i], NULL, 10) * 1000000UL;
+
+    else if (!strcmp(argv[i], "-save") && i + 1 < (unsigned) argc)
+      save_path = argv[++i];
+
+    else {
+      print_usage(argv[0]);
+      return 1;
+    }
+  }
+
+  if (baseline_path && (num_baseline = bench_load(
+    baseline_path, baseline, BENCH_MAX_BASELINE)) == 0) {
+    printf("Failed to load baseline: %s.\n", baseline_path);
+    return 1;
+  }
+
+  if (save_path && (save = fopen(save_path, "w")) == NULL) {
+    printf("Failed to open %s for writing.\n", save_path);
+    return 1;
+  }
+
+  printf("%-32s %12s %18s %10s\n", "benchmark", "ns/op", "checksum",
+    num_baseline ? "vs. base" : "");
+
+  for (i = 0; i < sizeof(bench_suites) / sizeof(*bench_suites); i++) {
+    const struct bench_suite *suite = bench_suites[i];
+    const struct bench_case *bench_case;
+
+    if (suite->init && suite->init()) {
+      printf("%-32s %12s\n", suite->name, "(skipped)");
+      status = 1;
+      continue;
+    }
+
+    for (bench_case = suite->cases; bench_case->name; bench_case++) {
+      const struct bench_result *base;
+      uint64_t checksum;
+      double ns;
+
+      if (filter && !strstr(bench_case->name, filter))
+        continue;
+
+      if (bench_checksum(suite, bench_case, &checksum)) {
+        printf("%-32s %12s\n", bench_case->name, "(skipped)");
+        status = 1;
+        break;
+      }
+
+      ns = bench_measure(bench_case, min_ns);
+      printf("%-32s %12.2f %18.16llX", bench_case->name,
+        ns, (unsigned long long) checksum);
+
+      if ((base = bench_find(baseline, num_baseline, bench_case->name)))
+        printf(" %+9.1f%%", (ns - base->ns_per_op) * 100.0 / base->ns_per_op);
+
+      printf("\n");
+      fflush(stdout);
+
+      if (save)
+        fprintf(save, "%s %.3f\n", bench_case->name, ns);
+    }
+
+    if (suite->destroy)
+      suite->destroy();
+  }
+
+  if (save)
+    fclose(save);
+
+  return status;
+}
+
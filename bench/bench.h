@@ -0,0 +1,44 @@
+//
+// bench/bench.h: Microbenchmark harness.
+//
+// CEN64: Cycle-Accurate Nintendo 64 Emulator.
+// Copyright (C) 2015, Tyler J. Stachecki.
+//
+// This file is subject to the terms and conditions defined in
+// 'LICENSE', which is part of this source code package.
+//
+
+#ifndef __bench_bench_h__
+#define __bench_bench_h__
+#include "common.h"
+
+#define BENCH_SEED 0x2545F4914F6CDD1DULL
+
+struct bench_case {
+  const char *name;
+
+  // Runs the kernel count times, returning a checksum of the results
+  // so the compiler can't discard the work being measured.
+  uint64_t (*run)(unsigned long count);
+};
+
+struct bench_suite {
+  const char *name;
+
+  // Builds any fixtures; a nonzero return skips the suite.
+  int (*init)(void);
+  void (*destroy)(void);
+
+  const struct bench_case *cases;
+};
+
+extern const struct bench_suite bench_ai_suite;
+extern const struct bench_suite bench_cpu_suite;
+extern const struct bench_suite bench_rdp_suite;
+extern const struct bench_suite bench_rsp_suite;
+
+void bench_srand(uint64_t seed);
+uint64_t bench_rand(void);
+
+#endif
+
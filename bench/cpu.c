@@ -0,0 +1,173 @@
+//
+// bench/cpu.c: VR4300 and bus microbenchmarks.
+//
+// CEN64: Cycle-Accurate Nintendo 64 Emulator.
+// Copyright (C) 2015, Tyler J. Stachecki.
+//
+// This file is subject to the terms and conditions defined in
+// 'LICENSE', which is part of this source code package.
+//
+
+#include "common.h"
+#include "bench/bench.h"
+#include "bus/controller.h"
+#include "bus/memorymap.h"
+#include "tlb/tlb.h"
+#include "vr4300/decoder.h"
+
+#define BENCH_CPU_SAMPLES 4096
+
+struct bench_cpu_fixture {
+  struct cen64_tlb tlb;
+  struct bus_controller bus;
+
+  uint64_t tlb_vaddrs[BENCH_CPU_SAMPLES];
+  uint8_t tlb_asids[BENCH_CPU_SAMPLES];
+
+  uint32_t bus_addresses[BENCH_CPU_SAMPLES];
+  uint32_t instructions[BENCH_CPU_SAMPLES];
+};
+
+static struct bench_cpu_fixture *fixture;
+
+static int bench_cpu_init(void);
+static void bench_cpu_destroy(void);
+
+static uint64_t bench_decode(unsigned long count);
+static uint64_t bench_resolve_mapped_address(unsigned long count);
+static uint64_t bench_tlb_probe(unsigned long count);
+
+static const struct bench_case bench_cpu_cases[] = {
+  {"vr4300_decode_instruction", bench_decode},
+  {"resolve_mapped_address", bench_resolve_mapped_address},
+  {"tlb_probe", bench_tlb_probe},
+  {NULL, NULL}
+};
+
+const struct bench_suite bench_cpu_suite = {
+  "cpu", bench_cpu_init, bench_cpu_destroy, bench_cpu_cases
+};
+
+// Fills the TLB and builds the address and instruction streams.
+int bench_cpu_init(void) {
+  uint64_t vpn2[32];
+  uint8_t asid[32];
+  unsigned i, num_hits, num_mappings;
+
+  if ((fixture = calloc(1, sizeof(*fixture))) == NULL)
+    return 1;
+
+  bench_srand(BENCH_SEED);
+  tlb_init(&fixture->tlb);
+
+  // 4kB pages at random kuseg VPN2s; every fourth entry is global.
+  for (i = 0; i < 32; i++) {
+    uint64_t global = (i & 0x3) == 0;
+
+    vpn2[i] = (bench_rand() & 0x7FFFE000ULL);
+    asid[i] = (uint8_t) bench_rand();
+
+    tlb_write(&fixture->tlb, i, vpn2[i] | asid[i],
+      0x2 | global, 0x2 | global, 0);
+  }
+
+  // Three quarters of probes hit, the rest miss.
+  for (i = 0, num_hits = 0; i < BENCH_CPU_SAMPLES; i++) {
+    uint64_t r = bench_rand();
+    unsigned entry = r & 0x1F;
+
+    if ((r >> 5) & 0x3) {
+      fixture->tlb_vaddrs[i] = vpn2[entry] | ((r >> 8) & 0x1FFF);
+      fixture->tlb_asids[i] = asid[entry];
+      num_hits++;
+    }
+
+    else {
+      fixture->tlb_vaddrs[i] = (r >> 16) & 0x7FFFFFFFULL;
+      fixture->tlb_asids[i] = (uint8_t) (r >> 48);
+    }
+  }
+
+  // Make sure the probes really take the path we think they do.
+  for (i = 0; i < BENCH_CPU_SAMPLES; i++) {
+    unsigned index;
+
+    num_hits -= !tlb_probe(&fixture->tlb, fixture->tlb_vaddrs[i],
+      fixture->tlb_asids[i], &index);
+  }
+
+  if (num_hits != 0) {
+    printf("tlb_probe: hit count is off by %d.\n", (int) num_hits);
+
+    return 1;
+  }
+
+  if (bus_init(&fixture->bus, 0))
+    return 1;
+
+  // Pick addresses uniformly across the mapped regions.
+  num_mappings = fixture->bus.map.next_map_index;
+
+  for (i = 0; i < BENCH_CPU_SAMPLES; i++) {
+    const struct memory_mapping *mapping;
+    uint64_t r = bench_rand();
+
+    mapping = &fixture->bus.map.mappings[1 + r % (num_mappings - 1)].mapping;
+    fixture->bus_addresses[i] = mapping->start +
+      ((uint32_t) (r >> 32) % mapping->length & ~0x3U);
+  }
+
+  for (i = 0; i < BENCH_CPU_SAMPLES; i++)
+    fixture->instructions[i] = (uint32_t) bench_rand();
+
+  return 0;
+}
+
+// Releases the fixture.
+void bench_cpu_destroy(void) {
+  free(fixture);
+  fixture = NULL;
+}
+
+// Decodes a stream of random instruction words.
+uint64_t bench_decode(unsigned long count) {
+  uint64_t sum = 0;
+  unsigned long i;
+
+  for (i = 0; i < count; i++) {
+    uint32_t iw = fixture->instructions[i & (BENCH_CPU_SAMPLES - 1)];
+    sum += vr4300_decode_instruction(iw)->id;
+  }
+
+  return sum;
+}
+
+// Resolves addresses spread across the physical memory map.
+uint64_t bench_resolve_mapped_address(unsigned long count) {
+  uint64_t sum = 0;
+  unsigned long i;
+
+  for (i = 0; i < count; i++) {
+    uint32_t address = fixture->bus_addresses[i & (BENCH_CPU_SAMPLES - 1)];
+    sum += resolve_mapped_address(&fixture->bus.map, address)->start;
+  }
+
+  return sum;
+}
+
+// Probes the TLB with a mix of hits and misses.
+uint64_t bench_tlb_probe(unsigned long count) {
+  uint64_t sum = 0;
+  unsigned long i;
+
+  for (i = 0; i < count; i++) {
+    unsigned j = i & (BENCH_CPU_SAMPLES - 1);
+    unsigned index = 0;
+
+    sum += tlb_probe(&fixture->tlb, fixture->tlb_vaddrs[j],
+      fixture->tlb_asids[j], &index) + index;
+  }
+
+  return sum;
+}
+
@@ -0,0 +1,282 @@
+//
+// bench/neon/arm_neon.h: Scalar model of the NEON intrinsics.
+//
+// CEN64: Cycle-Accurate Nintendo 64 Emulator.
+// Copyright (C) 2015, Tyler J. Stachecki.
+//
+// This file is subject to the terms and conditions defined in
+// 'LICENSE', which is part of this source code package.
+//
+
+//
+// Lets cen64-rsp-check build arch/arm/rsp on a host without NEON.
+// Only the intrinsics arch/arm uses are modelled. Each vector type is
+// a distinct struct so that a missing vreinterpret still fails to
+// compile, like it does on a real ARM toolchain. This only stands in
+// for NEON; a misreading of an intrinsic made both here and in
+// arch/arm goes unnoticed until the check runs on an ARM host.
+//
+
+#ifndef __bench_neon_arm_neon_h__
+#define __bench_neon_arm_neon_h__
+#include <stdint.h>
+#include <string.h>
+
+#define NEON_TYPE(name, type, lanes) \
+  typedef struct { type v[lanes]; } name;
+
+NEON_TYPE(int8x8_t, int8_t, 8)
+NEON_TYPE(uint8x8_t, uint8_t, 8)
+NEON_TYPE(uint8x16_t, uint8_t, 16)
+NEON_TYPE(int16x4_t, int16_t, 4)
+NEON_TYPE(int16x8_t, int16_t, 8)
+NEON_TYPE(uint16x4_t, uint16_t, 4)
+NEON_TYPE(uint16x8_t, uint16_t, 8)
+NEON_TYPE(int32x4_t, int32_t, 4)
+NEON_TYPE(uint32x4_t, uint32_t, 4)
+NEON_TYPE(uint64x2_t, uint64_t, 2)
+
+typedef struct { uint8x8_t val[2]; } uint8x8x2_t;
+typedef struct { uint16x8_t val[2]; } uint16x8x2_t;
+
+static inline int16_t neon_sat_s16(int32_t x) {
+  return x > 32767 ? 32767 : x < -32768 ? -32768 : x;
+}
+
+static inline uint16_t neon_sat_u16(int32_t x) {
+  return x > 65535 ? 65535 : x < 0 ? 0 : x;
+}
+
+// Lane-wise binary operations.
+#define NEON_BINARY(name, type, lanes, expr) \
+  static inline type name(type a, type b) { \
+    unsigned i; type r; \
+    for (i = 0; i < lanes; i++) r.v[i] = (expr); \
+    return r; \
+  }
+
+NEON_BINARY(vaddq_u16, uint16x8_t, 8, a.v[i] + b.v[i])
+NEON_BINARY(vsubq_u16, uint16x8_t, 8, a.v[i] - b.v[i])
+NEON_BINARY(vsubq_s16, int16x8_t, 8, (int16_t) (a.v[i] - b.v[i]))
+NEON_BINARY(vmulq_u16, uint16x8_t, 8, (uint16_t) (a.v[i] * b.v[i]))
+NEON_BINARY(vandq_u16, uint16x8_t, 8, a.v[i] & b.v[i])
+NEON_BINARY(vbicq_u16, uint16x8_t, 8, a.v[i] & ~b.v[i])
+NEON_BINARY(vorrq_u16, uint16x8_t, 8, a.v[i] | b.v[i])
+NEON_BINARY(veorq_u16, uint16x8_t, 8, a.v[i] ^ b.v[i])
+NEON_BINARY(vmaxq_s16, int16x8_t, 8, a.v[i] > b.v[i] ? a.v[i] : b.v[i])
+NEON_BINARY(vminq_s16, int16x8_t, 8, a.v[i] < b.v[i] ? a.v[i] : b.v[i])
+NEON_BINARY(vqaddq_s16, int16x8_t, 8, neon_sat_s16(a.v[i] + b.v[i]))
+NEON_BINARY(vqsubq_s16, int16x8_t, 8, neon_sat_s16(a.v[i] - b.v[i]))
+NEON_BINARY(vqaddq_u16, uint16x8_t, 8, neon_sat_u16(a.v[i] + b.v[i]))
+NEON_BINARY(vqsubq_u16, uint16x8_t, 8, neon_sat_u16(a.v[i] - b.v[i]))
+
+// Lane-wise comparisons; true lanes are all ones.
+#define NEON_COMPARE(name, type, rtype, lanes, op, ones) \
+  static inline rtype name(type a, type b) { \
+    unsigned i; rtype r; \
+    for (i = 0; i < lanes; i++) r.v[i] = a.v[i] op b.v[i] ? ones : 0; \
+    return r; \
+  }
+
+NEON_COMPARE(vceqq_u8, uint8x16_t, uint8x16_t, 16, ==, 0xFF)
+NEON_COMPARE(vceqq_u16, uint16x8_t, uint16x8_t, 8, ==, 0xFFFF)
+NEON_COMPARE(vcgtq_s16, int16x8_t, uint16x8_t, 8, >, 0xFFFF)
+NEON_COMPARE(vcltq_s16, int16x8_t, uint16x8_t, 8, <, 0xFFFF)
+
+// Bitwise selects: bits set in the mask come from a, the rest from b.
+#define NEON_SELECT(name, type, lanes) \
+  static inline type name(type m, type a, type b) { \
+    unsigned i; type r; \
+    for (i = 0; i < lanes; i++) r.v[i] = (m.v[i] & a.v[i]) | (~m.v[i] & b.v[i]); \
+    return r; \
+  }
+
+NEON_SELECT(vbsl_u8, uint8x8_t, 8)
+NEON_SELECT(vbslq_u8, uint8x16_t, 16)
+NEON_SELECT(vbslq_u16, uint16x8_t, 8)
+
+// Splits and joins of 64-bit halves.
+#define NEON_HALVES(low, high, combine, type, htype, lanes) \
+  static inline htype low(type a) { \
+    unsigned i; htype r; \
+    for (i = 0; i < lanes; i++) r.v[i] = a.v[i]; \
+    return r; \
+  } \
+  static inline htype high(type a) { \
+    unsigned i; htype r; \
+    for (i = 0; i < lanes; i++) r.v[i] = a.v[i + lanes]; \
+    return r; \
+  } \
+  static inline type combine(htype a, htype b) { \
+    unsigned i; type r; \
+    for (i = 0; i < lanes; i++) { r.v[i] = a.v[i]; r.v[i + lanes] = b.v[i]; } \
+    return r; \
+  }
+
+NEON_HALVES(vget_low_u8, vget_high_u8, vcombine_u8, uint8x16_t, uint8x8_t, 8)
+NEON_HALVES(vget_low_s16, vget_high_s16, vcombine_s16, int16x8_t, int16x4_t, 4)
+NEON_HALVES(vget_low_u16, vget_high_u16, vcombine_u16, uint16x8_t, uint16x4_t, 4)
+
+// Broadcasts.
+#define NEON_DUP(name, type, etype, lanes) \
+  static inline type name(etype x) { \
+    unsigned i; type r; \
+    for (i = 0; i < lanes; i++) r.v[i] = x; \
+    return r; \
+  }
+
+NEON_DUP(vdup_n_u8, uint8x8_t, uint8_t, 8)
+NEON_DUP(vdupq_n_u8, uint8x16_t, uint8_t, 16)
+NEON_DUP(vdupq_n_u16, uint16x8_t, uint16_t, 8)
+
+static inline uint8x8_t vcreate_u8(uint64_t x) {
+  unsigned i; uint8x8_t r;
+  for (i = 0; i < 8; i++) r.v[i] = x >> (8 * i);
+  return r;
+}
+
+#define vgetq_lane_u64(a, lane) ((a).v[lane])
+
+// Loads and stores.
+#define NEON_LOAD(name, type, etype) \
+  static inline type name(const etype *p) { \
+    type r; memcpy(r.v, p, sizeof(r.v)); return r; \
+  }
+
+#define NEON_STORE(name, type, etype) \
+  static inline void name(etype *p, type a) { \
+    memcpy(p, a.v, sizeof(a.v)); \
+  }
+
+NEON_LOAD(vld1_u8, uint8x8_t, uint8_t)
+NEON_LOAD(vld1q_u8, uint8x16_t, uint8_t)
+NEON_LOAD(vld1q_s16, int16x8_t, int16_t)
+NEON_LOAD(vld1q_u16, uint16x8_t, uint16_t)
+NEON_STORE(vst1_s8, int8x8_t, int8_t)
+NEON_STORE(vst1_u8, uint8x8_t, uint8_t)
+NEON_STORE(vst1q_u8, uint8x16_t, uint8_t)
+NEON_STORE(vst1q_u16, uint16x8_t, uint16_t)
+
+static inline uint8x8x2_t vld2_u8(const uint8_t *p) {
+  unsigned i; uint8x8x2_t r;
+
+  for (i = 0; i < 8; i++) {
+    r.val[0].v[i] = p[2 * i + 0];
+    r.val[1].v[i] = p[2 * i + 1];
+  }
+
+  return r;
+}
+
+// Widening, narrowing and pairwise operations.
+static inline int32x4_t vmull_s16(int16x4_t a, int16x4_t b) {
+  unsigned i; int32x4_t r;
+  for (i = 0; i < 4; i++) r.v[i] = (int32_t) a.v[i] * b.v[i];
+  return r;
+}
+
+static inline uint32x4_t vmull_u16(uint16x4_t a, uint16x4_t b) {
+  unsigned i; uint32x4_t r;
+  for (i = 0; i < 4; i++) r.v[i] = (uint32_t) a.v[i] * b.v[i];
+  return r;
+}
+
+static inline uint32x4_t vpaddlq_u16(uint16x8_t a) {
+  unsigned i; uint32x4_t r;
+  for (i = 0; i < 4; i++) r.v[i] = (uint32_t) a.v[2 * i] + a.v[2 * i + 1];
+  return r;
+}
+
+static inline uint64x2_t vpaddlq_u32(uint32x4_t a) {
+  unsigned i; uint64x2_t r;
+  for (i = 0; i < 2; i++) r.v[i] = (uint64_t) a.v[2 * i] + a.v[2 * i + 1];
+  return r;
+}
+
+static inline int8x8_t vqmovn_s16(int16x8_t a) {
+  unsigned i; int8x8_t r;
+  for (i = 0; i < 8; i++) r.v[i] = a.v[i] > 127 ? 127 : a.v[i] < -128 ? -128 : a.v[i];
+  return r;
+}
+
+static inline int16x4_t vqmovn_s32(int32x4_t a) {
+  unsigned i; int16x4_t r;
+  for (i = 0; i < 4; i++) r.v[i] = neon_sat_s16(a.v[i]);
+  return r;
+}
+
+// Reinterpreting casts between same-sized vectors.
+#define NEON_REINTERPRET(name, from, to) \
+  static inline to name(from a) { \
+    to r; memcpy(&r, &a, sizeof(r)); return r; \
+  }
+
+NEON_REINTERPRET(vreinterpretq_u8_u16, uint16x8_t, uint8x16_t)
+NEON_REINTERPRET(vreinterpretq_u16_u8, uint8x16_t, uint16x8_t)
+NEON_REINTERPRET(vreinterpretq_s16_u16, uint16x8_t, int16x8_t)
+NEON_REINTERPRET(vreinterpretq_u16_s16, int16x8_t, uint16x8_t)
+NEON_REINTERPRET(vreinterpretq_s32_u16, uint16x8_t, int32x4_t)
+NEON_REINTERPRET(vreinterpretq_u16_s32, int32x4_t, uint16x8_t)
+
+// Shifts by an immediate; the real intrinsics are macros, too.
+#define NEON_SHIFT(name, from, to, lanes, expr) \
+  static inline to name##_model(from a, int n) { \
+    unsigned i; to r; \
+    for (i = 0; i < lanes; i++) r.v[i] = (expr); \
+    return r; \
+  }
+
+NEON_SHIFT(vshll_n_u8, uint8x8_t, uint16x8_t, 8, (uint16_t) (a.v[i] << n))
+NEON_SHIFT(vshlq_n_u16, uint16x8_t, uint16x8_t, 8, (uint16_t) (a.v[i] << n))
+NEON_SHIFT(vshrq_n_u16, uint16x8_t, uint16x8_t, 8, a.v[i] >> n)
+NEON_SHIFT(vshrq_n_s16, int16x8_t, int16x8_t, 8, a.v[i] >> n)
+NEON_SHIFT(vshrn_n_s32, int32x4_t, int16x4_t, 4, (int16_t) (a.v[i] >> n))
+NEON_SHIFT(vshrn_n_u32, uint32x4_t, uint16x4_t, 4, (uint16_t) (a.v[i] >> n))
+
+#define vshll_n_u8(a, n) vshll_n_u8_model(a, n)
+#define vshlq_n_u16(a, n) vshlq_n_u16_model(a, n)
+#define vshrq_n_u16(a, n) vshrq_n_u16_model(a, n)
+#define vshrq_n_s16(a, n) vshrq_n_s16_model(a, n)
+#define vshrn_n_s32(a, n) vshrn_n_s32_model(a, n)
+#define vshrn_n_u32(a, n) vshrn_n_u32_model(a, n)
+
+// Shifts by a signed per-lane count held in the low byte.
+static inline uint16x8_t vshlq_u16(uint16x8_t a, int16x8_t s) {
+  unsigned i; uint16x8_t r;
+
+  for (i = 0; i < 8; i++) {
+    int n = (int8_t) s.v[i];
+
+    if (n >= 16 || n <= -16)
+      r.v[i] = 0;
+    else
+      r.v[i] = n >= 0 ? (uint16_t) (a.v[i] << n) : a.v[i] >> -n;
+  }
+
+  return r;
+}
+
+// Table lookups; out of range indices yield zero.
+static inline uint8x8_t vtbl2_u8(uint8x8x2_t t, uint8x8_t idx) {
+  unsigned i; uint8x8_t r;
+
+  for (i = 0; i < 8; i++) {
+    unsigned x = idx.v[i];
+    r.v[i] = x < 16 ? t.val[x >> 3].v[x & 7] : 0;
+  }
+
+  return r;
+}
+
+static inline uint16x8x2_t vzipq_u16(uint16x8_t a, uint16x8_t b) {
+  unsigned i; uint16x8x2_t r;
+
+  for (i = 0; i < 8; i++) {
+    r.val[i >> 2].v[2 * (i & 3) + 0] = a.v[i];
+    r.val[i >> 2].v[2 * (i & 3) + 1] = b.v[i];
+  }
+
+  return r;
+}
+
+#endif
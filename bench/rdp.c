@@ -0,0 +1,224 @@
+//
+// bench/rdp.c: RDP span renderer microbenchmarks.
+//
+// CEN64: Cycle-Accurate Nintendo 64 Emulator.
+// Copyright (C) 2015, Tyler J. Stachecki.
+//
+// This file is subject to the terms and conditions defined in
+// 'LICENSE', which is part of this source code package.
+//
+
+#include "common.h"
+#include "bench/bench.h"
+#include "device/device.h"
+#include "rdp/cpu.h"
+
+#define BENCH_RDP_FB_ADDRESS 0x100000
+#define BENCH_RDP_TEXTURE_ADDRESS 0x180000
+#define BENCH_RDP_LIST_ADDRESS 0x200000
+#define BENCH_RDP_LIST_STRIDE 0x1000
+
+#define BENCH_RDP_WIDTH 320
+#define BENCH_RDP_HEIGHT 240
+
+enum bench_rdp_list {
+  BENCH_RDP_LIST_SETUP,
+  BENCH_RDP_LIST_FILL,
+  BENCH_RDP_LIST_1CYCLE,
+  BENCH_RDP_LIST_2CYCLE,
+  BENCH_RDP_LIST_COPY,
+  BENCH_RDP_LIST_BILERP,
+  NUM_BENCH_RDP_LISTS
+};
+
+cen64_cold int angrylion_rdp_init(struct cen64_device *device);
+void rdp_process_list(void);
+
+static struct cen64_device *device;
+static uint32_t list_lengths[NUM_BENCH_RDP_LISTS];
+
+static int bench_rdp_init(void);
+static void bench_rdp_destroy(void);
+
+static void bench_rdp_emit(enum bench_rdp_list list, uint32_t word);
+static uint64_t bench_rdp_run(enum bench_rdp_list list, unsigned long count);
+
+static uint64_t bench_copy(unsigned long count);
+static uint64_t bench_fill(unsigned long count);
+static uint64_t bench_1cycle(unsigned long count);
+static uint64_t bench_2cycle(unsigned long count);
+static uint64_t bench_bilerp(unsigned long count);
+static uint64_t bench_bilerp_cached(unsigned long count);
+
+static const struct bench_case bench_rdp_cases[] = {
+  {"rdp_fill_rect_fill_320x240", bench_fill},
+  {"rdp_fill_rect_1cycle_320x240", bench_1cycle},
+  {"rdp_fill_rect_2cycle_320x240", bench_2cycle},
+  {"rdp_tex_rect_copy_320x240", bench_copy},
+  {"rdp_tex_rect_bilerp_320x240", bench_bilerp},
+  {"rdp_tex_rect_cached_320x240", bench_bilerp_cached},
+  {NULL, NULL}
+};
+
+const struct bench_suite bench_rdp_suite = {
+  "rdp", bench_rdp_init, bench_rdp_destroy, bench_rdp_cases
+};
+
+// Appends a word to one of the display lists in RDRAM.
+void bench_rdp_emit(enum bench_rdp_list list, uint32_t word) {
+  uint32_t address = BENCH_RDP_LIST_ADDRESS +
+    list * BENCH_RDP_LIST_STRIDE + list_lengths[list]++ * 4;
+
+  word = ri_host_word(word);
+  memcpy(device->ri.ram + address, &word, sizeof(word));
+}
+
+// Builds a display list for each span renderer.
+int bench_rdp_init(void) {
+  static const uint32_t color_image[2] = {
+    0x3F100000 | (BENCH_RDP_WIDTH - 1), BENCH_RDP_FB_ADDRESS};
+  static const uint32_t scissor[2] = {
+    0x2D000000, (BENCH_RDP_WIDTH << 14) | (BENCH_RDP_HEIGHT << 2)};
+  static const uint32_t fill_rect[2] = {
+    0x36000000 | ((BENCH_RDP_WIDTH - 1) << 14) |
+    ((BENCH_RDP_HEIGHT - 1) << 2), 0x00000000};
+
+  unsigned i, list;
+
+  if ((device = calloc(1, sizeof(*device))) == NULL)
+    return 1;
+
+  if (angrylion_rdp_init(device))
+    return 1;
+
+  bench_srand(BENCH_SEED);
+
+  for (i = 0; i < 0x800; i += 4) {
+    uint32_t word = ri_host_word((uint32_t) bench_rand());
+    memcpy(device->ri.ram + BENCH_RDP_TEXTURE_ADDRESS + i, &word, 4);
+  }
+
+  // Framebuffer, scissor and a 32x32 RGBA16 texture in TMEM.
+  for (i = 0; i < 2; i++)
+    bench_rdp_emit(BENCH_RDP_LIST_SETUP, color_image[i]);
+
+  for (i = 0; i < 2; i++)
+    bench_rdp_emit(BENCH_RDP_LIST_SETUP, scissor[i]);
+
+  bench_rdp_emit(BENCH_RDP_LIST_SETUP, 0x3D100000 | 31);
+  bench_rdp_emit(BENCH_RDP_LIST_SETUP, BENCH_RDP_TEXTURE_ADDRESS);
+  bench_rdp_emit(BENCH_RDP_LIST_SETUP, 0x35100000);
+  bench_rdp_emit(BENCH_RDP_LIST_SETUP, 0x07000000);
+  bench_rdp_emit(BENCH_RDP_LIST_SETUP, 0x33000000);
+  bench_rdp_emit(BENCH_RDP_LIST_SETUP, 0x07000000 | (1023 << 12) | 256);
+  bench_rdp_emit(BENCH_RDP_LIST_SETUP, 0x35100000 | (8 << 9));
+  bench_rdp_emit(BENCH_RDP_LIST_SETUP, (5 << 14) | (5 << 4));
+  bench_rdp_emit(BENCH_RDP_LIST_SETUP, 0x32000000);
+  bench_rdp_emit(BENCH_RDP_LIST_SETUP, (31 << 14) | (31 << 2));
+
+  // Fill mode: the fill colour is two RGBA16 pixels.
+  bench_rdp_emit(BENCH_RDP_LIST_FILL, 0x2F300000);
+  bench_rdp_emit(BENCH_RDP_LIST_FILL, 0x00000000);
+  bench_rdp_emit(BENCH_RDP_LIST_FILL, 0x37000000);
+  bench_rdp_emit(BENCH_RDP_LIST_FILL, 0xF801F801);
+
+  // 1- and 2-cycle modes, with the blender reading the framebuffer.
+  bench_rdp_emit(BENCH_RDP_LIST_1CYCLE, 0x2F000000);
+  bench_rdp_emit(BENCH_RDP_LIST_1CYCLE, 0x00504040);
+  bench_rdp_emit(BENCH_RDP_LIST_2CYCLE, 0x2F100000);
+  bench_rdp_emit(BENCH_RDP_LIST_2CYCLE, 0x00504040);
+
+  for (list = BENCH_RDP_LIST_FILL; list <= BENCH_RDP_LIST_2CYCLE; list++) {
+    for (i = 0; i < 2; i++)
+      bench_rdp_emit(list, fill_rect[i]);
+  }
+
+  // Copy mode: 4 texels/clock out of the tile loaded above.
+  bench_rdp_emit(BENCH_RDP_LIST_COPY, 0x2F200000);
+  bench_rdp_emit(BENCH_RDP_LIST_COPY, 0x00000000);
+  bench_rdp_emit(BENCH_RDP_LIST_COPY, 0x24000000 |
+    ((BENCH_RDP_WIDTH - 1) << 14) | ((BENCH_RDP_HEIGHT - 1) << 2));
+  bench_rdp_emit(BENCH_RDP_LIST_COPY, 0x00000000);
+  bench_rdp_emit(BENCH_RDP_LIST_COPY, 0x00000000);
+  bench_rdp_emit(BENCH_RDP_LIST_COPY, 0x10000400);
+
+  // 1-cycle bilinear filtering of the same tile, combiner passing TEXEL0.
+  bench_rdp_emit(BENCH_RDP_LIST_BILERP, 0x2F002C00);
+  bench_rdp_emit(BENCH_RDP_LIST_BILERP, 0x00000000);
+  bench_rdp_emit(BENCH_RDP_LIST_BILERP, 0x3C000000);
+  bench_rdp_emit(BENCH_RDP_LIST_BILERP, 0x00008241);
+  bench_rdp_emit(BENCH_RDP_LIST_BILERP, 0x24000000 |
+    (BENCH_RDP_WIDTH << 14) | (BENCH_RDP_HEIGHT << 2));
+  bench_rdp_emit(BENCH_RDP_LIST_BILERP, 0x00000000);
+  bench_rdp_emit(BENCH_RDP_LIST_BILERP, 0x00000000);
+  bench_rdp_emit(BENCH_RDP_LIST_BILERP, 0x01550155);
+
+  bench_rdp_run(BENCH_RDP_LIST_SETUP, 1);
+  return 0;
+}
+
+// Releases the fixture.
+void bench_rdp_destroy(void) {
+  free(device);
+  device = NULL;
+}
+
+// Feeds a display list through the RDP count times.
+uint64_t bench_rdp_run(enum bench_rdp_list list, unsigned long count) {
+  uint32_t start = BENCH_RDP_LIST_ADDRESS + list * BENCH_RDP_LIST_STRIDE;
+  uint64_t sum = 0;
+  unsigned long i;
+
+  for (i = 0; i < count; i++) {
+    uint32_t pixel;
+
+    device->rdp.regs[DPC_START_REG] = start;
+    device->rdp.regs[DPC_CURRENT_REG] = start;
+    device->rdp.regs[DPC_END_REG] = start + list_lengths[list] * 4;
+    rdp_process_list();
+
+    pixel = ri_read_word(&device->ri, BENCH_RDP_FB_ADDRESS +
+      ((i * 4) & 0x1FFFC));
+
+    sum += pixel;
+  }
+
+  return sum;
+}
+
+// Fills a full-screen rectangle in copy mode.
+uint64_t bench_copy(unsigned long count) {
+  return bench_rdp_run(BENCH_RDP_LIST_COPY, count);
+}
+
+// Fills a full-screen rectangle in fill mode.
+uint64_t bench_fill(unsigned long count) {
+  return bench_rdp_run(BENCH_RDP_LIST_FILL, count);
+}
+
+// Fills a full-screen rectangle in 1-cycle mode.
+uint64_t bench_1cycle(unsigned long count) {
+  return bench_rdp_run(BENCH_RDP_LIST_1CYCLE, count);
+}
+
+// Fills a full-screen rectangle in 2-cycle mode.
+uint64_t bench_2cycle(unsigned long count) {
+  return bench_rdp_run(BENCH_RDP_LIST_2CYCLE, count);
+}
+
+// Filters a full-screen textured rectangle in 1-cycle mode.
+uint64_t bench_bilerp(unsigned long count) {
+  return bench_rdp_run(BENCH_RDP_LIST_BILERP, count);
+}
+
+// As above, but sampling through the decoded texel cache.
+uint64_t bench_bilerp_cached(unsigned long count) {
+  uint64_t sum;
+
+  device->rdp.texel_cache = true;
+  sum = bench_rdp_run(BENCH_RDP_LIST_BILERP, count);
+  device->rdp.texel_cache = false;
+
+  return sum;
+}
+
@@ -0,0 +1,192 @@
+//
+// bench/rsp.c: RSP vector unit microbenchmarks.
+//
+// CEN64: Cycle-Accurate Nintendo 64 Emulator.
+// Copyright (C) 2015, Tyler J. Stachecki.
+//
+// This file is subject to the terms and conditions defined in
+// 'LICENSE', which is part of this source code package.
+//
+
+#include "common.h"
+#include "bench/bench.h"
+#include "rsp/cp2.h"
+#include "rsp/cpu.h"
+#include "rsp/rsp.h"
+
+#define BENCH_RSP_ELEMENTS 256
+
+static struct rsp *rsp;
+static uint8_t elements[BENCH_RSP_ELEMENTS];
+
+static int bench_rsp_init(void);
+static void bench_rsp_destroy(void);
+static uint64_t bench_rsp_fold(__m128i v);
+
+static uint64_t bench_shuffle(unsigned long count);
+static uint64_t bench_vch(unsigned long count);
+static uint64_t bench_vmacf(unsigned long count);
+static uint64_t bench_vmulf(unsigned long count);
+static uint64_t bench_vrcp(unsigned long count);
+static uint64_t bench_vrsq(unsigned long count);
+
+static const struct bench_case bench_rsp_cases[] = {
+  {"rsp_vect_load_and_shuffle", bench_shuffle},
+  {"rsp_vch", bench_vch},
+  {"rsp_vmacf", bench_vmacf},
+  {"rsp_vmulf", bench_vmulf},
+  {"rsp_vrcp", bench_vrcp},
+  {"rsp_vrsq", bench_vrsq},
+  {NULL, NULL}
+};
+
+const struct bench_suite bench_rsp_suite = {
+  "rsp", bench_rsp_init, bench_rsp_destroy, bench_rsp_cases
+};
+
+// Fills the vector register file with random operands.
+int bench_rsp_init(void) {
+  unsigned i, j;
+
+  if ((rsp = calloc(1, sizeof(*rsp))) == NULL)
+    return 1;
+
+  bench_srand(BENCH_SEED);
+
+  for (i = 0; i < 32; i++) {
+    for (j = 0; j < 8; j++)
+      rsp->cp2.regs[i].e[j] = (uint16_t) bench_rand();
+  }
+
+  for (i = 0; i < BENCH_RSP_ELEMENTS; i++)
+    elements[i] = bench_rand() & 0xF;
+
+  return 0;
+}
+
+// Releases the fixture.
+void bench_rsp_destroy(void) {
+  free(rsp);
+  rsp = NULL;
+}
+
+// Folds a vector down into a checksum.
+uint64_t bench_rsp_fold(__m128i v) {
+  uint64_t halves[2];
+
+  _mm_storeu_si128((__m128i *) halves, v);
+  return halves[0] ^ halves[1];
+}
+
+// Loads operands with a random element selector.
+uint64_t bench_shuffle(unsigned long count) {
+  __m128i sum = _mm_setzero_si128();
+  unsigned long i;
+
+  for (i = 0; i < count; i++) {
+    const uint16_t *src = rsp->cp2.regs[i & 0x1F].e;
+    unsigned e = elements[i & (BENCH_RSP_ELEMENTS - 1)];
+
+    sum = _mm_xor_si128(sum, rsp_vect_load_and_shuffle_operand(src, e));
+  }
+
+  return bench_rsp_fold(sum);
+}
+
+// Runs VCH over random operand pairs.
+uint64_t bench_vch(unsigned long count) {
+  __m128i zero = _mm_setzero_si128();
+  __m128i ge, le, eq, sign, vce;
+  __m128i sum = zero;
+  unsigned long i;
+
+  for (i = 0; i < count; i++) {
+    unsigned e = elements[i & (BENCH_RSP_ELEMENTS - 1)];
+    __m128i vs, vt;
+
+    vs = rsp_vect_load_unshuffled_operand(rsp->cp2.regs[i & 0x1F].e);
+    vt = rsp_vect_load_and_shuffle_operand(
+      rsp->cp2.regs[(i + 7) & 0x1F].e, e);
+
+    sum = _mm_xor_si128(sum, rsp_vch(vs, vt, zero,
+      &ge, &le, &eq, &sign, &vce));
+    sum = _mm_xor_si128(sum, _mm_xor_si128(ge, le));
+  }
+
+  return bench_rsp_fold(sum);
+}
+
+// Runs VMACF, carrying the accumulator between iterations.
+uint64_t bench_vmacf(unsigned long count) {
+  __m128i zero = _mm_setzero_si128();
+  __m128i acc_lo = zero, acc_md = zero, acc_hi = zero;
+  __m128i sum = zero;
+  unsigned long i;
+
+  for (i = 0; i < count; i++) {
+    unsigned e = elements[i & (BENCH_RSP_ELEMENTS - 1)];
+    __m128i vs, vt;
+
+    vs = rsp_vect_load_unshuffled_operand(rsp->cp2.regs[i & 0x1F].e);
+    vt = rsp_vect_load_and_shuffle_operand(
+      rsp->cp2.regs[(i + 7) & 0x1F].e, e);
+
+    sum = _mm_xor_si128(sum, rsp_vmacf_vmacu(0,
+      vs, vt, zero, &acc_lo, &acc_md, &acc_hi));
+  }
+
+  return bench_rsp_fold(_mm_xor_si128(sum, acc_hi));
+}
+
+// Runs VMULF over random operand pairs.
+uint64_t bench_vmulf(unsigned long count) {
+  __m128i zero = _mm_setzero_si128();
+  __m128i acc_lo, acc_md, acc_hi;
+  __m128i sum = zero;
+  unsigned long i;
+
+  for (i = 0; i < count; i++) {
+    unsigned e = elements[i & (BENCH_RSP_ELEMENTS - 1)];
+    __m128i vs, vt;
+
+    vs = rsp_vect_load_unshuffled_operand(rsp->cp2.regs[i & 0x1F].e);
+    vt = rsp_vect_load_and_shuffle_operand(
+      rsp->cp2.regs[(i + 7) & 0x1F].e, e);
+
+    sum = _mm_xor_si128(sum, rsp_vmulf_vmulu(0,
+      vs, vt, zero, &acc_lo, &acc_md, &acc_hi));
+  }
+
+  return bench_rsp_fold(sum);
+}
+
+// Computes reciprocals of random elements.
+uint64_t bench_vrcp(unsigned long count) {
+  __m128i sum = _mm_setzero_si128();
+  unsigned long i;
+
+  for (i = 0; i < count; i++) {
+    unsigned e = elements[i & (BENCH_RSP_ELEMENTS - 1)];
+
+    sum = _mm_xor_si128(sum, rsp_vrcp_vrsq(rsp, 0x0, 0,
+      i & 0xF, e, 31, e));
+  }
+
+  return bench_rsp_fold(sum);
+}
+
+// Computes reciprocal square roots of random elements.
+uint64_t bench_vrsq(unsigned long count) {
+  __m128i sum = _mm_setzero_si128();
+  unsigned long i;
+
+  for (i = 0; i < count; i++) {
+    unsigned e = elements[i & (BENCH_RSP_ELEMENTS - 1)];
+
+    sum = _mm_xor_si128(sum, rsp_vrcp_vrsq(rsp, 0x4, 0,
+      i & 0xF, e, 31, e));
+  }
+
+  return bench_rsp_fold(sum);
+}
+
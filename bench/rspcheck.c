@@ -0,0 +1,260 @@
+//
+// bench/rspcheck.c: RSP vector backend cross-check.
+//
+// CEN64: Cycle-Accurate Nintendo 64 Emulator.
+// Copyright (C) 2015, Tyler J. Stachecki.
+//
+// This file is subject to the terms and conditions defined in
+// 'LICENSE', which is part of this source code package.
+//
+
+//
+// Built against arch/x86_64/rsp and against arch/arm/rsp, the latter
+// through bench/neon/arm_neon.h off ARM. Each build runs every vector
+// opcode and the vector load/store groups over the same seeded random
+// state and prints the results; cen64-rsp-check diffs the transcripts,
+// which only depend on the round count.
+//
+
+#include "common.h"
+#include "rsp/cpu.h"
+#include "rsp/opcodes.h"
+#include "rsp/pipeline.h"
+#include "rsp/rsp.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+#define RSP_CHECK_DEFAULT_ROUNDS 2000
+
+static uint64_t rsp_check_state = 0x2545F4914F6CDD1DULL;
+
+static uint32_t rsp_check_rand(void);
+static uint16_t rsp_check_rand16(void);
+static void rsp_check_randomize(struct rsp *rsp);
+static void rsp_check_dump(FILE *f, const struct rsp *rsp, unsigned vd);
+static void rsp_check_memory(FILE *f, struct rsp *rsp, unsigned group);
+static void rsp_check_vector(FILE *f, struct rsp *rsp, unsigned op);
+
+// Steps the xorshift generator.
+uint32_t rsp_check_rand(void) {
+  rsp_check_state ^= rsp_check_state << 13;
+  rsp_check_state ^= rsp_check_state >> 7;
+  rsp_check_state ^= rsp_check_state << 17;
+  return (uint32_t) rsp_check_state;
+}
+
+// Returns a random element, biased toward the saturation edges.
+uint16_t rsp_check_rand16(void) {
+  static const uint16_t edges[] = {
+    0x0000, 0x0001, 0x00FF, 0x7FFE, 0x7FFF,
+    0x8000, 0x8001, 0xFF00, 0xFFFF,
+  };
+
+  if (rsp_check_rand() % 4 == 0)
+    return edges[rsp_check_rand() % (sizeof(edges) / sizeof(*edges))];
+
+  return (uint16_t) rsp_check_rand();
+}
+
+// Fills the vector unit state and DMEM with random values.
+void rsp_check_randomize(struct rsp *rsp) {
+  unsigned i, j;
+
+  for (i = 0; i < 32; i++) {
+    for (j = 0; j < 8; j++)
+      rsp->cp2.regs[i].e[j] = rsp_check_rand16();
+  }
+
+  for (i = 0; i < 3; i++) {
+    for (j = 0; j < 16; j++)
+      rsp->cp2.flags[i].e[j] = (rsp_check_rand() & 1) ? 0xFFFF : 0x0000;
+  }
+
+  for (j = 0; j < 24; j++)
+    rsp->cp2.acc.e[j] = rsp_check_rand16();
+
+  for (i = 0; i < sizeof(rsp->mem); i++)
+    rsp->mem[i] = rsp_check_rand();
+
+  rsp->cp2.div_in = rsp_check_rand16();
+  rsp->cp2.div_out = rsp_check_rand16();
+  rsp->cp2.dp_flag = rsp_check_rand() & 1;
+}
+
+// Prints the destination, accumulator, flags, divider and a DMEM hash.
+void rsp_check_dump(FILE *f, const struct rsp *rsp, unsigned vd) {
+  uint64_t hash = 0xCBF29CE484222325ULL;
+  unsigned i, j;
+
+  for (j = 0; j < 8; j++)
+    fprintf(f, "%04X", rsp->cp2.regs[vd].e[j]);
+
+  fputc(' ', f);
+
+  for (j = 0; j < 24; j++)
+    fprintf(f, "%04X", rsp->cp2.acc.e[j]);
+
+  fputc(' ', f);
+
+  for (i = 0; i < 3; i++) {
+    for (j = 0; j < 16; j++)
+      fputc(rsp->cp2.flags[i].e[j] ? '1' : '0', f);
+  }
+
+  fprintf(f, " %04X %04X %u ", (uint16_t) rsp->cp2.div_in,
+    (uint16_t) rsp->cp2.div_out, (unsigned) rsp->cp2.dp_flag);
+
+  for (i = 0; i < sizeof(rsp->mem); i++)
+    hash = (hash ^ rsp->mem[i]) * 0x100000001B3ULL;
+
+  fprintf(f, "%016llX\n", (unsigned long long) hash);
+}
+
+// Runs one random load or store from a vector load/store group.
+void rsp_check_memory(FILE *f, struct rsp *rsp, unsigned group) {
+  static const uint16_t group1_dqm[2][4][4] = {
+    {{0x00FF, 0, 0, 0}, {0xFFFF, 0, 0, 0},
+     {0xFFFF, 0xFFFF, 0, 0}, {0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF}},
+    {{0xFF00, 0, 0, 0}, {0xFFFF, 0, 0, 0},
+     {0xFFFF, 0xFFFF, 0, 0}, {0xFFFF, 0xFFFF, 0xFFFF, 0xFFFF}},
+  };
+
+  static const enum rsp_mem_request_type group2_types[4] = {
+    RSP_MEM_REQUEST_PACK, RSP_MEM_REQUEST_UPACK,
+    RSP_MEM_REQUEST_HALF, RSP_MEM_REQUEST_FOURTH,
+  };
+
+  struct rsp_exdf_latch *exdf_latch = &rsp->pipeline.exdf_latch;
+  uint16_t *dqm_e = exdf_latch->request.packet.p_vect.vdqm.e;
+  uint32_t addr = rsp_check_rand() & 0xFFF;
+  unsigned element = rsp_check_rand() & 0xF;
+  unsigned store = group & 1;
+  unsigned vd, i;
+
+  rsp_vect_t reg, dqm;
+  uint16_t *regp;
+
+  rsp_check_randomize(rsp);
+  vd = rsp_check_rand() & 0x1F;
+  regp = rsp->cp2.regs[vd].e;
+  memset(dqm_e, 0, sizeof(exdf_latch->request.packet.p_vect.vdqm.e));
+
+  // Build the request the way the RSP's EX stage would.
+  switch (group >> 1) {
+    case 0:
+      memcpy(dqm_e, group1_dqm[store][rsp_check_rand() & 3],
+        sizeof(group1_dqm[0][0]));
+
+      exdf_latch->request.type = RSP_MEM_REQUEST_VECTOR;
+      break;
+
+    case 1:
+      exdf_latch->request.type = group2_types[rsp_check_rand() & 3];
+      break;
+
+    default:
+      for (i = 0; i < 8; i++) {
+        unsigned offset = addr & 0xF;
+
+        if (i < offset / 2)
+          dqm_e[i] = 0x0000;
+        else if (i == offset / 2 && (offset & 1))
+          dqm_e[i] = 0xFF00;
+        else
+          dqm_e[i] = 0xFFFF;
+      }
+
+      exdf_latch->request.type = (rsp_check_rand() & 1)
+        ? RSP_MEM_REQUEST_REST : RSP_MEM_REQUEST_QUAD;
+      break;
+  }
+
+  reg = rsp_vect_load_unshuffled_operand(regp);
+  dqm = rsp_vect_load_unshuffled_operand(dqm_e);
+
+  switch (group) {
+    case 0: rsp_vload_group1(rsp, addr, element, regp, reg, dqm); break;
+    case 1: rsp_vstore_group1(rsp, addr, element, regp, reg, dqm); break;
+    case 2: rsp_vload_group2(rsp, addr, element, regp, reg, dqm); break;
+    case 3: rsp_vstore_group2(rsp, addr, element, regp, reg, dqm); break;
+    case 4: rsp_vload_group4(rsp, addr, element, regp, reg, dqm); break;
+    case 5: rsp_vstore_group4(rsp, addr, element, regp, reg, dqm); break;
+  }
+
+  fprintf(f, "mem%u %d %03X %X ", group,
+    (int) exdf_latch->request.type, (unsigned) addr, element);
+
+  rsp_check_dump(f, rsp, vd);
+}
+
+// Runs one vector opcode with a random instruction word.
+void rsp_check_vector(FILE *f, struct rsp *rsp, unsigned op) {
+  uint32_t iw = (0x12U << 26) | (1U << 25) | (rsp_check_rand() & 0x1FFFFFF);
+  unsigned e = iw >> 21 & 0xF;
+  unsigned vt = iw >> 16 & 0x1F;
+  unsigned vs = iw >> 11 & 0x1F;
+  unsigned vd = iw >> 6 & 0x1F;
+
+  rsp_vect_t vs_reg, vt_shuf_reg, vd_reg;
+
+  rsp_check_randomize(rsp);
+  vs_reg = rsp_vect_load_unshuffled_operand(rsp->cp2.regs[vs].e);
+  vt_shuf_reg = rsp_vect_load_and_shuffle_operand(rsp->cp2.regs[vt].e, e);
+
+  vd_reg = rsp_vector_function_table[op](rsp, iw,
+    vt_shuf_reg, vs_reg, rsp_vzero());
+
+  rsp_vect_write_operand(rsp->cp2.regs[vd].e, vd_reg);
+
+  fprintf(f, "vec%u %08X ", op, iw);
+  rsp_check_dump(f, rsp, vd);
+}
+
+// Usage: cen64-rsp-check-<arch> [rounds] [output].
+int main(int argc, const char *argv[]) {
+  unsigned long rounds = RSP_CHECK_DEFAULT_ROUNDS;
+  unsigned long round;
+  struct rsp *rsp;
+  unsigned i;
+  FILE *f;
+
+  if (argc > 1)
+    rounds = strtoul(argv[1], NULL, 0);
+
+  if (argc > 2) {
+    if ((f = fopen(argv[2], "w")) == NULL) {
+      printf("Failed to open %s for writing.\n", argv[2]);
+      return 1;
+    }
+  }
+
+  else
+    f = stdout;
+
+  if ((rsp = calloc(1, sizeof(*rsp))) == NULL) {
+    printf("Failed to allocate the RSP.\n");
+
+    if (f != stdout)
+      fclose(f);
+
+    return 1;
+  }
+
+  arch_rsp_init(rsp);
+
+  for (round = 0; round < rounds; round++) {
+    for (i = 0; i < NUM_RSP_VECTOR_OPCODES; i++)
+      rsp_check_vector(f, rsp, i);
+
+    for (i = 0; i < 6; i++)
+      rsp_check_memory(f, rsp, i);
+  }
+
+  arch_rsp_destroy(rsp);
+  free(rsp);
+
+  if (f != stdout)
+    fclose(f);
+
+  return 0;
+}
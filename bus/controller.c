@@ -13,6 +13,7 @@
 #include "bus/address.h"
 #include "bus/controller.h"
 #include "bus/memorymap.h"
+#include "common/stats.h"
 #include "dd/controller.h"
 #include "pi/controller.h"
 #include "ri/controller.h"
@@ -25,7 +26,13 @@
 #include "vr4300/cpu.h"
 #include "vr4300/interface.h"
 
-#define NUM_MAPPINGS 17
+// Names of the mappings below, in the same order (for -stats).
+const char *bus_mapping_names[NUM_BUS_MAPPINGS] = {
+  "ai_regs", "dp_regs", "mi_regs", "pi_regs",
+  "ri_regs", "si_regs", "sp_regs", "vi_regs",
+  "cart_rom", "flashram", "dd_controller", "dd_ipl_rom",
+  "pif_rom_and_ram", "rdram_regs", "sp_regs2", "sp_mem", "sram",
+};
 
 struct bus_controller_mapping {
   memory_rd_function read;
@@ -38,11 +45,17 @@ static int bus_open_read(void *opaque, uint32_t address, uint32_t *word);
 static int bus_dead_write(void *opaque, uint32_t address, uint32_t word,
   uint32_t dqm);
 
+// Mappings are allocated in order after the nil node, so the
+// node's position in the map recovers its index into mappings[].
+#define bus_mapping_index(bus, node) ((const struct memory_map_node *) \
+  ((const uint8_t *) (node) - offsetof(struct memory_map_node, mapping)) - \
+  (bus)->map.mappings - 1)
+
 // Initializes the bus component.
 int bus_init(struct bus_controller *bus, int dd_present) {
   unsigned i;
 
-  static const struct bus_controller_mapping mappings[NUM_MAPPINGS] = {
+  static const struct bus_controller_mapping mappings[NUM_BUS_MAPPINGS] = {
     {read_ai_regs, write_ai_regs, AI_REGS_BASE_ADDRESS, AI_REGS_ADDRESS_LEN},
     {read_dp_regs, write_dp_regs, DP_REGS_BASE_ADDRESS, DP_REGS_ADDRESS_LEN},
     {read_mi_regs, write_mi_regs, MI_REGS_BASE_ADDRESS, MI_REGS_ADDRESS_LEN},
@@ -63,7 +76,7 @@ int bus_init(struct bus_controller *bus, int dd_present) {
     {read_sram, write_sram, SRAM_BASE_ADDRESS, SRAM_ADDRESS_LEN},
   };
 
-  void *instances[NUM_MAPPINGS] = {
+  void *instances[NUM_BUS_MAPPINGS] = {
     bus->ai,
     bus->rdp,
     bus->vr4300,
@@ -86,7 +99,11 @@ int bus_init(struct bus_controller *bus, int dd_present) {
 
   create_memory_map(&bus->map);
 
-  for (i = 0; i < NUM_MAPPINGS; i++) {
+#ifdef CEN64_FASTMEM
+  memset(bus->fastmem, 0, sizeof(bus->fastmem));
+#endif
+
+  for (i = 0; i < NUM_BUS_MAPPINGS; i++) {
     memory_rd_function rd = mappings[i].read;
     memory_wr_function wr = mappings[i].write;
     void *instance = instances[i];
@@ -105,6 +122,34 @@ int bus_init(struct bus_controller *bus, int dd_present) {
   return 0;
 }
 
+// Points the pages wholly inside [address, address + length) at host
+// memory. Accesses to other pages keep going through the memory map.
+void bus_map_fastmem(struct bus_controller *bus,
+  uint32_t address, uint32_t length, const uint8_t *host) {
+#ifdef CEN64_FASTMEM
+  uint32_t first = (address + BUS_FASTMEM_PAGE_SIZE - 1) >> BUS_FASTMEM_SHIFT;
+  uint32_t end = (uint32_t) (((uint64_t) address + length) >> BUS_FASTMEM_SHIFT);
+  uint32_t page;
+
+  for (page = first; page < end && page < BUS_FASTMEM_PAGES; page++)
+    bus->fastmem[page] = host + ((page << BUS_FASTMEM_SHIFT) - address);
+#endif
+}
+
+// Sends every page touching [address, address + length) back to the
+// memory map (e.g., for MMIO windows inside an otherwise flat region).
+void bus_unmap_fastmem(struct bus_controller *bus,
+  uint32_t address, uint32_t length) {
+#ifdef CEN64_FASTMEM
+  uint32_t page = address >> BUS_FASTMEM_SHIFT;
+  uint32_t last = (uint32_t) (((uint64_t) address + length - 1) >>
+    BUS_FASTMEM_SHIFT);
+
+  for (; length && page <= last && page < BUS_FASTMEM_PAGES; page++)
+    bus->fastmem[page] = NULL;
+#endif
+}
+
 // Open read (happens for non-mapped addresses)
 static int bus_open_read(void *opaque, uint32_t address, uint32_t *word) {
   *word = (address >> 16) | (address & 0xFFFF0000);
@@ -123,16 +168,39 @@ int bus_read_word(void *component, uint32_t address, uint32_t *word) {
 
   memcpy(&bus, component, sizeof(bus));
 
-  if (address < RDRAM_BASE_ADDRESS_LEN)
+  if (address < RDRAM_BASE_ADDRESS_LEN) {
+    stats_inc(rdram_reads);
+#ifdef CEN64_FASTMEM
+    *word = ri_read_word(bus->ri, address);
+    return 0;
+#else
     return read_rdram(bus->ri, address, word);
+#endif
+  }
+
+#ifdef CEN64_FASTMEM
+  else if (address < BUS_FASTMEM_LIMIT &&
+    bus->fastmem[address >> BUS_FASTMEM_SHIFT] != NULL) {
+    const uint8_t *page = bus->fastmem[address >> BUS_FASTMEM_SHIFT];
+
+    stats_inc(bus_fastmem_reads);
+    memcpy(word, page + (address & (BUS_FASTMEM_PAGE_SIZE - 4)),
+      sizeof(*word));
+
+    *word = byteswap_32(*word);
+    return 0;
+  }
+#endif
 
   else if ((node = resolve_mapped_address(&bus->map, address)) == NULL) {
     debug("bus_read_word: Failed to access: 0x%.8X\n", address);
+    stats_inc(bus_unmapped_accesses);
 
     *word = (address >> 16) | (address & 0xFFFF0000);
     return 0;
   }
 
+  stats_inc(bus_reads[bus_mapping_index(bus, node)]);
   return node->on_read(node->instance, address, word);
 }
 
@@ -144,15 +212,24 @@ int bus_write_word(void *component,
 
   memcpy(&bus, component, sizeof(bus));
 
-  if (address < RDRAM_BASE_ADDRESS_LEN)
+  if (address < RDRAM_BASE_ADDRESS_LEN) {
+    stats_inc(rdram_writes);
+#ifdef CEN64_FASTMEM
+    ri_write_word(bus->ri, address, word, dqm);
+    return 0;
+#else
     return write_rdram(bus->ri, address, word & dqm, dqm);
+#endif
+  }
 
   else if ((node = resolve_mapped_address(&bus->map, address)) == NULL) {
     debug("bus_write_word: Failed to access: 0x%.8X\n", address);
+    stats_inc(bus_unmapped_accesses);
 
     return 0;
   }
 
+  stats_inc(bus_writes[bus_mapping_index(bus, node)]);
   return node->on_write(node->instance, address, word & dqm, dqm);
 }
 
@@ -14,6 +14,15 @@
 #include "bus/memorymap.h"
 #include <setjmp.h>
 
+#define NUM_BUS_MAPPINGS 17
+
+// Memory-like regions outside of RDRAM are mapped to host memory in
+// pages of this size, so reads skip the memory map and handler call.
+#define BUS_FASTMEM_SHIFT 16
+#define BUS_FASTMEM_PAGE_SIZE (1U << BUS_FASTMEM_SHIFT)
+#define BUS_FASTMEM_LIMIT 0x20000000U
+#define BUS_FASTMEM_PAGES (BUS_FASTMEM_LIMIT >> BUS_FASTMEM_SHIFT)
+
 struct ai_controller;
 struct dd_controller;
 struct pi_controller;
@@ -40,14 +49,26 @@ struct bus_controller {
   // For resolving physical address ranges to devices.
   struct memory_map map;
 
+#ifdef CEN64_FASTMEM
+  // Host pointers to big-endian backing store, or NULL (slow path).
+  const uint8_t *fastmem[BUS_FASTMEM_PAGES];
+#endif
+
   // Allows to to pop back out into device_run during simulation.
   // Kind of a hack to put this in with the device "bus", but at
   // least everyone gets access to it this way.
   jmp_buf unwind_data;
 };
 
+extern const char *bus_mapping_names[NUM_BUS_MAPPINGS];
+
 cen64_cold int bus_init(struct bus_controller *bus, int dd_present);
 
+cen64_cold void bus_map_fastmem(struct bus_controller *bus,
+  uint32_t address, uint32_t length, const uint8_t *host);
+cen64_cold void bus_unmap_fastmem(struct bus_controller *bus,
+  uint32_t address, uint32_t length);
+
 // General-purpose accesssor functions.
 cen64_flatten cen64_hot int bus_read_word(void *component,
   uint32_t address, uint32_t *word);
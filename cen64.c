@@ -11,36 +11,57 @@
 #include "common.h"
 #include "bus/controller.h"
 #include "cen64.h"
+#include "common/stats.h"
 #include "device/cart_db.h"
 #include "device/device.h"
+#include "device/lockstep.h"
+#include "device/netapi.h"
 #include "device/options.h"
+#include "device/profiler.h"
+#include "device/telemetry.h"
 #include "device/sha1.h"
 #include "device/sha1_sums.h"
 #include "os/common/alloc.h"
+#include "os/common/lockstep.h"
 #include "os/common/rom_file.h"
 #include "os/common/save_file.h"
 #include "os/cpuid.h"
 #include "pi/is_viewer.h"
 #include "thread.h"
+#include "timer.h"
+#include "vi/governor.h"
+#include <signal.h>
 #include <stdlib.h>
 
 cen64_cold static int check_extensions(void);
 cen64_cold static int load_roms(const char *ddipl_path, const char *ddrom_path,
   const char *pifrom_path, const char *cart_path, struct rom_file *ddipl,
   const struct dd_variant **dd_variant,
-  struct rom_file *ddrom, struct rom_file *pifrom, struct rom_file *cart);
+  const char *ddjournal_path, struct dd_disk *ddrom,
+  struct rom_file *pifrom, struct rom_file *cart);
 cen64_cold static int load_paks(struct controller *controller);
+cen64_cold static int start_lockstep(struct cen64_options *options,
+  struct controller *controller, struct save_file *saves[3],
+  struct dd_disk *ddrom, int *channel, bool *reference);
 cen64_cold static int validate_sha(struct rom_file *rom, const uint8_t *good_sum);
 
+cen64_cold static void build_thread_policy(const struct cen64_options *options,
+  struct cen64_thread_policy *policy);
+
 cen64_cold static int run_device(struct cen64_device *device, bool no_video);
 cen64_cold static CEN64_THREAD_RETURN_TYPE run_device_thread(void *opaque);
+cen64_cold static void request_exit(int signum);
+
+// Set from SIGINT/SIGTERM; polled by headless runs.
+static volatile sig_atomic_t exit_requested;
 
 // Called when another simulation instance is desired.
 int cen64_main(int argc, const char **argv) {
   struct controller controller[4] = { { 0, }, };
 	struct cen64_options options = default_cen64_options;
   options.controller = controller;
-  struct rom_file ddipl, ddrom, pifrom, cart;
+  struct rom_file ddipl, pifrom, cart;
+  struct dd_disk ddrom;
   const struct dd_variant *dd_variant;
   struct cen64_mem cen64_device_mem;
   struct cen64_device *device;
@@ -51,6 +72,9 @@ int cen64_main(int argc, const char **argv) {
   struct save_file sram;
   struct save_file flashram;
   struct is_viewer is, *is_in = NULL;
+  struct save_file *saves[3];
+  bool lockstep_reference = false;
+  int lockstep_channel = -1;
 
   if (!cart_db_is_well_formed()) {
     printf("Internal cart detection database is not well-formed.\n");
@@ -90,7 +114,8 @@ int cen64_main(int argc, const char **argv) {
   dd_variant = NULL;
 
   if (load_roms(options.ddipl_path, options.ddrom_path, options.pifrom_path,
-    options.cart_path, &ddipl, &dd_variant, &ddrom, &pifrom, &cart)) {
+    options.cart_path, &ddipl, &dd_variant, options.ddjournal_path,
+    &ddrom, &pifrom, &cart)) {
     cen64_alloc_cleanup();
     return EXIT_FAILURE;
   }
@@ -134,6 +159,17 @@ int cen64_main(int argc, const char **argv) {
     }
   }
 
+  saves[0] = &eeprom;
+  saves[1] = &sram;
+  saves[2] = &flashram;
+
+  if (options.lockstep_interval && start_lockstep(&options,
+    controller, saves, options.ddrom_path ? &ddrom : NULL,
+    &lockstep_channel, &lockstep_reference)) {
+    cen64_alloc_cleanup();
+    return EXIT_FAILURE;
+  }
+
   // Allocate memory for and create the device.
   if (cen64_alloc(&cen64_device_mem, sizeof(*device), false) == NULL) {
     printf("Failed to allocate enough memory for a device.\n");
@@ -143,7 +179,8 @@ int cen64_main(int argc, const char **argv) {
   else {
     device = (struct cen64_device *) cen64_device_mem.ptr;
 
-    if (device_create(device, &ddipl, dd_variant, &ddrom,
+    if (device_create(device, &ddipl, dd_variant,
+      options.ddrom_path ? &ddrom : NULL,
       &pifrom, &cart, &eeprom, &sram,
       &flashram, is_in, controller, options.no_audio, options.no_video) == NULL) {
       printf("Failed to create a device.\n");
@@ -151,8 +188,104 @@ int cen64_main(int argc, const char **argv) {
     }
 
     else {
+      struct cen64_thread_policy thread_policy[NUM_CEN64_THREAD_ROLES];
+      struct netapi_debugger *debugger = NULL;
+      struct cen64_profiler profiler;
+      struct cen64_lockstep lockstep;
+      struct cen64_telemetry telemetry;
+      cen64_time run_start, run_end;
       device->multithread = options.multithread;
+      device->rdp.texel_cache = options.texel_cache;
+      device->vr4300.slow_paths = options.no_fast_paths;
+
+      if (options.no_fast_paths)
+        bus_unmap_fastmem(&device->bus, 0, BUS_FASTMEM_LIMIT);
+      device->vi.field_limit = options.frame_limit;
+
+      build_thread_policy(&options, thread_policy);
+      device->thread_policy = thread_policy;
+      vi_governor_init(&device->vi.governor,
+        options.turbo ? 0 : options.speed);
+
+      if (options.profile_path) {
+        if (profiler_init(&profiler, options.profile_interval))
+          printf("Failed to initialize the profiler; continuing without it.\n");
+        else
+          device->profiler = &profiler;
+      }
+
+      if (options.lockstep_interval) {
+        lockstep_init(&lockstep, options.lockstep_interval,
+          options.lockstep_start, lockstep_channel, lockstep_reference);
+
+        device->lockstep = &lockstep;
+      }
+
+      if (options.enable_debugger) {
+        if ((debugger = malloc(sizeof(*debugger))) == NULL ||
+          netapi_debug_start(debugger, device, options.debugger_addr)) {
+          printf("Failed to start the debugger; continuing without it.\n");
+
+          free(debugger);
+          debugger = NULL;
+        }
+
+        device->vi.debugger = debugger;
+      }
+
+      if (options.telemetry_path) {
+        if (telemetry_start(&telemetry, device,
+          options.telemetry_path, options.telemetry_binary))
+          printf("Failed to start telemetry; continuing without it.\n");
+        else
+          device->vi.telemetry = &telemetry;
+      }
+
+      get_time(&run_start);
       status = run_device(device, options.no_video);
+      get_time(&run_end);
+
+      stats_add(run_host_ns, compute_time_difference(&run_end, &run_start));
+
+      if (debugger) {
+        netapi_debug_stop(debugger);
+        free(debugger);
+      }
+
+      if (device->vi.telemetry)
+        telemetry_stop(&telemetry);
+
+      if (options.print_stats) {
+        stats_print(stdout);
+        vi_governor_print_summary(&device->vi.governor);
+      }
+
+      if (options.stats_json_path &&
+        stats_write_json(options.stats_json_path))
+        printf("Failed to write stats: %s.\n", options.stats_json_path);
+
+      if (device->profiler) {
+        printf("Profiler: collected %lu samples.\n", profiler.samples);
+
+        if (profiler_write_collapsed(&profiler, options.profile_path))
+          printf("Failed to write profile: %s.\n", options.profile_path);
+
+        profiler_destroy(&profiler);
+      }
+
+      if (device->lockstep) {
+        if (cen64_lockstep_finish(lockstep_channel, lockstep_reference))
+          printf("Lockstep: the reference instance failed.\n");
+
+        if (lockstep.diverged)
+          status = EXIT_FAILURE;
+
+        else if (!lockstep_reference) {
+          printf("Lockstep: %lu intervals matched the reference.\n",
+            lockstep.intervals);
+        }
+      }
+
       device_destroy(device);
     }
 
@@ -164,7 +297,7 @@ int cen64_main(int argc, const char **argv) {
     close_rom_file(&ddipl);
 
   if (options.ddrom_path)
-    close_rom_file(&ddrom);
+    dd_disk_close(&ddrom);
 
   if (options.cart_path)
     close_rom_file(&cart);
@@ -259,7 +392,8 @@ int check_extensions(void) {
 int load_roms(const char *ddipl_path, const char *ddrom_path,
   const char *pifrom_path, const char *cart_path, struct rom_file *ddipl,
   const struct dd_variant **dd_variant,
-  struct rom_file *ddrom, struct rom_file *pifrom, struct rom_file *cart) {
+  const char *ddjournal_path, struct dd_disk *ddrom,
+  struct rom_file *pifrom, struct rom_file *cart) {
   memset(ddipl, 0, sizeof(*ddipl));
 
   if (ddipl_path && open_rom_file(ddipl_path, ddipl)) {
@@ -275,7 +409,7 @@ int load_roms(const char *ddipl_path, const char *ddrom_path,
       printf("DD variant: %s\n", (*dd_variant)->description);
   }
 
-  if (ddrom_path && open_rom_file(ddrom_path, ddrom)) {
+  if (ddrom_path && dd_disk_open(ddrom, ddrom_path, ddjournal_path)) {
     printf("Failed to load DD ROM: %s.\n", ddrom_path);
 
     if (ddipl_path)
@@ -291,7 +425,7 @@ int load_roms(const char *ddipl_path, const char *ddrom_path,
       close_rom_file(ddipl);
 
     if (ddrom_path)
-      close_rom_file(ddrom);
+      dd_disk_close(ddrom);
 
     return 3;
   }
@@ -310,7 +444,7 @@ int load_roms(const char *ddipl_path, const char *ddrom_path,
       close_rom_file(ddipl);
 
     if (ddrom_path)
-      close_rom_file(ddrom);
+      dd_disk_close(ddrom);
 
     return 5;
 #endif
@@ -323,7 +457,7 @@ int load_roms(const char *ddipl_path, const char *ddrom_path,
       close_rom_file(ddipl);
 
     if (ddrom_path)
-      close_rom_file(ddrom);
+      dd_disk_close(ddrom);
 
     close_rom_file(pifrom);
     return 4;
@@ -373,12 +507,92 @@ int load_paks(struct controller *controller) {
   return 0;
 }
 
+// Forks off the -lockstep reference instance. It gets private copies
+// of the saves so that only the instance being checked writes them.
+int start_lockstep(struct cen64_options *options,
+  struct controller *controller, struct save_file *saves[3],
+  struct dd_disk *ddrom, int *channel, bool *reference) {
+  int i, status = 0;
+
+  // AI timing depends on how fast the host drains audio buffers.
+  options->no_audio = true;
+
+  if (cen64_lockstep_fork(channel, reference))
+    return 1;
+
+  if (!*reference)
+    return 0;
+
+  lockstep_reference_options(options);
+
+  for (i = 0; i < 3; i++)
+    status |= detach_save_file(saves[i]);
+
+  for (i = 0; i < 4; i++) {
+    status |= detach_save_file(&controller[i].mempak_save);
+    status |= detach_save_file(&controller[i].tpak_save);
+  }
+
+  if (ddrom)
+    status |= dd_disk_detach(ddrom);
+
+  if (status)
+    printf("Lockstep: failed to detach the reference from the saves and disk.\n");
+
+  return status != 0;
+}
+
 int validate_sha(struct rom_file *rom, const uint8_t *good_sum) {
   uint8_t sha1_calc[20];
   sha1(rom->ptr, rom->size, sha1_calc);
   return memcmp(sha1_calc, good_sum, SHA1_SIZE) == 0;
 }
 
+// Builds the per-thread affinity/scheduling policy from the options.
+void build_thread_policy(const struct cen64_options *options,
+  struct cen64_thread_policy *policy) {
+  uint8_t l3_cpus[CEN64_MAX_CPUS / 8];
+  int anchor = -1;
+  unsigned i, j;
+
+  memset(policy, 0, sizeof(*policy) * NUM_CEN64_THREAD_ROLES);
+
+  for (i = 0; i < NUM_CEN64_THREAD_ROLES; i++) {
+    if (options->affinity[i]) {
+      parse_cpu_list(options->affinity[i], policy[i].cpus);
+      policy[i].pinned = true;
+
+      // Remember the first pinned CPU for -same-l3.
+      for (j = 0; anchor < 0 && j < CEN64_MAX_CPUS; j++) {
+        if (policy[i].cpus[j >> 3] & (1 << (j & 0x7)))
+          anchor = j;
+      }
+    }
+
+    // The window thread doesn't need to be real-time.
+    if (i != CEN64_THREAD_UI)
+      policy[i].fifo_priority = options->sched_fifo;
+
+    policy[i].nice = options->nice;
+    policy[i].renice = options->renice;
+  }
+
+  if (!options->same_l3)
+    return;
+
+  if (cen64_thread_get_l3_cpus(anchor, l3_cpus)) {
+    printf("Unable to determine the L3 topology; ignoring -same-l3.\n");
+    return;
+  }
+
+  for (i = 0; i < NUM_CEN64_THREAD_ROLES; i++) {
+    if (!policy[i].pinned) {
+      memcpy(policy[i].cpus, l3_cpus, sizeof(l3_cpus));
+      policy[i].pinned = true;
+    }
+  }
+}
+
 // Spins the device until an exit request is received.
 int run_device(struct cen64_device *device, bool no_video) {
   cen64_thread thread;
@@ -391,10 +605,41 @@ int run_device(struct cen64_device *device, bool no_video) {
     return 1;
   }
 
-  if (!no_video)
+  // With a window, run until it's closed.
+  if (!no_video) {
+    if (device->thread_policy) {
+      cen64_thread_apply_policy(CEN64_THREAD_UI,
+        device->thread_policy + CEN64_THREAD_UI);
+    }
+
     cen64_gl_window_thread(device);
+  }
+
+  // Without one, until the device exits on its own (i.e., -frames)
+  // or we're interrupted.
+  else {
+    exit_requested = 0;
+    signal(SIGINT, request_exit);
+    signal(SIGTERM, request_exit);
+
+    while (device->running && !exit_requested) {
+      cen64_time now;
+
+      get_time(&now);
+      wait_until(&now, NS_PER_SEC / 10);
+    }
+
+    signal(SIGINT, SIG_DFL);
+    signal(SIGTERM, SIG_DFL);
+  }
 
   device->running = false;
+
+  // The exit request is only seen at VI fields, which a device held
+  // at a breakpoint never reaches.
+  if (device->vi.debugger)
+    netapi_debug_release(device->vi.debugger);
+
   cen64_thread_join(&thread);
   return 0;
 }
@@ -402,7 +647,18 @@ int run_device(struct cen64_device *device, bool no_video) {
 CEN64_THREAD_RETURN_TYPE run_device_thread(void *opaque) {
   struct cen64_device *device = (struct cen64_device *) opaque;
 
+  if (device->thread_policy) {
+    cen64_thread_apply_policy(CEN64_THREAD_RCP,
+      device->thread_policy + CEN64_THREAD_RCP);
+  }
+
   device_run(device);
+  device->running = false;
   return CEN64_THREAD_RETURN_VAL;
 }
 
+// Asks a headless run to stop.
+void request_exit(int signum) {
+  exit_requested = 1;
+}
+
@@ -0,0 +1,113 @@
+#
+# CEN64: Cycle-Accurate Nintendo 64 Emulator.
+# Copyright (C) 2015, Tyler J. Stachecki.
+#
+# This file is subject to the terms and conditions defined in
+# 'LICENSE', which is part of this source code package.
+#
+# Drives a profile-guided build (invoked by the cen64-pgo target):
+#
+#   1. Configure and build an instrumented cen64 (CEN64_PGO=GENERATE).
+#   2. Train: run each ROM headless, unthrottled, for a fixed number
+#      of VI fields. The run is deterministic; the emulator has no
+#      sources of input or timing that feed back into the guest.
+#   3. Reconfigure the *same* build tree with CEN64_PGO=USE and build
+#      again (GCC keys profiles on object paths, so the tree must not
+#      move between phases), then copy the result to CEN64_OUTPUT.
+#
+# No ROMs can be shipped with the source, so the training workload is
+# supplied via CEN64_PGO_PIFROM and CEN64_PGO_ROMS ('|'-separated).
+# Homebrew test ROMs that exercise the CPU, RSP microcode and the RDP
+# (e.g. a graphics demo) make good training material.
+#
+
+if (NOT CEN64_PGO_PIFROM OR NOT CEN64_PGO_ROMS)
+  message(FATAL_ERROR "cen64-pgo needs a training workload: "
+    "set CEN64_PGO_PIFROM and CEN64_PGO_ROMS.")
+endif ()
+
+string(REPLACE "|" ";" CEN64_PGO_ROMS "${CEN64_PGO_ROMS}")
+set(CEN64_PGO_DIR "${CEN64_BINARY_DIR}/pgo-data")
+
+set(CEN64_PGO_CONFIGURE_ARGS
+  "-DCMAKE_BUILD_TYPE=Release"
+  "-DCMAKE_C_COMPILER=${CMAKE_C_COMPILER}"
+  "-DCMAKE_C_FLAGS=${CMAKE_C_FLAGS}"
+  "-DCEN64_PGO_DIR=${CEN64_PGO_DIR}"
+)
+
+foreach (var CEN64_ARCH_SUPPORT OPENAL_INCLUDE_DIR OPENAL_LIBRARY)
+  if (${var})
+    list(APPEND CEN64_PGO_CONFIGURE_ARGS "-D${var}=${${var}}")
+  endif ()
+endforeach ()
+
+# Configures and builds the sub-tree for one phase.
+macro(cen64_pgo_build phase)
+  message(STATUS "cen64-pgo: building (${phase})")
+
+  execute_process(
+    COMMAND ${CMAKE_COMMAND} ${CEN64_PGO_CONFIGURE_ARGS}
+      "-DCEN64_PGO=${phase}" ${CEN64_SOURCE_DIR}
+    WORKING_DIRECTORY ${CEN64_BINARY_DIR}
+    RESULT_VARIABLE result)
+
+  if (NOT result EQUAL 0)
+    message(FATAL_ERROR "cen64-pgo: configure (${phase}) failed.")
+  endif ()
+
+  execute_process(
+    COMMAND ${CMAKE_COMMAND} --build ${CEN64_BINARY_DIR}
+    RESULT_VARIABLE result)
+
+  if (NOT result EQUAL 0)
+    message(FATAL_ERROR "cen64-pgo: build (${phase}) failed.")
+  endif ()
+endmacro()
+
+file(MAKE_DIRECTORY ${CEN64_BINARY_DIR})
+file(REMOVE_RECURSE ${CEN64_PGO_DIR})
+file(MAKE_DIRECTORY ${CEN64_PGO_DIR})
+
+cen64_pgo_build(GENERATE)
+
+foreach (rom ${CEN64_PGO_ROMS})
+  message(STATUS "cen64-pgo: training on ${rom}")
+
+  execute_process(
+    COMMAND ${CEN64_BINARY_DIR}/cen64 -headless -turbo
+      -frames ${CEN64_PGO_FRAMES} ${CEN64_PGO_PIFROM} ${rom}
+    WORKING_DIRECTORY ${CEN64_BINARY_DIR}
+    RESULT_VARIABLE result)
+
+  if (NOT result EQUAL 0)
+    message(FATAL_ERROR "cen64-pgo: training run failed on ${rom}.")
+  endif ()
+endforeach ()
+
+# Clang writes raw profiles that have to be merged first.
+if (${CMAKE_C_COMPILER_ID} MATCHES Clang)
+  get_filename_component(compiler_dir ${CMAKE_C_COMPILER} PATH)
+  find_program(LLVM_PROFDATA NAMES llvm-profdata HINTS ${compiler_dir})
+
+  if (NOT LLVM_PROFDATA)
+    message(FATAL_ERROR "cen64-pgo: llvm-profdata not found.")
+  endif ()
+
+  file(GLOB raw_profiles ${CEN64_PGO_DIR}/*.profraw)
+
+  execute_process(
+    COMMAND ${LLVM_PROFDATA} merge
+      -output=${CEN64_PGO_DIR}/cen64.profdata ${raw_profiles}
+    RESULT_VARIABLE result)
+
+  if (NOT result EQUAL 0)
+    message(FATAL_ERROR "cen64-pgo: failed to merge profiles.")
+  endif ()
+endif ()
+
+cen64_pgo_build(USE)
+
+configure_file(${CEN64_BINARY_DIR}/cen64 ${CEN64_OUTPUT} COPYONLY)
+message(STATUS "cen64-pgo: wrote ${CEN64_OUTPUT}")
+
@@ -0,0 +1,98 @@
+//
+// common/stats.c: Host hot-path counters.
+//
+// CEN64: Cycle-Accurate Nintendo 64 Emulator.
+// Copyright (C) 2015, Tyler J. Stachecki.
+//
+// This file is subject to the terms and conditions defined in
+// 'LICENSE', which is part of this source code package.
+//
+
+#include "common.h"
+#include "bus/controller.h"
+#include "common/stats.h"
+
+struct cen64_stats cen64_stats;
+
+// Prints a human-readable summary of the counters.
+void stats_print(FILE *f) {
+  fprintf(f, "###############################\n"
+             " CEN64 Host Statistics\n"
+             "###############################\n"
+             "\n");
+
+#ifndef CEN64_STATS
+  fprintf(f, " (not available: built without CEN64_STATS)\n\n");
+#else
+  unsigned i;
+
+  fprintf(f, " * Counters:\n\n");
+
+#define X(counter) fprintf(f, "   %26s: %llu\n", #counter, cen64_stats.counter);
+#include "common/stats.md"
+#undef X
+
+  fprintf(f, "\n * Bus dispatch (reads/writes):\n\n");
+
+  for (i = 0; i < NUM_BUS_MAPPINGS; i++) {
+    fprintf(f, "   %26s: %llu/%llu\n", bus_mapping_names[i],
+      cen64_stats.bus_reads[i], cen64_stats.bus_writes[i]);
+  }
+
+  fprintf(f, "\n * RDP commands:\n\n");
+
+  for (i = 0; i < CEN64_STATS_RDP_COMMANDS; i++) {
+    if (cen64_stats.rdp_command_counts[i])
+      fprintf(f, "   %26s0x%.2X: %llu\n", "",
+        i, cen64_stats.rdp_command_counts[i]);
+  }
+
+  fprintf(f, "\n");
+#endif
+}
+
+// Writes the counters out to a file as a JSON object.
+int stats_write_json(const char *path) {
+  const char *sep = "";
+  unsigned i;
+  FILE *f;
+
+  if ((f = fopen(path, "w")) == NULL)
+    return 1;
+
+  fprintf(f, "{\n");
+
+#ifdef CEN64_STATS
+  fprintf(f, "  \"enabled\": true,\n");
+#else
+  fprintf(f, "  \"enabled\": false,\n");
+#endif
+
+  fprintf(f, "  \"counters\": {");
+
+#define X(counter) \
+  fprintf(f, "%s\n    \"%s\": %llu", sep, #counter, cen64_stats.counter); \
+  sep = ",";
+#include "common/stats.md"
+#undef X
+
+  fprintf(f, "\n  },\n  \"bus\": {");
+
+  for (i = 0; i < NUM_BUS_MAPPINGS; i++) {
+    fprintf(f, "%s\n    \"%s\": {\"reads\": %llu, \"writes\": %llu}",
+      i ? "," : "", bus_mapping_names[i],
+      cen64_stats.bus_reads[i], cen64_stats.bus_writes[i]);
+  }
+
+  fprintf(f, "\n  },\n  \"rdp_commands\": {");
+
+  for (i = 0; i < CEN64_STATS_RDP_COMMANDS; i++)
+    fprintf(f, "%s\n    \"0x%.2X\": %llu", i ? "," : "",
+      i, cen64_stats.rdp_command_counts[i]);
+
+  fprintf(f, "\n  }\n}\n");
+
+  fclose(f);
+  return 0;
+}
+
@@ -0,0 +1,46 @@
+//
+// common/stats.h: Host hot-path counters.
+//
+// CEN64: Cycle-Accurate Nintendo 64 Emulator.
+// Copyright (C) 2015, Tyler J. Stachecki.
+//
+// This file is subject to the terms and conditions defined in
+// 'LICENSE', which is part of this source code package.
+//
+
+#ifndef __common_stats_h__
+#define __common_stats_h__
+#include "common.h"
+
+#define CEN64_STATS_MAX_MAPPINGS 32
+#define CEN64_STATS_RDP_COMMANDS 64
+
+// The probes compile away to nothing unless CEN64_STATS is set,
+// so they can be left in even the hottest of paths. Counters are
+// not atomic: with -multithread, a few counts may be lost when
+// both threads touch the bus at once.
+#ifdef CEN64_STATS
+#define stats_add(counter, n) (cen64_stats.counter += (n))
+#define stats_inc(counter) (cen64_stats.counter++)
+#else
+#define stats_add(counter, n) do {} while (0)
+#define stats_inc(counter) do {} while (0)
+#endif
+
+struct cen64_stats {
+#define X(counter) unsigned long long counter;
+#include "common/stats.md"
+#undef X
+
+  unsigned long long bus_reads[CEN64_STATS_MAX_MAPPINGS];
+  unsigned long long bus_writes[CEN64_STATS_MAX_MAPPINGS];
+  unsigned long long rdp_command_counts[CEN64_STATS_RDP_COMMANDS];
+};
+
+extern struct cen64_stats cen64_stats;
+
+cen64_cold void stats_print(FILE *f);
+cen64_cold int stats_write_json(const char *path);
+
+#endif
+
@@ -120,11 +120,10 @@ static void get_dd_time(uint8_t *out);
 
 // Initializes the DD.
 int dd_init(struct dd_controller *dd, struct bus_controller *bus,
-  const uint8_t *ddipl, const uint8_t *ddrom, size_t ddrom_size) {
+  const uint8_t *ddipl, struct dd_disk *disk) {
   dd->bus = bus;
   dd->ipl_rom = ddipl;
-  dd->rom = ddrom;
-  dd->rom_size = ddrom_size;
+  dd->disk = disk;
 
   dd->retail = true;
   dd->regs[DD_ASIC_ID_REG] = 0x00030000;
@@ -149,7 +148,7 @@ int read_dd_regs(void *opaque, uint32_t address, uint32_t *word) {
 
   switch (reg) {
     case DD_ASIC_CMD_STATUS:
-      if (dd->rom != NULL)
+      if (dd->disk != NULL)
         dd->regs[DD_ASIC_CMD_STATUS] |= DD_STATUS_DISK_PRES;
       else
         dd->regs[DD_ASIC_CMD_STATUS] &= ~DD_STATUS_DISK_PRES;
@@ -307,14 +306,14 @@ void dd_pi_write(void *opaque, uint32_t address) {
   struct dd_controller *dd = opaque;
 
   // clear DATA RQ
-  if (address == DD_DS_BUFFER_ADDRESS && dd->rom != NULL) {
+  if (address == DD_DS_BUFFER_ADDRESS && dd->disk != NULL) {
     dd->regs[DD_ASIC_CMD_STATUS] &= ~DD_STATUS_DATA_RQ;
     dd->regs[DD_ASIC_CMD_STATUS] &= ~DD_STATUS_BM_INT;
     clear_dd_interrupt(dd->bus->vr4300);
   }
 
   // clear C2
-  else if (address == DD_C2S_BUFFER_ADDRESS && dd->rom != NULL) {
+  else if (address == DD_C2S_BUFFER_ADDRESS && dd->disk != NULL) {
     dd->regs[DD_ASIC_CMD_STATUS] &= ~DD_STATUS_C2_XFER;
     dd->regs[DD_ASIC_CMD_STATUS] &= ~DD_STATUS_BM_INT;
     clear_dd_interrupt(dd->bus->vr4300);
@@ -344,7 +343,7 @@ int dd_dma_read(void *opaque, uint32_t source, uint32_t dest, uint32_t length) {
 
   // data buffer
   if (dest == DD_DS_BUFFER_ADDRESS) {
-    memcpy(dd->ds_buffer, dd->bus->ri->ram + source, length);
+    ri_copy_from_rdram(dd->bus->ri, source, dd->ds_buffer, length);
     dd_update_bm(dd);
   }
 
@@ -352,7 +351,7 @@ int dd_dma_read(void *opaque, uint32_t source, uint32_t dest, uint32_t length) {
   else if (dest == DD_MS_RAM_ADDRESS) {
     uint32_t offset = dest - DD_MS_RAM_ADDRESS;
     assert(offset + length <= DD_MS_RAM_LEN);
-    memcpy(dd->ms_ram + offset, dd->bus->ri->ram + source, length);
+    ri_copy_from_rdram(dd->bus->ri, source, dd->ms_ram + offset, length);
   }
 
   else
@@ -367,7 +366,7 @@ int dd_dma_write(void *opaque, uint32_t source, uint32_t dest, uint32_t length)
 
   // data buffer
   if (source == DD_DS_BUFFER_ADDRESS) {
-    memcpy(dd->bus->ri->ram + dest, dd->ds_buffer, length);
+    ri_copy_to_rdram(dd->bus->ri, dest, dd->ds_buffer, length);
     dd_update_bm(dd);
   }
 
@@ -513,15 +512,16 @@ void dd_update_bm(struct dd_controller *dd) {
   signal_dd_interrupt(dd->bus->vr4300);
 }
 
+// Writes the sector before the current one: its data is requested
+// (and DMA'd into the buffer) before the sector counter advances.
 void dd_write_sector(struct dd_controller *dd) {
-  // TODO actually write data
-  /*
   uint32_t offset = dd->track_offset +
     dd->start_block * SECTORS_PER_BLOCK * zone_sec_size[dd->zone] +
-    dd->regs[DD_ASIC_CUR_SECTOR] * zone_sec_size[dd->zone];
+    (dd->regs[DD_ASIC_CUR_SECTOR] - 1) * zone_sec_size[dd->zone];
 
-  memcpy(dd->ds_buffer, dd->rom + offset, zone_sec_size[dd->zone]);
-  */
+  if (dd_disk_write_sector(dd->disk, offset,
+    dd->ds_buffer, zone_sec_size[dd->zone]))
+    debug("dd: Failed to write sector at 0x%.8X\n", offset);
 }
 
 void dd_read_sector(struct dd_controller *dd) {
@@ -529,7 +529,8 @@ void dd_read_sector(struct dd_controller *dd) {
     dd->start_block * SECTORS_PER_BLOCK * zone_sec_size[dd->zone] +
     dd->regs[DD_ASIC_CUR_SECTOR] * zone_sec_size[dd->zone];
 
-  memcpy(dd->ds_buffer, dd->rom + offset, zone_sec_size[dd->zone]);
+  dd_disk_read_sector(dd->disk, offset,
+    dd->ds_buffer, zone_sec_size[dd->zone]);
 }
 
 // This magic brought to you by Happy_
@@ -12,6 +12,7 @@
 #define __dd_controller_h__
 #include "common.h"
 #include "bus/address.h"
+#include "dd/disk.h"
 #include "device/sha1.h"
 #include "os/common/rom_file.h"
 
@@ -39,8 +40,7 @@ const struct dd_variant *dd_identify_variant(struct rom_file *ipl);
 struct dd_controller {
   struct bus_controller *bus;
   const uint8_t *ipl_rom;
-  const uint8_t *rom;
-  size_t rom_size;
+  struct dd_disk *disk;
   bool retail;
 
   bool write;
@@ -56,7 +56,7 @@ struct dd_controller {
 };
 
 cen64_cold int dd_init(struct dd_controller *dd, struct bus_controller *bus,
-  const uint8_t *ddipl, const uint8_t *ddrom, size_t ddrom_size);
+  const uint8_t *ddipl, struct dd_disk *disk);
 
 void dd_pi_write(void *opaque, uint32_t address);
 
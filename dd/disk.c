@@ -0,0 +1,419 @@
+//
+// dd/disk.c: DD disk image access.
+//
+// CEN64: Cycle-Accurate Nintendo 64 Emulator.
+// Copyright (C) 2015, Tyler J. Stachecki.
+//
+// This file is subject to the terms and conditions defined in
+// 'LICENSE', which is part of this source code package.
+//
+
+#include "common.h"
+#include "dd/disk.h"
+#include <stdlib.h>
+
+#ifdef CEN64_ZLIB
+#include <zlib.h>
+#endif
+
+#define DD_JOURNAL_MAGIC "CEN64DDJ"
+#define DD_JOURNAL_MAGIC_LEN 8
+#define DD_JOURNAL_RECORD_LEN 6
+
+static int dd_disk_open_image(struct dd_disk *disk);
+static int dd_disk_fill_chunk(struct dd_disk *disk,
+  uint32_t chunk, uint8_t *dest);
+#ifdef CEN64_ZLIB
+static int dd_disk_inflate_to(struct dd_disk *disk,
+  uint32_t end, uint8_t *scratch);
+#endif
+static uint8_t *dd_disk_overlay_find(const struct dd_disk *disk,
+  uint32_t offset);
+static int dd_disk_overlay_grow(struct dd_disk *disk);
+static uint8_t *dd_disk_overlay_insert(struct dd_disk *disk,
+  uint32_t offset);
+static int dd_disk_replay_journal(struct dd_disk *disk);
+
+// Opens a disk image and, if given, its journal. Nothing is read up
+// front: sectors are streamed in as the drive asks for them. gzip'd
+// images are inflated forward on demand into an unnamed temporary
+// file, as seeking backwards in the stream means starting over.
+int dd_disk_open(struct dd_disk *disk,
+  const char *path, const char *journal_path) {
+  memset(disk, 0, sizeof(*disk));
+
+  if ((disk->path = strdup(path)) == NULL)
+    return -1;
+
+  if (dd_disk_open_image(disk)) {
+    dd_disk_close(disk);
+    return -1;
+  }
+
+  disk->cache_tags = calloc(DD_DISK_CACHE_CHUNKS, sizeof(*disk->cache_tags));
+  disk->cache = malloc(DD_DISK_CACHE_CHUNKS * DD_DISK_CHUNK_SIZE);
+
+  if (disk->cache_tags == NULL || disk->cache == NULL ||
+    dd_disk_overlay_grow(disk)) {
+    dd_disk_close(disk);
+    return -1;
+  }
+
+  if (journal_path != NULL) {
+    if ((disk->journal = fopen(journal_path, "a+b")) == NULL) {
+      printf("Failed to open DD journal: %s.\n", journal_path);
+      dd_disk_close(disk);
+      return -1;
+    }
+
+    if (dd_disk_replay_journal(disk)) {
+      printf("DD journal is not valid: %s.\n", journal_path);
+      dd_disk_close(disk);
+      return -1;
+    }
+  }
+
+  return 0;
+}
+
+// Opens the image at disk->path, or a spill file and an inflate
+// stream for it if it's gzip'd.
+int dd_disk_open_image(struct dd_disk *disk) {
+  uint8_t magic[2] = {0, 0};
+  long size;
+
+  if ((disk->image = fopen(disk->path, "rb")) == NULL)
+    return -1;
+
+  // gzip'd images are recognized by their magic number.
+  if (fread(magic, sizeof(magic), 1, disk->image) == 1 &&
+    magic[0] == 0x1F && magic[1] == 0x8B) {
+#ifdef CEN64_ZLIB
+    fclose(disk->image);
+
+    if ((disk->image = tmpfile()) == NULL ||
+      (disk->gz_image = gzopen(disk->path, "rb")) == NULL)
+      return -1;
+
+    gzbuffer((gzFile) disk->gz_image, DD_DISK_CHUNK_SIZE * 4);
+    disk->inflated = 0;
+    disk->size = 0xFFFFFFFFU;
+#else
+    printf("DD disk image is compressed, but zlib support was not built.\n");
+    fclose(disk->image);
+    disk->image = NULL;
+    return -1;
+#endif
+  }
+
+  else {
+    if (fseek(disk->image, 0, SEEK_END) || (size = ftell(disk->image)) < 0)
+      return -1;
+
+    disk->size = (uint32_t) size;
+  }
+
+  return 0;
+}
+
+// Releases the image, journal and caches.
+void dd_disk_close(struct dd_disk *disk) {
+  if (disk->image)
+    fclose(disk->image);
+
+#ifdef CEN64_ZLIB
+  if (disk->gz_image)
+    gzclose((gzFile) disk->gz_image);
+#endif
+
+  if (disk->journal)
+    fclose(disk->journal);
+
+  free(disk->cache_tags);
+  free(disk->cache);
+  free(disk->overlay_keys);
+  free(disk->overlay_data);
+  free(disk->path);
+
+  memset(disk, 0, sizeof(*disk));
+}
+
+// Stops appending to the journal; later writes stay in memory. The
+// image (and its spill file and inflate stream) is reopened, so reads
+// don't move the file offsets of the process we were forked from. The
+// old streams are shared with it, so they are dropped rather than
+// closed.
+int dd_disk_detach(struct dd_disk *disk) {
+  disk->journal = NULL;
+  disk->image = NULL;
+  disk->gz_image = NULL;
+
+  return dd_disk_open_image(disk);
+}
+
+#ifdef CEN64_ZLIB
+// Inflates the compressed image up to end, appending to the spill file.
+int dd_disk_inflate_to(struct dd_disk *disk, uint32_t end, uint8_t *scratch) {
+  while (disk->inflated < end) {
+    int len;
+
+    if ((len = gzread((gzFile) disk->gz_image,
+      scratch, DD_DISK_CHUNK_SIZE)) < 0)
+      return -1;
+
+    if (len == 0) {
+      disk->size = disk->inflated;
+      break;
+    }
+
+    if (fseek(disk->image, 0, SEEK_END) ||
+      fwrite(scratch, len, 1, disk->image) != 1)
+      return -1;
+
+    disk->inflated += len;
+  }
+
+  return 0;
+}
+#endif
+
+// Reads one chunk of the image; anything past its end reads as zero.
+int dd_disk_fill_chunk(struct dd_disk *disk, uint32_t chunk, uint8_t *dest) {
+  uint32_t offset = chunk << DD_DISK_CHUNK_SHIFT;
+  size_t got = 0;
+
+#ifdef CEN64_ZLIB
+  if (disk->gz_image && dd_disk_inflate_to(disk,
+    offset + DD_DISK_CHUNK_SIZE, dest))
+    return -1;
+#endif
+
+  if (offset < disk->size) {
+    if (fseek(disk->image, offset, SEEK_SET))
+      return -1;
+
+    got = fread(dest, 1, DD_DISK_CHUNK_SIZE, disk->image);
+  }
+
+  memset(dest + got, 0, DD_DISK_CHUNK_SIZE - got);
+  return 0;
+}
+
+// Reads a sector, preferring the overlay over the image.
+void dd_disk_read_sector(struct dd_disk *disk,
+  uint32_t offset, uint8_t *buf, unsigned size) {
+  const uint8_t *written;
+
+  if ((written = dd_disk_overlay_find(disk, offset)) != NULL) {
+    memcpy(buf, written, size);
+    return;
+  }
+
+  // Sectors aren't a power of two, so they can straddle chunks.
+  while (size > 0) {
+    uint32_t chunk = offset >> DD_DISK_CHUNK_SHIFT;
+    uint32_t chunk_offset = offset & (DD_DISK_CHUNK_SIZE - 1);
+    unsigned slot = chunk & (DD_DISK_CACHE_CHUNKS - 1);
+    uint8_t *data = disk->cache + slot * DD_DISK_CHUNK_SIZE;
+    unsigned len = DD_DISK_CHUNK_SIZE - chunk_offset;
+
+    if (len > size)
+      len = size;
+
+    if (disk->cache_tags[slot] != chunk + 1) {
+      if (dd_disk_fill_chunk(disk, chunk, data)) {
+        debug("dd: Failed to read the disk image at 0x%.8X\n", offset);
+
+        disk->cache_tags[slot] = 0;
+        memset(buf, 0, size);
+        return;
+      }
+
+      disk->cache_tags[slot] = chunk + 1;
+    }
+
+    memcpy(buf, data + chunk_offset, len);
+    offset += len;
+    buf += len;
+    size -= len;
+  }
+}
+
+// Writes a sector to the overlay and appends it to the journal.
+int dd_disk_write_sector(struct dd_disk *disk,
+  uint32_t offset, const uint8_t *buf, unsigned size) {
+  uint8_t record[DD_JOURNAL_RECORD_LEN];
+  uint8_t *data;
+
+  assert(size <= DD_DISK_MAX_SECTOR_SIZE);
+
+  if ((data = dd_disk_overlay_insert(disk, offset)) == NULL)
+    return -1;
+
+  memcpy(data, buf, size);
+
+  if (disk->journal == NULL)
+    return 0;
+
+  record[0] = offset >> 24;
+  record[1] = offset >> 16;
+  record[2] = offset >> 8;
+  record[3] = offset;
+  record[4] = size >> 8;
+  record[5] = size;
+
+  if (fwrite(record, sizeof(record), 1, disk->journal) != 1 ||
+    fwrite(buf, size, 1, disk->journal) != 1 ||
+    fflush(disk->journal)) {
+    printf("Failed to append to the DD journal.\n");
+    return -1;
+  }
+
+  return 0;
+}
+
+// Finds the overlay slot of a written sector.
+uint8_t *dd_disk_overlay_find(const struct dd_disk *disk, uint32_t offset) {
+  unsigned i = (offset * 0x9E3779B1U) >> 8 & disk->overlay_mask;
+
+  if (disk->overlay_count == 0)
+    return NULL;
+
+  while (disk->overlay_keys[i]) {
+    if (disk->overlay_keys[i] == offset + 1)
+      return disk->overlay_data + i * DD_DISK_MAX_SECTOR_SIZE;
+
+    i = (i + 1) & disk->overlay_mask;
+  }
+
+  return NULL;
+}
+
+// Doubles the overlay (or allocates its first table).
+int dd_disk_overlay_grow(struct dd_disk *disk) {
+  unsigned old_size = disk->overlay_keys ? disk->overlay_mask + 1 : 0;
+  unsigned new_size = old_size ? old_size * 2 : 256;
+  uint32_t *old_keys = disk->overlay_keys;
+  uint8_t *old_data = disk->overlay_data;
+  unsigned i;
+
+  disk->overlay_keys = calloc(new_size, sizeof(*disk->overlay_keys));
+  disk->overlay_data = malloc(new_size * DD_DISK_MAX_SECTOR_SIZE);
+
+  if (disk->overlay_keys == NULL || disk->overlay_data == NULL) {
+    free(disk->overlay_keys);
+    free(disk->overlay_data);
+
+    disk->overlay_keys = old_keys;
+    disk->overlay_data = old_data;
+    return -1;
+  }
+
+  disk->overlay_mask = new_size - 1;
+  disk->overlay_count = 0;
+
+  for (i = 0; i < old_size; i++) {
+    if (old_keys[i]) {
+      memcpy(dd_disk_overlay_insert(disk, old_keys[i] - 1),
+        old_data + i * DD_DISK_MAX_SECTOR_SIZE, DD_DISK_MAX_SECTOR_SIZE);
+    }
+  }
+
+  free(old_keys);
+  free(old_data);
+  return 0;
+}
+
+// Returns the overlay slot for a sector, claiming one if needed.
+uint8_t *dd_disk_overlay_insert(struct dd_disk *disk, uint32_t offset) {
+  unsigned i = (offset * 0x9E3779B1U) >> 8 & disk->overlay_mask;
+
+  while (disk->overlay_keys[i]) {
+    if (disk->overlay_keys[i] == offset + 1)
+      return disk->overlay_data + i * DD_DISK_MAX_SECTOR_SIZE;
+
+    i = (i + 1) & disk->overlay_mask;
+  }
+
+  // Keep the table at most half full.
+  if ((disk->overlay_count + 1) * 2 > disk->overlay_mask + 1) {
+    if (dd_disk_overlay_grow(disk))
+      return NULL;
+
+    return dd_disk_overlay_insert(disk, offset);
+  }
+
+  disk->overlay_keys[i] = offset + 1;
+  disk->overlay_count++;
+
+  return disk->overlay_data + i * DD_DISK_MAX_SECTOR_SIZE;
+}
+
+// Loads the sectors recorded in the journal, or stamps a new one. A
+// record torn by a crash is padded out and followed by one restoring
+// the sector's prior contents, so the journal stays parseable.
+int dd_disk_replay_journal(struct dd_disk *disk) {
+  uint8_t magic[DD_JOURNAL_MAGIC_LEN];
+  uint8_t record[DD_JOURNAL_RECORD_LEN];
+  uint8_t sector[DD_DISK_MAX_SECTOR_SIZE];
+  size_t got;
+
+  rewind(disk->journal);
+
+  if ((got = fread(magic, 1, sizeof(magic), disk->journal)) == 0) {
+    if (fseek(disk->journal, 0, SEEK_END) || fwrite(DD_JOURNAL_MAGIC,
+      DD_JOURNAL_MAGIC_LEN, 1, disk->journal) != 1)
+      return -1;
+
+    return fflush(disk->journal) ? -1 : 0;
+  }
+
+  if (got != sizeof(magic) || memcmp(magic, DD_JOURNAL_MAGIC, sizeof(magic)))
+    return -1;
+
+  while ((got = fread(record, 1, sizeof(record), disk->journal)) > 0) {
+    uint32_t offset;
+    unsigned size;
+    uint8_t *data;
+
+    // Sizes fit in a byte, so a torn header pads out to a no-op.
+    if (got < sizeof(record)) {
+      memset(sector, 0, sizeof(sector));
+
+      if (fseek(disk->journal, 0, SEEK_END) || fwrite(sector,
+        sizeof(record) - got, 1, disk->journal) != 1)
+        return -1;
+
+      break;
+    }
+
+    offset = (uint32_t) record[0] << 24 | record[1] << 16 |
+      record[2] << 8 | record[3];
+    size = record[4] << 8 | record[5];
+
+    if (size > DD_DISK_MAX_SECTOR_SIZE)
+      return -1;
+
+    if (size == 0)
+      continue;
+
+    if ((got = fread(sector, 1, size, disk->journal)) < size) {
+      memset(sector, 0, sizeof(sector));
+
+      if (fseek(disk->journal, 0, SEEK_END) || fwrite(sector,
+        size - got, 1, disk->journal) != 1)
+        return -1;
+
+      dd_disk_read_sector(disk, offset, sector, size);
+      return dd_disk_write_sector(disk, offset, sector, size);
+    }
+
+    if ((data = dd_disk_overlay_insert(disk, offset)) == NULL)
+      return -1;
+
+    memcpy(data, sector, size);
+  }
+
+  return fseek(disk->journal, 0, SEEK_END) || fflush(disk->journal) ? -1 : 0;
+}
+
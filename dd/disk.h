@@ -0,0 +1,55 @@
+//
+// dd/disk.h: DD disk image access.
+//
+// CEN64: Cycle-Accurate Nintendo 64 Emulator.
+// Copyright (C) 2015, Tyler J. Stachecki.
+//
+// This file is subject to the terms and conditions defined in
+// 'LICENSE', which is part of this source code package.
+//
+
+#ifndef __dd_disk_h__
+#define __dd_disk_h__
+#include "common.h"
+#include <stdio.h>
+
+// The image is streamed through a direct-mapped cache of chunks.
+#define DD_DISK_CHUNK_SHIFT 14
+#define DD_DISK_CHUNK_SIZE (1U << DD_DISK_CHUNK_SHIFT)
+#define DD_DISK_CACHE_CHUNKS 64
+
+// Largest sector of any zone (zone 0).
+#define DD_DISK_MAX_SECTOR_SIZE 232
+
+struct dd_disk {
+  char *path;
+  FILE *image;
+  void *gz_image;
+  uint32_t inflated;
+  uint32_t size;
+
+  uint32_t *cache_tags;
+  uint8_t *cache;
+
+  // Written sectors never reach the image: they live in an overlay,
+  // keyed by image offset, that is replayed from (and appended to) an
+  // optional journal file.
+  FILE *journal;
+  uint32_t *overlay_keys;
+  uint8_t *overlay_data;
+  unsigned overlay_count;
+  unsigned overlay_mask;
+};
+
+cen64_cold int dd_disk_open(struct dd_disk *disk,
+  const char *path, const char *journal_path);
+cen64_cold void dd_disk_close(struct dd_disk *disk);
+cen64_cold int dd_disk_detach(struct dd_disk *disk);
+
+void dd_disk_read_sector(struct dd_disk *disk,
+  uint32_t offset, uint8_t *buf, unsigned size);
+int dd_disk_write_sector(struct dd_disk *disk,
+  uint32_t offset, const uint8_t *buf, unsigned size);
+
+#endif
+
@@ -10,7 +10,7 @@
 
 #include "common.h"
 #include "device/device.h"
-#include "device/netapi.h"
+#include "device/profiler.h"
 #include "fpu/fpu.h"
 #include "gl_window.h"
 #include "os/common/rom_file.h"
@@ -24,15 +24,20 @@
 #include "si/controller.h"
 #include "rsp/cpu.h"
 #include "thread.h"
+#include "timer.h"
 #include "vi/controller.h"
 #include "vr4300/cpu.h"
 #include "vr4300/cp1.h"
 #include <setjmp.h>
 
 cen64_cold int angrylion_rdp_init(struct cen64_device *device);
-cen64_cold static int device_debug_spin(struct cen64_device *device);
+cen64_cold static void device_lockstep_hook(struct cen64_device *device);
 cen64_cold static int device_multithread_spin(struct cen64_device *device);
+cen64_cold static void device_profile_hook(struct cen64_device *device);
 cen64_flatten cen64_hot static int device_spin(struct cen64_device *device);
+cen64_cold static void device_spin_hook(struct cen64_device *device);
+cen64_flatten cen64_hot static int device_spin_hooked(
+  struct cen64_device *device);
 
 cen64_flatten cen64_hot static CEN64_THREAD_RETURN_TYPE run_rcp_thread(void *);
 cen64_flatten cen64_hot static CEN64_THREAD_RETURN_TYPE run_vr4300_thread(void *);
@@ -40,7 +45,7 @@ cen64_flatten cen64_hot static CEN64_THREAD_RETURN_TYPE run_vr4300_thread(void *
 // Creates and initializes a device.
 struct cen64_device *device_create(struct cen64_device *device,
   const struct rom_file *ddipl, const struct dd_variant *dd_variant,
-  const struct rom_file *ddrom,
+  struct dd_disk *ddrom,
   const struct rom_file *pifrom, const struct rom_file *cart,
   const struct save_file *eeprom, const struct save_file *sram,
   const struct save_file *flashram, const struct is_viewer *is,
@@ -73,7 +78,7 @@ struct cen64_device *device_create(struct cen64_device *device,
 
   // Initialize the DD.
   if (dd_init(&device->dd, &device->bus,
-    ddipl->ptr, ddrom->ptr, ddrom->size)) {
+    ddipl->ptr, ddrom)) {
     debug("create_device: Failed to initialize the DD.\n");
     return NULL;
   }
@@ -147,12 +152,21 @@ void device_run(struct cen64_device *device) {
   rsp_late_init(&device->rsp);
 
   // Spin the device until we return (from setjmp).
-  if (unlikely(device->debug_sfd > 0))
-    device_debug_spin(device);
-
-  else if (device->multithread)
+  if (device->multithread)
     device_multithread_spin(device);
 
+  else if (device->lockstep) {
+    device->spin_hook = device_lockstep_hook;
+    device->spin_interval = device->lockstep->interval;
+    device_spin_hooked(device);
+  }
+
+  else if (device->profiler) {
+    device->spin_hook = device_profile_hook;
+    device->spin_interval = device->profiler->interval;
+    device_spin_hooked(device);
+  }
+
   else
     device_spin(device);
 
@@ -178,8 +192,14 @@ CEN64_THREAD_RETURN_TYPE run_rcp_thread(void *opaque) {
     cen64_mutex_lock(&device->sync_mutex);
 
     if (!device->other_thread_is_waiting) {
+      cen64_time start, end;
+
+      get_time(&start);
       device->other_thread_is_waiting = true;
       cen64_cv_wait(&device->sync_cv, &device->sync_mutex);
+      get_time(&end);
+
+      device->rcp_wait_ns += compute_time_difference(&end, &start);
     }
 
     else {
@@ -195,6 +215,11 @@ CEN64_THREAD_RETURN_TYPE run_rcp_thread(void *opaque) {
 CEN64_THREAD_RETURN_TYPE run_vr4300_thread(void *opaque) {
   struct cen64_device *device = (struct cen64_device *) opaque;
 
+  if (device->thread_policy) {
+    cen64_thread_apply_policy(CEN64_THREAD_VR4300,
+      device->thread_policy + CEN64_THREAD_VR4300);
+  }
+
   while (likely(device->running)) {
     unsigned i, j;
 
@@ -211,9 +236,19 @@ CEN64_THREAD_RETURN_TYPE run_vr4300_thread(void *opaque) {
     // Sync up with the RCP thread.
     cen64_mutex_lock(&device->sync_mutex);
 
-    if (!device->other_thread_is_waiting) {
+    // The RCP thread is gone (see device_multithread_spin).
+    if (unlikely(!device->running))
+      cen64_mutex_unlock(&device->sync_mutex);
+
+    else if (!device->other_thread_is_waiting) {
+      cen64_time start, end;
+
+      get_time(&start);
       device->other_thread_is_waiting = true;
       cen64_cv_wait(&device->sync_cv, &device->sync_mutex);
+      get_time(&end);
+
+      device->vr4300_wait_ns += compute_time_difference(&end, &start);
     }
 
     else {
@@ -252,6 +287,13 @@ int device_multithread_spin(struct cen64_device *device) {
 
   run_rcp_thread(device);
 
+  // The RCP thread only returns when we're leaving simulation;
+  // make sure the VR4300 thread doesn't wait on it forever.
+  cen64_mutex_lock(&device->sync_mutex);
+  device->running = false;
+  cen64_mutex_unlock(&device->sync_mutex);
+  cen64_cv_signal(&device->sync_cv);
+
   cen64_thread_join(&vr4300_thread);
   cen64_cv_destroy(&device->sync_cv);
   cen64_mutex_destroy(&device->sync_mutex);
@@ -272,7 +314,6 @@ int device_spin(struct cen64_device *device) {
       ai_cycle(&device->ai);
       pi_cycle(&device->pi);
       vi_cycle(&device->vi);
-
     }
 
     vr4300_cycle(&device->vr4300);
@@ -281,13 +322,10 @@ int device_spin(struct cen64_device *device) {
   return 0;
 }
 
-// Continually cycles the device until setjmp returns.
-int device_debug_spin(struct cen64_device *device) {
-  struct vr4300_stats vr4300_stats;
-
-  // Prepare stats, set a breakpoint @ VR4300 IPL vector.
-  memset(&vr4300_stats, 0, sizeof(vr4300_stats));
-  netapi_debug_wait(device->debug_sfd, device);
+// Same as device_spin, but calls spin_hook every spin_interval
+// iterations. Kept apart so that the plain loop doesn't pay for it.
+int device_spin_hooked(struct cen64_device *device) {
+  device->spin_countdown = device->spin_interval;
 
   if (setjmp(device->bus.unwind_data))
     return 1;
@@ -301,15 +339,29 @@ int device_debug_spin(struct cen64_device *device) {
       ai_cycle(&device->ai);
       pi_cycle(&device->pi);
       vi_cycle(&device->vi);
-
-      vr4300_cycle_extra(&device->vr4300, &vr4300_stats);
-
     }
 
     vr4300_cycle(&device->vr4300);
-    vr4300_cycle_extra(&device->vr4300, &vr4300_stats);
+
+    if (unlikely(--device->spin_countdown == 0))
+      device_spin_hook(device);
   }
 
   return 0;
 }
 
+// Runs the -lockstep comparison.
+void device_lockstep_hook(struct cen64_device *device) {
+  lockstep_check(device->lockstep, device);
+}
+
+// Takes a -profile sample.
+void device_profile_hook(struct cen64_device *device) {
+  profiler_sample(device->profiler, device);
+}
+
+// Rearms the countdown and calls the hook.
+void device_spin_hook(struct cen64_device *device) {
+  device->spin_countdown = device->spin_interval;
+  device->spin_hook(device);
+}
@@ -11,9 +11,12 @@
 #ifndef __device_h__
 #define __device_h__
 #include "common.h"
+#include "device/lockstep.h"
 #include "device/options.h"
+#include "device/profiler.h"
 #include "os/common/rom_file.h"
 #include "os/common/save_file.h"
+#include "os/common/thread_policy.h"
 
 #include "ai/controller.h"
 #include "bus/controller.h"
@@ -44,20 +47,31 @@ struct cen64_device {
   struct rdp rdp;
   struct rsp rsp;
 
-  int debug_sfd;
+  struct cen64_profiler *profiler;
+  struct cen64_lockstep *lockstep;
+
+  // Called every spin_interval device_spin_hooked() iterations.
+  void (*spin_hook)(struct cen64_device *device);
+  unsigned spin_interval;
+  unsigned spin_countdown;
+  const struct cen64_thread_policy *thread_policy;
 
   bool multithread;
   bool other_thread_is_waiting;
   cen64_mutex sync_mutex;
   cen64_cv sync_cv;
 
+  // Time each -multithread thread spent waiting on the other.
+  unsigned long long rcp_wait_ns;
+  unsigned long long vr4300_wait_ns;
+
   bool running;
 };
 
 cen64_cold void device_destroy(struct cen64_device *device);
 cen64_cold struct cen64_device *device_create(struct cen64_device *device,
   const struct rom_file *ddipl, const struct dd_variant *dd_variant,
-  const struct rom_file *ddrom,
+  struct dd_disk *ddrom,
   const struct rom_file *pifrom, const struct rom_file *cart,
   const struct save_file *eeprom, const struct save_file *sram,
   const struct save_file *flashram, const struct is_viewer *is,
@@ -0,0 +1,255 @@
+//
+// device/lockstep.c: Lockstep comparison against a reference instance.
+//
+// CEN64: Cycle-Accurate Nintendo 64 Emulator.
+// Copyright (C) 2015, Tyler J. Stachecki.
+//
+// This file is subject to the terms and conditions defined in
+// 'LICENSE', which is part of this source code package.
+//
+
+#include "common.h"
+#include "device/device.h"
+#include "device/lockstep.h"
+#include "device/options.h"
+#include "os/common/lockstep.h"
+#include "rsp/cp0.h"
+#include "rsp/cpu.h"
+#include "vr4300/cpu.h"
+
+#define LOCKSTEP_MAX_PAGE_DIFFS 16
+
+static const char *lockstep_gpr_names[32] = {
+  "r0", "at", "v0", "v1", "a0", "a1", "a2", "a3",
+  "t0", "t1", "t2", "t3", "t4", "t5", "t6", "t7",
+  "s0", "s1", "s2", "s3", "s4", "s5", "s6", "s7",
+  "t8", "t9", "k0", "k1", "gp", "sp", "fp", "ra",
+};
+
+static void lockstep_capture(struct lockstep_state *state,
+  const struct cen64_device *device, unsigned long long cycle,
+  bool full, uint32_t generation);
+static uint64_t lockstep_hash_page(const uint8_t *page);
+
+static void lockstep_print_diff(const struct lockstep_state *reference,
+  const struct lockstep_state *state);
+static void lockstep_register_name(unsigned reg, char *buf, size_t size);
+
+// Snapshots the architectural state of the device. Unless full is
+// set, only pages written since generation are rehashed.
+void lockstep_capture(struct lockstep_state *state,
+  const struct cen64_device *device, unsigned long long cycle,
+  bool full, uint32_t generation) {
+  const struct vr4300 *vr4300 = &device->vr4300;
+  const struct rsp *rsp = &device->rsp;
+  unsigned i;
+
+  state->cycle = cycle;
+  state->pc = vr4300->pipeline.dcwb_latch.common.pc;
+
+  memcpy(state->regs, vr4300->regs, sizeof(state->regs));
+  state->regs[VR4300_CP0_REGISTER_COUNT] = vr4300_get_count(vr4300);
+
+  state->mi_intr = vr4300->mi_regs[MI_INTR_REG];
+  state->mi_intr_mask = vr4300->mi_regs[MI_INTR_MASK_REG];
+  state->rsp_pc = rsp->pipeline.dfwb_latch.common.pc;
+  state->rsp_status = rsp->regs[RSP_CP0_REGISTER_SP_STATUS];
+
+  for (i = 0; i < LOCKSTEP_NUM_PAGES; i++) {
+    if (!full && !ri_written_since(&device->ri, i << LOCKSTEP_PAGE_SHIFT,
+      1U << LOCKSTEP_PAGE_SHIFT, generation))
+      continue;
+
+    state->rdram_hashes[i] = lockstep_hash_page(
+      device->ri.ram + (i << LOCKSTEP_PAGE_SHIFT));
+  }
+}
+
+// Hashes a page of RDRAM. Four lanes keep the multiplies independent.
+uint64_t lockstep_hash_page(const uint8_t *page) {
+  uint64_t h0 = 0xCBF29CE484222325ULL, h1 = h0, h2 = h0, h3 = h0;
+  unsigned i;
+
+  for (i = 0; i < (1U << LOCKSTEP_PAGE_SHIFT); i += 32) {
+    uint64_t w[4];
+
+    memcpy(w, page + i, sizeof(w));
+    h0 = (h0 ^ w[0]) * 0x100000001B3ULL;
+    h1 = (h1 ^ w[1]) * 0x100000001B3ULL;
+    h2 = (h2 ^ w[2]) * 0x100000001B3ULL;
+    h3 = (h3 ^ w[3]) * 0x100000001B3ULL;
+  }
+
+  return h0 ^ (h1 << 1 | h1 >> 63) ^
+    (h2 << 2 | h2 >> 62) ^ (h3 << 3 | h3 >> 61);
+}
+
+// Prepares the lockstep state. The interval is given in VR4300 pcycles
+// and converted to device_spin() iterations (3 pcycles apiece).
+void lockstep_init(struct cen64_lockstep *lockstep,
+  unsigned interval_cycles, unsigned long long start_cycle,
+  int channel, bool reference) {
+  memset(lockstep, 0, sizeof(*lockstep));
+
+  lockstep->start = start_cycle;
+  lockstep->interval = interval_cycles / 3 ? interval_cycles / 3 : 1;
+  lockstep->channel = channel;
+  lockstep->reference = reference;
+}
+
+// Turns the user's options into the reference configuration.
+void lockstep_reference_options(struct cen64_options *options) {
+  options->no_audio = true;
+  options->no_video = true;
+  options->turbo = true;
+
+  // Check the fast paths against the plain ones.
+  options->no_fast_paths = true;
+  options->texel_cache = false;
+
+  // Only the instance being checked answers the debugger.
+  options->enable_debugger = false;
+  options->print_stats = false;
+  options->stats_json_path = NULL;
+  options->telemetry_path = NULL;
+  options->profile_path = NULL;
+}
+
+// Names a slot of the VR4300 register file.
+void lockstep_register_name(unsigned reg, char *buf, size_t size) {
+  if (reg < VR4300_REGISTER_CP0_0)
+    snprintf(buf, size, "%s", lockstep_gpr_names[reg]);
+
+  else if (reg < VR4300_REGISTER_CP1_0)
+    snprintf(buf, size, "cp0[%u]", reg - VR4300_REGISTER_CP0_0);
+
+  else if (reg < VR4300_REGISTER_HI)
+    snprintf(buf, size, "f%u", reg - VR4300_REGISTER_CP1_0);
+
+  else if (reg == VR4300_REGISTER_HI)
+    snprintf(buf, size, "hi");
+
+  else if (reg == VR4300_REGISTER_LO)
+    snprintf(buf, size, "lo");
+
+  else if (reg == VR4300_CP1_FCR0)
+    snprintf(buf, size, "fcr0");
+
+  else
+    snprintf(buf, size, "fcr31");
+}
+
+// Prints every field that differs between the two instances.
+void lockstep_print_diff(const struct lockstep_state *reference,
+  const struct lockstep_state *state) {
+  unsigned i, page_diffs = 0;
+  char name[16];
+
+  printf("%16s  %18s  %18s\n", "", "reference", "this");
+
+  if (reference->pc != state->pc) {
+    printf("%16s: 0x%.16llX  0x%.16llX\n", "pc",
+      (unsigned long long) reference->pc, (unsigned long long) state->pc);
+  }
+
+  for (i = 0; i < PIPELINE_CYCLE_TYPE; i++) {
+    if (reference->regs[i] == state->regs[i])
+      continue;
+
+    lockstep_register_name(i, name, sizeof(name));
+    printf("%16s: 0x%.16llX  0x%.16llX\n", name,
+      (unsigned long long) reference->regs[i],
+      (unsigned long long) state->regs[i]);
+  }
+
+  if (reference->mi_intr != state->mi_intr) {
+    printf("%16s: 0x%.8X          0x%.8X\n", "MI_INTR_REG",
+      reference->mi_intr, state->mi_intr);
+  }
+
+  if (reference->mi_intr_mask != state->mi_intr_mask) {
+    printf("%16s: 0x%.8X          0x%.8X\n", "MI_INTR_MASK_REG",
+      reference->mi_intr_mask, state->mi_intr_mask);
+  }
+
+  if (reference->rsp_pc != state->rsp_pc) {
+    printf("%16s: 0x%.3X               0x%.3X\n", "rsp pc",
+      reference->rsp_pc, state->rsp_pc);
+  }
+
+  if (reference->rsp_status != state->rsp_status) {
+    printf("%16s: 0x%.8X          0x%.8X\n", "SP_STATUS",
+      reference->rsp_status, state->rsp_status);
+  }
+
+  for (i = 0; i < LOCKSTEP_NUM_PAGES; i++) {
+    if (reference->rdram_hashes[i] == state->rdram_hashes[i])
+      continue;
+
+    if (page_diffs++ < LOCKSTEP_MAX_PAGE_DIFFS) {
+      printf("%10s%.6X: 0x%.16llX  0x%.16llX\n", "rdram @ ",
+        i << LOCKSTEP_PAGE_SHIFT,
+        (unsigned long long) reference->rdram_hashes[i],
+        (unsigned long long) state->rdram_hashes[i]);
+    }
+  }
+
+  if (page_diffs > LOCKSTEP_MAX_PAGE_DIFFS) {
+    printf("%16s  (%u more RDRAM pages differ)\n", "",
+      page_diffs - LOCKSTEP_MAX_PAGE_DIFFS);
+  }
+}
+
+// Exchanges state with the peer, stopping the device on divergence
+// or once the peer has gone away.
+void lockstep_check(struct cen64_lockstep *lockstep,
+  struct cen64_device *device) {
+  unsigned long long interval_cycles = lockstep->interval * 3ULL;
+
+  if ((lockstep->cycles += interval_cycles) < lockstep->start)
+    return;
+
+  lockstep->intervals++;
+  lockstep_capture(&lockstep->local, device, lockstep->cycles,
+    lockstep->intervals == 1, lockstep->generation);
+  lockstep->generation = ri_close_generation(&device->ri);
+
+  if (lockstep->reference) {
+    if (cen64_lockstep_write(lockstep->channel,
+      &lockstep->local, sizeof(lockstep->local)))
+      device_exit(&device->bus);
+
+    return;
+  }
+
+  if (cen64_lockstep_read(lockstep->channel,
+    &lockstep->peer, sizeof(lockstep->peer))) {
+    printf("Lockstep: reference instance stopped at interval %lu.\n",
+      lockstep->intervals);
+
+    device_exit(&device->bus);
+  }
+
+  if (memcmp(&lockstep->local, &lockstep->peer, sizeof(lockstep->local))) {
+    unsigned long long last = lockstep->cycles - interval_cycles;
+
+    if (lockstep->interval == 1) {
+      printf("Lockstep: diverged from the reference at cycle %llu.\n",
+        lockstep->cycles);
+    }
+
+    else {
+      unsigned narrower = interval_cycles / LOCKSTEP_NARROWING_FACTOR;
+
+      printf("Lockstep: diverged from the reference between cycles "
+        "%llu and %llu.\n", last, lockstep->cycles);
+      printf("Lockstep: rerun with -lockstep %u -lockstep-start %llu "
+        "to narrow it down.\n", narrower > 3 ? narrower : 3, last);
+    }
+
+    lockstep_print_diff(&lockstep->peer, &lockstep->local);
+    lockstep->diverged = true;
+    device_exit(&device->bus);
+  }
+}
+
@@ -0,0 +1,75 @@
+//
+// device/lockstep.h: Lockstep comparison against a reference instance.
+//
+// CEN64: Cycle-Accurate Nintendo 64 Emulator.
+// Copyright (C) 2015, Tyler J. Stachecki.
+//
+// This file is subject to the terms and conditions defined in
+// 'LICENSE', which is part of this source code package.
+//
+
+#ifndef __device_lockstep_h__
+#define __device_lockstep_h__
+#include "common.h"
+#include "ri/controller.h"
+#include "vi/controller.h"
+#include "vr4300/cpu.h"
+
+// One field's worth of VR4300 cycles (3 for every 2 RCP cycles).
+#define LOCKSTEP_DEFAULT_INTERVAL ((unsigned) (VI_COUNTER_START * 3 / 2))
+
+// How much each rerun narrows the window around a divergence.
+#define LOCKSTEP_NARROWING_FACTOR 500
+
+#define LOCKSTEP_PAGE_SHIFT RDRAM_PAGE_SHIFT
+#define LOCKSTEP_NUM_PAGES RDRAM_NUM_PAGES
+
+struct cen64_device;
+struct cen64_options;
+
+// Architectural state exchanged at every interval.
+struct lockstep_state {
+  uint64_t cycle;
+  uint64_t pc;
+
+  // GPRs, CP0, CP1, HI/LO and the FCRs.
+  uint64_t regs[PIPELINE_CYCLE_TYPE];
+
+  uint32_t mi_intr;
+  uint32_t mi_intr_mask;
+  uint32_t rsp_pc;
+  uint32_t rsp_status;
+
+  uint64_t rdram_hashes[LOCKSTEP_NUM_PAGES];
+};
+
+struct cen64_lockstep {
+  struct lockstep_state local;
+  struct lockstep_state peer;
+
+  // Comparison period, in device_spin() iterations.
+  unsigned interval;
+
+  // Comparisons are skipped until this many pcycles have elapsed.
+  unsigned long long start;
+  unsigned long long cycles;
+  unsigned long intervals;
+  int channel;
+
+  // RDRAM generation closed at the last capture.
+  uint32_t generation;
+
+  bool reference;
+  bool diverged;
+};
+
+cen64_cold void lockstep_init(struct cen64_lockstep *lockstep,
+  unsigned interval_cycles, unsigned long long start_cycle,
+  int channel, bool reference);
+cen64_cold void lockstep_reference_options(struct cen64_options *options);
+
+cen64_cold void lockstep_check(struct cen64_lockstep *lockstep,
+  struct cen64_device *device);
+
+#endif
+
@@ -15,40 +15,125 @@
 #include <windows.h>
 #include <ws2tcpip.h>
 #else
+#include <errno.h>
 #include <netdb.h>
 #include <sys/socket.h>
 #include <sys/types.h>
+#include <sys/uio.h>
 #include <unistd.h>
 #endif
 
 #include "device/device.h"
 #include "device/netapi.h"
+#include "rsp/decoder.h"
+#include "vr4300/cp0.h"
 #include "vr4300/cpu.h"
 #include "vr4300/pipeline.h"
 
 // TODO: Really sloppy.
 #ifdef __WIN32__
 #define close(x) closesocket(x)
+#define SHUT_RDWR SD_BOTH
+#endif
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+#ifdef _WIN32
+typedef WSABUF netapi_iovec;
+#define netapi_iov_base buf
+#define netapi_iov_len len
+#else
+typedef struct iovec netapi_iovec;
+#define netapi_iov_base iov_base
+#define netapi_iov_len iov_len
+#endif
+
+// Units the N64 stores big-endian and we store in host order.
+#ifdef BIG_ENDIAN_HOST
+#define NETAPI_HOST_SWAP16 0
+#define NETAPI_HOST_SWAP32 0
+#else
+#define NETAPI_HOST_SWAP16 NETAPI_DEBUG_MEMORY_SWAP16
+#define NETAPI_HOST_SWAP32 NETAPI_DEBUG_MEMORY_SWAP32
+#endif
+
+#ifdef CEN64_NATIVE_RDRAM
+#define NETAPI_RDRAM_SWAP32 NETAPI_HOST_SWAP32
+#else
+#define NETAPI_RDRAM_SWAP32 0
 #endif
 
 #define NETAPI_DEBUG_MAGIC 0x40544A53U // "@TJS"
-#define NETAPI_DEBUG_VERSION 0U
+#define NETAPI_DEBUG_VERSION 1U
+#define NETAPI_DEBUG_DEFAULT_PORT "64646"
+#define NETAPI_DEBUG_MAX_RESPONSE 576
+
+// I/O vectors handed to the kernel per call when sending deltas.
+#define NETAPI_DEBUG_IOV_BATCH 64
+
+extern uint8_t TMEM[0x1000];
+void angrylion_rdp_tmem_written(void);
 
 // Static functions.
-static int bind_server_socket(int family, int type, const char *service);
+static int bind_server_socket(int family, int type,
+  const char *host, const char *service);
 
 static struct addrinfo *getaddrinfo_helper(int family,
   int type, const char *host, const char *service);
 
-static int netapi_debug_handle_request(int sfd, struct cen64_device *device,
+static int netapi_debug_handle_request(struct netapi_debugger *debugger,
+  const struct netapi_debug_request *req, const uint8_t *req_data);
+
+static int netapi_debug_read_delta(struct netapi_debugger *debugger,
+  uint8_t *head, size_t head_length, const struct netapi_debug_memory *mem,
+  const uint8_t *base, uint32_t size);
+static int netapi_debug_read_memory(struct netapi_debugger *debugger,
+  const struct netapi_debug_request *req, const uint8_t *req_data);
+static int netapi_debug_write_memory(struct netapi_debugger *debugger,
   const struct netapi_debug_request *req, const uint8_t *req_data);
 
-// Creates a socket of (family, type) and binds it portno.
-int bind_server_socket(int family, int type, const char *service) {
+static int netapi_debug_parse_memory(const struct netapi_debug_request *req,
+  const uint8_t *req_data, struct netapi_debug_memory *mem);
+static void netapi_debug_serialize_tlb(struct netapi_debugger *debugger);
+static uint8_t *netapi_debug_space(struct netapi_debugger *debugger,
+  uint32_t space, uint32_t *size, uint32_t *flags);
+
+static struct netapi_debug_shadow *netapi_debug_get_shadow(
+  struct netapi_debugger *debugger, uint32_t space, uint32_t size);
+static void netapi_debug_update_shadow(struct netapi_debug_shadow *shadow,
+  const uint8_t *base, uint32_t address, uint32_t length);
+
+static void netapi_debug_drain(struct netapi_debugger *debugger);
+static void netapi_debug_hook(void *opaque,
+  enum vr4300_debug_event event, uint64_t address);
+static void netapi_debug_pause(struct netapi_debugger *debugger,
+  enum netapi_debug_event event, uint64_t address);
+
+static void netapi_debug_enqueue(struct netapi_debugger *debugger);
+static void netapi_debug_receive(struct netapi_debugger *debugger, int sfd);
+static CEN64_THREAD_RETURN_TYPE netapi_debug_thread(void *opaque);
+
+static void netapi_debug_drop(struct netapi_debugger *debugger);
+static int netapi_debug_send(struct netapi_debugger *debugger,
+  netapi_iovec *iov, unsigned count);
+static int netapi_debug_send_locked(struct netapi_debugger *debugger,
+  netapi_iovec *iov, unsigned count);
+static CEN64_THREAD_RETURN_TYPE netapi_debug_writer(void *opaque);
+
+static int netapi_recv(int sfd, void *buf, size_t len);
+static int netapi_sendv(int sfd, netapi_iovec **iov,
+  unsigned *count, int flags);
+static void netapi_iov_set(netapi_iovec *iov, const void *base, size_t len);
+
+// Creates a socket of (family, type) and binds it to host:service.
+int bind_server_socket(int family, int type,
+  const char *host, const char *service) {
   struct addrinfo *res, *i;
   int sfd, ret;
 
-  if ((res = getaddrinfo_helper(family, type, NULL, service)) == NULL)
+  if ((res = getaddrinfo_helper(family, type, host, service)) == NULL)
     return -1;
 
   // Walk the list; try to bind a socket.
@@ -119,48 +204,24 @@ struct addrinfo *getaddrinfo_helper(int family,
     : res;
 }
 
-// Closes a connection.
-void netapi_close_connection(int csfd) {
-  close(csfd);
-}
-
-// Attempts to open an IPv4 socket and binds it, listens.
-// TODO: Respect the interface/port passed from the client.
-int netapi_open_connection(void) {
-  struct sockaddr address;
-  socklen_t addrlen;
-  int sfd, csfd;
-
-  if ((sfd = bind_server_socket(AF_INET, SOCK_STREAM, "64646")) < 0)
-    return -1;
-
-  if (listen(sfd, 1)) {
-    close(sfd);
-    return -2;
-  }
-
-  if ((csfd = accept(sfd, &address, &addrlen)) < 0) {
-    close(sfd);
-    return -3;
-  }
-
-  // TODO: Might not want to toss this out yet.
-  close(sfd);
-  return csfd;
-}
-
 // Handles an incoming request from the client.
-int netapi_debug_handle_request(int sfd, struct cen64_device *device,
+int netapi_debug_handle_request(struct netapi_debugger *debugger,
   const struct netapi_debug_request *req, const uint8_t *req_data) {
-  uint8_t buf[576];
-  size_t length;
+  struct cen64_device *device = debugger->device;
+  uint8_t buf[NETAPI_DEBUG_MAX_RESPONSE];
+  size_t body_length, length;
+  netapi_iovec iov;
   unsigned i;
+  int ret;
 
   struct netapi_debug_request resp;
   uint8_t *data = buf + sizeof(resp);
+  struct netapi_debug_watchpoint watch;
   uint32_t u32;
   uint64_t u64;
 
+  body_length = ntohl(req->length) - sizeof(*req);
+
   switch(ntohl(req->type)) {
 
     // Get protocol version.
@@ -175,7 +236,7 @@ int netapi_debug_handle_request(int sfd, struct cen64_device *device,
     // Get VR4300 general purpose registers and $PC.
     case NETAPI_DEBUG_GET_VR4300_REGS:
       resp.type = req->type;
-      length = sizeof(uint64_t) * 33;
+      length = sizeof(resp) + sizeof(uint64_t) * 33;
 
       for (i = 0; i < 32; i++) {
         u64 = htonll(device->vr4300.regs[i]);
@@ -186,6 +247,75 @@ int netapi_debug_handle_request(int sfd, struct cen64_device *device,
       memcpy(data + 32 * sizeof(u64), &u64, sizeof(u64));
       break;
 
+    // Read a range of memory; the reply is sent as it's gathered.
+    case NETAPI_DEBUG_READ_MEMORY:
+      if (!netapi_debug_read_memory(debugger, req, req_data))
+        return 0;
+
+      resp.type = htonl(NETAPI_DEBUG_ERROR);
+      length = sizeof(resp);
+      break;
+
+    // Write a range of memory.
+    case NETAPI_DEBUG_WRITE_MEMORY:
+      resp.type = netapi_debug_write_memory(debugger, req, req_data)
+        ? htonl(NETAPI_DEBUG_ERROR) : req->type;
+
+      length = sizeof(resp);
+      break;
+
+    // Set or clear an execution breakpoint (a virtual address).
+    case NETAPI_DEBUG_SET_BREAKPOINT:
+    case NETAPI_DEBUG_CLEAR_BREAKPOINT:
+      ret = -1;
+
+      if (body_length >= sizeof(u64)) {
+        memcpy(&u64, req_data, sizeof(u64));
+        u64 = ntohll(u64);
+
+        ret = ntohl(req->type) == NETAPI_DEBUG_SET_BREAKPOINT
+          ? vr4300_debug_add_breakpoint(&device->vr4300,
+            &debugger->vr4300_debug, u64)
+          : vr4300_debug_remove_breakpoint(&device->vr4300,
+            &debugger->vr4300_debug, u64);
+      }
+
+      resp.type = ret ? htonl(NETAPI_DEBUG_ERROR) : req->type;
+      length = sizeof(resp);
+      break;
+
+    // Set or clear a watchpoint (a physical address).
+    case NETAPI_DEBUG_SET_WATCHPOINT:
+    case NETAPI_DEBUG_CLEAR_WATCHPOINT:
+      ret = -1;
+
+      if (body_length >= sizeof(watch)) {
+        memcpy(&watch, req_data, sizeof(watch));
+
+        ret = ntohl(req->type) == NETAPI_DEBUG_SET_WATCHPOINT
+          ? vr4300_debug_add_watchpoint(&device->vr4300,
+            &debugger->vr4300_debug, ntohl(watch.address), ntohl(watch.type))
+          : vr4300_debug_remove_watchpoint(&device->vr4300,
+            &debugger->vr4300_debug, ntohl(watch.address));
+      }
+
+      resp.type = ret ? htonl(NETAPI_DEBUG_ERROR) : req->type;
+      length = sizeof(resp);
+      break;
+
+    // Stop at the next safe point; STOPPED follows once we have.
+    case NETAPI_DEBUG_HALT:
+      debugger->halt = !debugger->stopped;
+      resp.type = req->type;
+      length = sizeof(resp);
+      break;
+
+    case NETAPI_DEBUG_RESUME:
+      debugger->stopped = false;
+      resp.type = req->type;
+      length = sizeof(resp);
+      break;
+
     // Unsupported command.
     default:
       resp.type = htonl(NETAPI_DEBUG_ERROR);
@@ -195,37 +325,830 @@ int netapi_debug_handle_request(int sfd, struct cen64_device *device,
 
   // Send the response.
   resp.magic = htonl(NETAPI_DEBUG_MAGIC);
+  resp.seq_id = req->seq_id;
   resp.length = htonl(length);
 
   memcpy(buf, &resp, sizeof(resp));
-  send(sfd, buf, length, 0);
+  netapi_iov_set(&iov, buf, length);
+  netapi_debug_send(debugger, &iov, 1);
+  return 0;
+}
+
+// Validates the header of a memory request and converts it.
+int netapi_debug_parse_memory(const struct netapi_debug_request *req,
+  const uint8_t *req_data, struct netapi_debug_memory *mem) {
+  if (ntohl(req->length) < sizeof(*req) + sizeof(*mem))
+    return -1;
+
+  memcpy(mem, req_data, sizeof(*mem));
+  mem->space = ntohl(mem->space);
+  mem->address = ntohl(mem->address);
+  mem->length = ntohl(mem->length);
+  mem->flags = ntohl(mem->flags);
+
+  return (mem->address | mem->length) & 0x3 ? -1 : 0;
+}
+
+// Resolves a memory space to the device's own storage.
+uint8_t *netapi_debug_space(struct netapi_debugger *debugger,
+  uint32_t space, uint32_t *size, uint32_t *flags) {
+  struct cen64_device *device = debugger->device;
+
+  *flags = 0;
+
+  switch (space) {
+    case NETAPI_DEBUG_SPACE_RDRAM:
+      *size = MAX_RDRAM_SIZE;
+      *flags = NETAPI_RDRAM_SWAP32;
+      return device->ri.ram;
+
+    case NETAPI_DEBUG_SPACE_DMEM:
+      *size = 0x1000;
+      return device->rsp.mem;
+
+    case NETAPI_DEBUG_SPACE_IMEM:
+      *size = 0x1000;
+      *flags = NETAPI_HOST_SWAP32;
+      return device->rsp.mem + 0x1000;
+
+    case NETAPI_DEBUG_SPACE_TMEM:
+      *size = sizeof(TMEM);
+      *flags = NETAPI_HOST_SWAP16;
+      return TMEM;
+
+    case NETAPI_DEBUG_SPACE_TLB:
+      *size = sizeof(debugger->tlb);
+      return debugger->tlb;
+  }
+
+  return NULL;
+}
+
+// Lays the TLB out as a table of big-endian entries.
+void netapi_debug_serialize_tlb(struct netapi_debugger *debugger) {
+  uint64_t entry[NETAPI_DEBUG_TLB_ENTRY_SIZE / sizeof(uint64_t)];
+  uint32_t page_mask;
+  unsigned i, j;
+
+  for (i = 0; i < 32; i++) {
+    vr4300_cp0_read_tlb_entry(&debugger->device->vr4300, i,
+      entry + 0, entry + 1, entry + 2, &page_mask);
+
+    entry[3] = page_mask;
+
+    for (j = 0; j < 4; j++)
+      entry[j] = htonll(entry[j]);
+
+    memcpy(debugger->tlb + i * sizeof(entry), entry, sizeof(entry));
+  }
+}
+
+// Returns the shadow of a space, allocating it on first use. Shadows
+// are forgotten whenever a new client connects.
+struct netapi_debug_shadow *netapi_debug_get_shadow(
+  struct netapi_debugger *debugger, uint32_t space, uint32_t size) {
+  struct netapi_debug_shadow *shadow = debugger->shadows + space;
+
+  if (shadow->data == NULL) {
+    if ((shadow->data = malloc(size)) == NULL)
+      return NULL;
+
+    if ((shadow->valid = calloc(size / NETAPI_DEBUG_DELTA_BLOCK, 1)) == NULL) {
+      free(shadow->data);
+      shadow->data = NULL;
+      return NULL;
+    }
+  }
+
+  return shadow;
+}
+
+// Records that the client now holds [address, address + length).
+void netapi_debug_update_shadow(struct netapi_debug_shadow *shadow,
+  const uint8_t *base, uint32_t address, uint32_t length) {
+  uint32_t first = (address + NETAPI_DEBUG_DELTA_BLOCK - 1) /
+    NETAPI_DEBUG_DELTA_BLOCK;
+  uint32_t last = (address + length) / NETAPI_DEBUG_DELTA_BLOCK;
+
+  memcpy(shadow->data + address, base + address, length);
+
+  // Partly covered blocks still hold bytes the client never saw.
+  if (last > first)
+    memset(shadow->valid + first, 1, last - first);
+}
+
+// Sends a range of memory straight out of the device.
+int netapi_debug_read_memory(struct netapi_debugger *debugger,
+  const struct netapi_debug_request *req, const uint8_t *req_data) {
+  struct netapi_debug_memory mem, reply;
+  struct netapi_debug_request resp;
+  uint8_t head[sizeof(resp) + sizeof(reply)];
+  netapi_iovec iov[2];
+  uint32_t size, flags;
+  uint8_t *base;
+
+  if (netapi_debug_parse_memory(req, req_data, &mem))
+    return -1;
+
+  if ((base = netapi_debug_space(debugger, mem.space, &size, &flags)) == NULL ||
+    mem.address > size || mem.length > size - mem.address)
+    return -1;
+
+  if (mem.space == NETAPI_DEBUG_SPACE_TLB)
+    netapi_debug_serialize_tlb(debugger);
+
+  reply.space = htonl(mem.space);
+  reply.address = htonl(mem.address);
+  reply.length = htonl(mem.length);
+  reply.flags = htonl(flags | (mem.flags & NETAPI_DEBUG_MEMORY_DELTA));
+  memcpy(head + sizeof(resp), &reply, sizeof(reply));
+
+  resp.magic = htonl(NETAPI_DEBUG_MAGIC);
+  resp.seq_id = req->seq_id;
+  resp.type = req->type;
+
+  if (mem.flags & NETAPI_DEBUG_MEMORY_DELTA) {
+    memcpy(head, &resp, sizeof(resp));
+    return netapi_debug_read_delta(debugger,
+      head, sizeof(head), &mem, base, size);
+  }
+
+  resp.length = htonl(sizeof(head) + mem.length);
+  memcpy(head, &resp, sizeof(resp));
+
+  netapi_iov_set(iov + 0, head, sizeof(head));
+  netapi_iov_set(iov + 1, base + mem.address, mem.length);
+  netapi_debug_send(debugger, iov, 2);
+
+  if (debugger->shadows[mem.space].data != NULL) {
+    netapi_debug_update_shadow(debugger->shadows + mem.space,
+      base, mem.address, mem.length);
+  }
+
+  return 0;
+}
+
+// Sends only the blocks that changed since the client last saw them.
+int netapi_debug_read_delta(struct netapi_debugger *debugger,
+  uint8_t *head, size_t head_length, const struct netapi_debug_memory *mem,
+  const uint8_t *base, uint32_t size) {
+  struct netapi_debug_memory_run *runs;
+  struct netapi_debug_shadow *shadow;
+  netapi_iovec iov[NETAPI_DEBUG_IOV_BATCH];
+  size_t i, num_runs = 0, length = head_length;
+  uint32_t address, end = mem->address + mem->length;
+  unsigned count;
+
+  if ((mem->address | mem->length) & (NETAPI_DEBUG_DELTA_BLOCK - 1))
+    return -1;
+
+  if ((shadow = netapi_debug_get_shadow(debugger, mem->space, size)) == NULL)
+    return -1;
+
+  // Coalesce changed blocks into runs.
+  for (address = mem->address; address < end;
+    address += NETAPI_DEBUG_DELTA_BLOCK) {
+    if (shadow->valid[address / NETAPI_DEBUG_DELTA_BLOCK] && !memcmp(
+      shadow->data + address, base + address, NETAPI_DEBUG_DELTA_BLOCK))
+      continue;
+
+    if (num_runs && debugger->runs[num_runs - 1].address +
+      debugger->runs[num_runs - 1].length == address) {
+      debugger->runs[num_runs - 1].length += NETAPI_DEBUG_DELTA_BLOCK;
+      continue;
+    }
+
+    if (num_runs == debugger->max_runs) {
+      size_t max_runs = debugger->max_runs ? debugger->max_runs * 2 : 64;
+
+      if ((runs = realloc(debugger->runs, max_runs * sizeof(*runs))) == NULL)
+        return -1;
+
+      debugger->runs = runs;
+      debugger->max_runs = max_runs;
+    }
+
+    debugger->runs[num_runs].address = address;
+    debugger->runs[num_runs++].length = NETAPI_DEBUG_DELTA_BLOCK;
+  }
+
+  // Update the shadow, then put the run headers in network order.
+  for (i = 0; i < num_runs; i++) {
+    struct netapi_debug_memory_run *run = debugger->runs + i;
+
+    netapi_debug_update_shadow(shadow, base, run->address, run->length);
+    length += sizeof(*run) + run->length;
+
+    run->address = htonl(run->address);
+    run->length = htonl(run->length);
+  }
+
+  ((struct netapi_debug_request *) head)->length = htonl(length);
+  netapi_iov_set(iov, head, head_length);
+  count = 1;
+
+  for (i = 0; i < num_runs; i++) {
+    const struct netapi_debug_memory_run *run = debugger->runs + i;
+
+    if (count + 2 > NETAPI_DEBUG_IOV_BATCH) {
+      if (netapi_debug_send(debugger, iov, count))
+        return 0;
+
+      count = 0;
+    }
+
+    netapi_iov_set(iov + count++, run, sizeof(*run));
+    netapi_iov_set(iov + count++, base + ntohl(run->address),
+      ntohl(run->length));
+  }
+
+  netapi_debug_send(debugger, iov, count);
+  return 0;
+}
+
+// Writes a range of memory given in the N64's byte order.
+int netapi_debug_write_memory(struct netapi_debugger *debugger,
+  const struct netapi_debug_request *req, const uint8_t *req_data) {
+  struct vr4300 *vr4300 = &debugger->device->vr4300;
+  struct rsp *rsp = &debugger->device->rsp;
+  struct netapi_debug_memory mem;
+  const uint8_t *data = req_data + sizeof(mem);
+  uint32_t i, size, flags;
+  uint8_t *base;
+
+  if (netapi_debug_parse_memory(req, req_data, &mem) ||
+    ntohl(req->length) != sizeof(*req) + sizeof(mem) + mem.length)
+    return -1;
+
+  if ((base = netapi_debug_space(debugger, mem.space, &size, &flags)) == NULL ||
+    mem.address > size || mem.length > size - mem.address)
+    return -1;
+
+  switch (mem.space) {
+    case NETAPI_DEBUG_SPACE_IMEM:
+      for (i = 0; i < mem.length; i += sizeof(uint32_t)) {
+        uint32_t word;
+
+        memcpy(&word, data + i, sizeof(word));
+        word = ntohl(word);
+
+        memcpy(base + mem.address + i, &word, sizeof(word));
+        rsp->opcode_cache[(mem.address + i) >> 2] =
+          *rsp_decode_instruction(word);
+      }
+
+      break;
+
+    case NETAPI_DEBUG_SPACE_TMEM:
+      for (i = 0; i < mem.length; i += sizeof(uint16_t)) {
+        uint16_t hword;
+
+        memcpy(&hword, data + i, sizeof(hword));
+        hword = ntohs(hword);
+        memcpy(base + mem.address + i, &hword, sizeof(hword));
+      }
+
+      angrylion_rdp_tmem_written();
+      break;
+
+    // Whole entries only, laid out as in reads.
+    case NETAPI_DEBUG_SPACE_TLB:
+      if ((mem.address | mem.length) & (NETAPI_DEBUG_TLB_ENTRY_SIZE - 1))
+        return -1;
+
+      for (i = 0; i < mem.length; i += NETAPI_DEBUG_TLB_ENTRY_SIZE) {
+        uint64_t entry[NETAPI_DEBUG_TLB_ENTRY_SIZE / sizeof(uint64_t)];
+
+        memcpy(entry, data + i, sizeof(entry));
+        vr4300_cp0_write_tlb_entry(vr4300,
+          (mem.address + i) / NETAPI_DEBUG_TLB_ENTRY_SIZE,
+          ntohll(entry[0]), ntohll(entry[1]), ntohll(entry[2]),
+          ntohll(entry[3]));
+      }
+
+      break;
+
+    case NETAPI_DEBUG_SPACE_RDRAM:
+      ri_copy_to_rdram(&debugger->device->ri, mem.address, data, mem.length);
+      ri_mark_written_range(&debugger->device->ri, mem.address, mem.length);
+      break;
+
+    default:
+      memcpy(base + mem.address, data, mem.length);
+      break;
+  }
+
+  return 0;
+}
+
+// Starts listening on addr ("[host][:port]") and spawns the thread
+// that accepts clients and queues their requests.
+int netapi_debug_start(struct netapi_debugger *debugger,
+  struct cen64_device *device, const char *addr) {
+  const char *service = NETAPI_DEBUG_DEFAULT_PORT;
+  const char *colon;
+  char host[256];
+  size_t len;
+
+  if ((colon = strrchr(addr, ':')) != NULL) {
+    len = colon - addr;
+    service = colon + 1;
+  }
+
+  else
+    len = strlen(addr);
+
+  if (len >= sizeof(host))
+    return -1;
+
+  memcpy(host, addr, len);
+  host[len] = '\0';
+
+  memset(debugger, 0, sizeof(*debugger));
+  debugger->device = device;
+  debugger->sfd = -1;
+
+  if ((debugger->lfd = bind_server_socket(AF_INET,
+    SOCK_STREAM, len ? host : NULL, service)) < 0)
+    return -1;
+
+  if (listen(debugger->lfd, 1)) {
+    close(debugger->lfd);
+    return -2;
+  }
+
+  if (cen64_mutex_create(&debugger->lock)) {
+    close(debugger->lfd);
+    return -3;
+  }
+
+  if (cen64_cv_create(&debugger->cv)) {
+    cen64_mutex_destroy(&debugger->lock);
+    close(debugger->lfd);
+    return -3;
+  }
+
+  if (cen64_cv_create(&debugger->ready)) {
+    cen64_cv_destroy(&debugger->cv);
+    cen64_mutex_destroy(&debugger->lock);
+    close(debugger->lfd);
+    return -3;
+  }
+
+  if (cen64_cv_create(&debugger->pending)) {
+    cen64_cv_destroy(&debugger->ready);
+    cen64_cv_destroy(&debugger->cv);
+    cen64_mutex_destroy(&debugger->lock);
+    close(debugger->lfd);
+    return -3;
+  }
+
+  vr4300_debug_init(&debugger->vr4300_debug, netapi_debug_hook, debugger);
+  debugger->running = true;
+
+  if (cen64_thread_create(&debugger->writer,
+    netapi_debug_writer, debugger)) {
+    cen64_cv_destroy(&debugger->pending);
+    cen64_cv_destroy(&debugger->ready);
+    cen64_cv_destroy(&debugger->cv);
+    cen64_mutex_destroy(&debugger->lock);
+    close(debugger->lfd);
+    return -4;
+  }
+
+  if (cen64_thread_create(&debugger->thread,
+    netapi_debug_thread, debugger)) {
+    cen64_mutex_lock(&debugger->lock);
+    debugger->running = false;
+    cen64_cv_signal(&debugger->pending);
+    cen64_mutex_unlock(&debugger->lock);
+
+    cen64_thread_join(&debugger->writer);
+    cen64_cv_destroy(&debugger->pending);
+    cen64_cv_destroy(&debugger->ready);
+    cen64_cv_destroy(&debugger->cv);
+    cen64_mutex_destroy(&debugger->lock);
+    close(debugger->lfd);
+    return -4;
+  }
+
+  return 0;
+}
+
+// Stops the helper thread and closes any open sockets.
+void netapi_debug_stop(struct netapi_debugger *debugger) {
+  unsigned i;
+
+  cen64_mutex_lock(&debugger->lock);
+  debugger->running = false;
+  cen64_cv_signal(&debugger->cv);
+  cen64_cv_signal(&debugger->ready);
+  cen64_cv_signal(&debugger->pending);
+
+  // Kick the helpers out of accept(), recv() or send().
+  if (debugger->sfd >= 0)
+    shutdown(debugger->sfd, SHUT_RDWR);
+
+  shutdown(debugger->lfd, SHUT_RDWR);
+  cen64_mutex_unlock(&debugger->lock);
+
+  cen64_thread_join(&debugger->thread);
+  cen64_thread_join(&debugger->writer);
+  cen64_cv_destroy(&debugger->pending);
+  cen64_cv_destroy(&debugger->ready);
+  cen64_cv_destroy(&debugger->cv);
+  cen64_mutex_destroy(&debugger->lock);
+  close(debugger->lfd);
+
+  free(debugger->output);
+  free(debugger->flushing);
+
+  for (i = 0; i < NUM_NETAPI_DEBUG_SPACES; i++) {
+    free(debugger->shadows[i].data);
+    free(debugger->shadows[i].valid);
+  }
+
+  free(debugger->runs);
+  debugger->device->vr4300.debug = NULL;
+}
+
+// Lets a paused device go and keeps it from pausing again, so that
+// it can see an exit request without the client's help.
+void netapi_debug_release(struct netapi_debugger *debugger) {
+  cen64_mutex_lock(&debugger->lock);
+  debugger->exiting = true;
+  cen64_cv_signal(&debugger->ready);
+  cen64_mutex_unlock(&debugger->lock);
+}
+
+// Answers every queued request. Called from the device thread at safe
+// points; returns immediately when nothing is pending.
+void netapi_debug_service(struct netapi_debugger *debugger) {
+  cen64_mutex_lock(&debugger->lock);
+  netapi_debug_drain(debugger);
+  cen64_mutex_unlock(&debugger->lock);
+
+  if (unlikely(debugger->halt)) {
+    netapi_debug_pause(debugger, NETAPI_DEBUG_EVENT_HALT,
+      debugger->device->vr4300.pipeline.dcwb_latch.common.pc);
+  }
+}
+
+// Stops a breakpoint or watchpoint hit in its tracks.
+void netapi_debug_hook(void *opaque,
+  enum vr4300_debug_event event, uint64_t address) {
+  netapi_debug_pause((struct netapi_debugger *) opaque,
+    (enum netapi_debug_event) event, address);
+}
+
+// Holds the device while the client pokes at it, until it resumes,
+// goes away or the emulator exits. Tells the client why first.
+void netapi_debug_pause(struct netapi_debugger *debugger,
+  enum netapi_debug_event event, uint64_t address) {
+  struct netapi_debug_request msg;
+  struct netapi_debug_stopped stopped;
+  uint8_t buf[sizeof(msg) + sizeof(stopped)];
+  netapi_iovec iov;
+
+  msg.magic = htonl(NETAPI_DEBUG_MAGIC);
+  msg.seq_id = 0;
+  msg.length = htonl(sizeof(buf));
+  msg.type = htonl(NETAPI_DEBUG_STOPPED);
+
+  stopped.event = htonl(event);
+  stopped.reserved = 0;
+  stopped.address = htonll(address);
+
+  memcpy(buf, &msg, sizeof(msg));
+  memcpy(buf + sizeof(msg), &stopped, sizeof(stopped));
+
+  cen64_mutex_lock(&debugger->lock);
+  debugger->halt = false;
+
+  if (debugger->sfd >= 0 && !debugger->exiting) {
+    netapi_iov_set(&iov, buf, sizeof(buf));
+    netapi_debug_send_locked(debugger, &iov, 1);
+    debugger->stopped = true;
+  }
+
+  while (debugger->stopped && !debugger->exiting &&
+    debugger->running && debugger->sfd >= 0) {
+    if (debugger->head == debugger->tail)
+      cen64_cv_wait(&debugger->ready, &debugger->lock);
+
+    else
+      netapi_debug_drain(debugger);
+  }
+
+  debugger->stopped = false;
+  cen64_mutex_unlock(&debugger->lock);
+}
+
+// Answers every queued request. Called with the lock held.
+void netapi_debug_drain(struct netapi_debugger *debugger) {
+  while (debugger->head != debugger->tail) {
+    struct netapi_debug_slot *slot = debugger->queue +
+      debugger->head % NETAPI_DEBUG_QUEUE_SIZE;
+    unsigned i;
+
+    // A new client has seen none of memory.
+    if (debugger->shadow_client != debugger->client) {
+      debugger->shadow_client = debugger->client;
+
+      for (i = 0; i < NUM_NETAPI_DEBUG_SPACES; i++) {
+        struct netapi_debug_shadow *shadow = debugger->shadows + i;
+        uint32_t size, flags;
+
+        if (shadow->valid != NULL) {
+          netapi_debug_space(debugger, i, &size, &flags);
+          memset(shadow->valid, 0, size / NETAPI_DEBUG_DELTA_BLOCK);
+        }
+      }
+    }
+
+    cen64_mutex_unlock(&debugger->lock);
+    netapi_debug_handle_request(debugger, &slot->req, slot->data);
+
+    cen64_mutex_lock(&debugger->lock);
+    debugger->head++;
+    cen64_cv_signal(&debugger->cv);
+  }
+}
+
+// Accepts clients one at a time and feeds their requests to the queue.
+CEN64_THREAD_RETURN_TYPE netapi_debug_thread(void *opaque) {
+  struct netapi_debugger *debugger = (struct netapi_debugger *) opaque;
+  int sfd;
+
+  while (debugger->running) {
+    if ((sfd = accept(debugger->lfd, NULL, NULL)) < 0)
+      continue;
+
+    cen64_mutex_lock(&debugger->lock);
+    debugger->sfd = sfd;
+    debugger->client++;
+    debugger->output_dropped = false;
+    cen64_mutex_unlock(&debugger->lock);
+
+    netapi_debug_receive(debugger, sfd);
+
+    // Let the device answer whatever is queued before hanging up.
+    cen64_mutex_lock(&debugger->lock);
+
+    while (debugger->running && (debugger->head != debugger->tail ||
+      debugger->output_length || debugger->output_busy))
+      cen64_cv_wait(&debugger->cv, &debugger->lock);
+
+    debugger->sfd = -1;
+    cen64_cv_signal(&debugger->ready);
+    cen64_mutex_unlock(&debugger->lock);
+    close(sfd);
+  }
+
+  return CEN64_THREAD_RETURN_VAL;
+}
+
+// Reads requests off the socket until the client hangs up.
+void netapi_debug_receive(struct netapi_debugger *debugger, int sfd) {
+  struct netapi_debug_slot *slot;
+  uint32_t length;
+
+  while (1) {
+    cen64_mutex_lock(&debugger->lock);
+
+    while (debugger->running &&
+      debugger->tail - debugger->head == NETAPI_DEBUG_QUEUE_SIZE)
+      cen64_cv_wait(&debugger->cv, &debugger->lock);
+
+    if (!debugger->running) {
+      cen64_mutex_unlock(&debugger->lock);
+      return;
+    }
+
+    // The slot at the tail is ours until the tail moves past it.
+    slot = debugger->queue + debugger->tail % NETAPI_DEBUG_QUEUE_SIZE;
+    cen64_mutex_unlock(&debugger->lock);
+
+    if (netapi_recv(sfd, &slot->req, sizeof(slot->req)))
+      return;
+
+    length = ntohl(slot->req.length);
+
+    // There's no resynchronizing the stream after a bad header; send
+    // back an error and hang up.
+    if (ntohl(slot->req.magic) != NETAPI_DEBUG_MAGIC ||
+      length < sizeof(slot->req) ||
+      length > sizeof(slot->req) + sizeof(slot->data)) {
+      debug("net/debug: Got a bad request packet.\n");
+
+      slot->req.type = htonl(NETAPI_DEBUG_ERROR);
+      netapi_debug_enqueue(debugger);
+      return;
+    }
+
+    if (length > sizeof(slot->req) && netapi_recv(sfd,
+      slot->data, length - sizeof(slot->req)))
+      return;
+
+    netapi_debug_enqueue(debugger);
+  }
+}
+
+// Publishes the slot at the tail of the queue.
+void netapi_debug_enqueue(struct netapi_debugger *debugger) {
+  cen64_mutex_lock(&debugger->lock);
+  debugger->tail++;
+  cen64_cv_signal(&debugger->ready);
+  cen64_mutex_unlock(&debugger->lock);
+}
+
+// Receives exactly len bytes.
+int netapi_recv(int sfd, void *buf, size_t len) {
+  uint8_t *dest = (uint8_t *) buf;
+  ssize_t ret;
+
+  while (len > 0) {
+    if ((ret = recv(sfd, (char *) dest, len, 0)) <= 0)
+      return -1;
+
+    dest += ret;
+    len -= ret;
+  }
+
   return 0;
 }
 
-// Waits for an incoming request, attempts to handle it.
-int netapi_debug_wait(int sfd, struct cen64_device *device) {
-  struct netapi_debug_request req;
-  uint8_t buf[576];
+// Points an I/O vector at a buffer.
+void netapi_iov_set(netapi_iovec *iov, const void *base, size_t len) {
+  iov->netapi_iov_base = (void *) base;
+  iov->netapi_iov_len = len;
+}
+
+// Hangs up on a client that can't be sent to. Called with the lock held.
+void netapi_debug_drop(struct netapi_debugger *debugger) {
+  debugger->output_dropped = true;
+  debugger->output_length = 0;
 
-  // Pull and process the header.
-  recv(sfd, &req, sizeof(req), 0);
+  if (debugger->sfd >= 0)
+    shutdown(debugger->sfd, SHUT_RDWR);
+}
 
-  if (ntohl(req.magic) != NETAPI_DEBUG_MAGIC ||
-    ntohl(req.length) > sizeof(buf)) {
-    debug("net/debug: Got a bad request packet.\n");
+// Sends a reply to the current client without blocking.
+int netapi_debug_send(struct netapi_debugger *debugger,
+  netapi_iovec *iov, unsigned count) {
+  int ret;
 
-    req.magic = htonl(NETAPI_DEBUG_MAGIC);
-    req.length = htonl(sizeof(req));
-    req.type = htonl(NETAPI_DEBUG_ERROR);
+  cen64_mutex_lock(&debugger->lock);
+  ret = netapi_debug_send_locked(debugger, iov, count);
+  cen64_mutex_unlock(&debugger->lock);
+  return ret;
+}
 
-    send(sfd, &req, sizeof(req), 0);
+// Hands the socket whatever it takes right away and queues the rest
+// for the writer. Called with the lock held.
+int netapi_debug_send_locked(struct netapi_debugger *debugger,
+  netapi_iovec *iov, unsigned count) {
+  size_t length = 0;
+  unsigned i;
+
+  if (debugger->sfd < 0 || debugger->output_dropped)
     return -1;
+
+#ifdef MSG_DONTWAIT
+  // Nothing can go out ahead of what's already queued.
+  if (!debugger->output_length && !debugger->output_busy) {
+    int ret = netapi_sendv(debugger->sfd, &iov, &count, MSG_DONTWAIT);
+
+    if (ret < 0)
+      netapi_debug_drop(debugger);
+
+    if (ret <= 0)
+      return ret;
+  }
+#endif
+
+  for (i = 0; i < count; i++)
+    length += iov[i].netapi_iov_len;
+
+  if (debugger->output_length + length > debugger->output_capacity) {
+    size_t capacity = debugger->output_capacity * 2;
+    uint8_t *output;
+
+    if (capacity < debugger->output_length + length)
+      capacity = debugger->output_length + length;
+
+    if ((output = realloc(debugger->output, capacity)) == NULL) {
+      netapi_debug_drop(debugger);
+      return -1;
+    }
+
+    debugger->output = output;
+    debugger->output_capacity = capacity;
   }
 
-  // Pull the body of the request, if any.
-  if (ntohl(req.length) > sizeof(req))
-    recv(sfd, buf, ntohl(req.length) - sizeof(req), 0);
+  for (i = 0; i < count; i++) {
+    memcpy(debugger->output + debugger->output_length,
+      iov[i].netapi_iov_base, iov[i].netapi_iov_len);
+
+    debugger->output_length += iov[i].netapi_iov_len;
+  }
+
+  cen64_cv_signal(&debugger->pending);
+  return 0;
+}
+
+// Sends the replies the device queued, blocking as long as it takes.
+CEN64_THREAD_RETURN_TYPE netapi_debug_writer(void *opaque) {
+  struct netapi_debugger *debugger = (struct netapi_debugger *) opaque;
+
+  cen64_mutex_lock(&debugger->lock);
+
+  while (debugger->running) {
+    netapi_iovec iov, *iovp = &iov;
+    unsigned count = 1;
+    uint8_t *data;
+    size_t length, capacity;
+    int sfd, ret;
+
+    if (!debugger->output_length) {
+      cen64_cv_wait(&debugger->pending, &debugger->lock);
+      continue;
+    }
+
+    // Swap buffers so the device can keep queueing in the meantime.
+    data = debugger->output;
+    length = debugger->output_length;
+    capacity = debugger->output_capacity;
+
+    debugger->output = debugger->flushing;
+    debugger->output_capacity = debugger->flushing_capacity;
+    debugger->output_length = 0;
+    debugger->flushing = data;
+    debugger->flushing_capacity = capacity;
+
+    debugger->output_busy = true;
+    sfd = debugger->sfd;
+    cen64_mutex_unlock(&debugger->lock);
+
+    netapi_iov_set(&iov, data, length);
+    ret = netapi_sendv(sfd, &iovp, &count, 0);
 
-  return netapi_debug_handle_request(sfd, device, &req, buf);
+    cen64_mutex_lock(&debugger->lock);
+    debugger->output_busy = false;
+
+    if (ret)
+      netapi_debug_drop(debugger);
+
+    cen64_cv_signal(&debugger->cv);
+  }
+
+  cen64_mutex_unlock(&debugger->lock);
+  return CEN64_THREAD_RETURN_VAL;
 }
 
+// Sends a list of buffers without staging them, riding out short
+// writes. With MSG_DONTWAIT, returns 1 once the socket fills, leaving
+// *iov and *count at what's left.
+int netapi_sendv(int sfd, netapi_iovec **iov, unsigned *count, int flags) {
+  netapi_iovec *next = *iov;
+  size_t sent;
+
+  while (*count > 0) {
+#ifdef _WIN32
+    DWORD ret;
+
+    if (WSASend(sfd, next, *count, &ret, flags, NULL, NULL))
+      return -1;
+#else
+    struct msghdr msg;
+    ssize_t ret;
+
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = next;
+    msg.msg_iovlen = *count;
+
+    if ((ret = sendmsg(sfd, &msg, flags | MSG_NOSIGNAL)) < 0) {
+      if (errno == EINTR)
+        continue;
+
+      if (errno == EAGAIN || errno == EWOULDBLOCK) {
+        *iov = next;
+        return 1;
+      }
+
+      return -1;
+    }
+#endif
+
+    // Drop what went out; resume partway into a buffer if need be.
+    for (sent = ret; *count > 0 && sent >= next->netapi_iov_len; (*count)--)
+      sent -= (next++)->netapi_iov_len;
+
+    if (*count > 0) {
+      next->netapi_iov_base = (uint8_t *) next->netapi_iov_base + sent;
+      next->netapi_iov_len -= sent;
+    }
+  }
+
+  return 0;
+}
@@ -11,15 +11,65 @@
 #ifndef __device_netapi_h__
 #define __device_netapi_h__
 #include "common.h"
+#include "thread.h"
+#include "vr4300/debug.h"
 
-struct device;
+// Requests the helper thread may buffer before it stops reading.
+#define NETAPI_DEBUG_QUEUE_SIZE 16
+#define NETAPI_DEBUG_MAX_WRITE 0x10000
+#define NETAPI_DEBUG_MAX_REQUEST \
+  (sizeof(struct netapi_debug_memory) + NETAPI_DEBUG_MAX_WRITE)
+
+// Delta reads compare against the last transfer in blocks of this size.
+#define NETAPI_DEBUG_DELTA_BLOCK 64
+
+// One serialized TLB entry: EntryHi, EntryLo0, EntryLo1 and PageMask.
+#define NETAPI_DEBUG_TLB_ENTRY_SIZE 32
+
+struct cen64_device;
 
 enum netapi_debug_request_type {
   NETAPI_DEBUG_ERROR,
   NETAPI_DEBUG_GET_PROTOCOL_VERSION,
   NETAPI_DEBUG_GET_VR4300_REGS,
+  NETAPI_DEBUG_READ_MEMORY,
+  NETAPI_DEBUG_WRITE_MEMORY,
+  NETAPI_DEBUG_SET_BREAKPOINT,
+  NETAPI_DEBUG_CLEAR_BREAKPOINT,
+  NETAPI_DEBUG_SET_WATCHPOINT,
+  NETAPI_DEBUG_CLEAR_WATCHPOINT,
+  NETAPI_DEBUG_HALT,
+  NETAPI_DEBUG_RESUME,
+
+  // Sent unprompted (with a seq_id of 0) when the device stops.
+  NETAPI_DEBUG_STOPPED,
+};
+
+// Why the device stopped; the first two match vr4300_debug_event.
+enum netapi_debug_event {
+  NETAPI_DEBUG_EVENT_BREAKPOINT,
+  NETAPI_DEBUG_EVENT_WATCHPOINT,
+  NETAPI_DEBUG_EVENT_HALT,
+};
+
+enum netapi_debug_memory_space {
+  NETAPI_DEBUG_SPACE_RDRAM,
+  NETAPI_DEBUG_SPACE_DMEM,
+  NETAPI_DEBUG_SPACE_IMEM,
+  NETAPI_DEBUG_SPACE_TMEM,
+  NETAPI_DEBUG_SPACE_TLB,
+  NUM_NETAPI_DEBUG_SPACES
 };
 
+// The reply to a delta read is a list of runs that differ from what
+// was last sent, each a netapi_debug_memory_run and its bytes.
+#define NETAPI_DEBUG_MEMORY_DELTA  0x1U
+
+// Set in replies when the bytes are in the host's order rather than
+// the N64's, per 16- or 32-bit unit. Writes always use the N64's.
+#define NETAPI_DEBUG_MEMORY_SWAP16 0x2U
+#define NETAPI_DEBUG_MEMORY_SWAP32 0x4U
+
 struct netapi_debug_request {
   uint32_t magic;
   uint32_t seq_id;
@@ -29,10 +79,85 @@ struct netapi_debug_request {
   uint8_t data[];
 };
 
-cen64_cold void netapi_close_connection(int csfd);
-cen64_cold int netapi_open_connection(void);
+// Leads the body of memory requests and replies.
+struct netapi_debug_memory {
+  uint32_t space;
+  uint32_t address;
+  uint32_t length;
+  uint32_t flags;
+};
+
+struct netapi_debug_memory_run {
+  uint32_t address;
+  uint32_t length;
+};
+
+// Body of SET_WATCHPOINT/CLEAR_WATCHPOINT; types are read (1), write (2).
+struct netapi_debug_watchpoint {
+  uint32_t address;
+  uint32_t type;
+};
+
+// Body of STOPPED.
+struct netapi_debug_stopped {
+  uint32_t event;
+  uint32_t reserved;
+  uint64_t address;
+};
+
+// What the client was last sent of a space, for delta reads.
+struct netapi_debug_shadow {
+  uint8_t *data;
+  uint8_t *valid;
+};
+
+struct netapi_debug_slot {
+  struct netapi_debug_request req;
+  uint8_t data[NETAPI_DEBUG_MAX_REQUEST];
+};
+
+// Requests are received by a helper thread and queued; the device
+// only picks them up at safe points. Replies the socket won't take
+// right away are queued for a writer thread, so the device never
+// blocks on the socket.
+struct netapi_debugger {
+  struct cen64_device *device;
+  struct netapi_debug_slot queue[NETAPI_DEBUG_QUEUE_SIZE];
+  unsigned head, tail;
+
+  struct vr4300_debug vr4300_debug;
+  bool halt, stopped, exiting;
+
+  cen64_thread thread;
+  cen64_thread writer;
+  cen64_mutex lock;
+  cen64_cv cv;
+  cen64_cv ready;
+  cen64_cv pending;
+
+  // The device appends to output while the writer sends flushing.
+  uint8_t *output, *flushing;
+  size_t output_length, output_capacity, flushing_capacity;
+  bool output_busy, output_dropped;
+
+  struct netapi_debug_shadow shadows[NUM_NETAPI_DEBUG_SPACES];
+  struct netapi_debug_memory_run *runs;
+  size_t max_runs;
+
+  uint8_t tlb[32 * NETAPI_DEBUG_TLB_ENTRY_SIZE];
+  unsigned client, shadow_client;
+
+  int lfd;
+  int sfd;
+  bool running;
+};
+
+cen64_cold int netapi_debug_start(struct netapi_debugger *debugger,
+  struct cen64_device *device, const char *addr);
+cen64_cold void netapi_debug_stop(struct netapi_debugger *debugger);
+cen64_cold void netapi_debug_release(struct netapi_debugger *debugger);
 
-cen64_cold int netapi_debug_wait(int sfd, struct cen64_device *device);
+cen64_cold void netapi_debug_service(struct netapi_debugger *debugger);
 
 #endif
 
@@ -10,6 +10,8 @@
 
 #include "common.h"
 #include "options.h"
+#include "device/lockstep.h"
+#include "device/profiler.h"
 #include "si/pak.h"
 
 static int parse_controller_options(const char *str, int *num, struct controller *opt);
@@ -17,6 +19,7 @@ static int parse_controller_options(const char *str, int *num, struct controller
 const struct cen64_options default_cen64_options = {
   NULL, // ddipl_path
   NULL, // ddrom_path
+  NULL, // ddjournal_path
   NULL, // pifrom_path
   NULL, // cart_path
   NULL, // debugger_addr
@@ -24,6 +27,17 @@ const struct cen64_options default_cen64_options = {
   0,    // eeprom_size
   NULL, // sram_path
   NULL, // flashram_path
+  NULL, // profile_path
+  PROFILER_DEFAULT_INTERVAL, // profile_interval
+  0,    // lockstep_interval
+  0,    // lockstep_start
+  NULL, // stats_json_path
+  NULL, // telemetry_path
+  1.0,  // speed
+  0,    // frame_limit
+  {NULL, NULL, NULL}, // affinity
+  0,    // sched_fifo
+  0,    // nice
   0,    // is_viewer_present
   NULL, // controller
 #ifdef _WIN32
@@ -31,8 +45,15 @@ const struct cen64_options default_cen64_options = {
 #endif
   false, // enable_debugger
   false, // multithread
+  false, // no_fast_paths
   false, // no_audio
   false, // no_video
+  false, // print_stats
+  false, // telemetry_binary
+  false, // texel_cache
+  false, // turbo
+  false, // renice
+  false, // same_l3
 };
 
 // Parses the passed command line arguments.
@@ -80,6 +101,15 @@ int parse_options(struct cen64_options *options, int argc, const char *argv[]) {
       options->ddrom_path = argv[++i];
     }
 
+    else if (!strcmp(argv[i], "-ddjournal")) {
+      if ((i + 1) >= (argc - 1)) {
+        printf("-ddjournal requires a path to the journal file.\n\n");
+        return 1;
+      }
+
+      options->ddjournal_path = argv[++i];
+    }
+
     else if (!strcmp(argv[i], "-headless")) {
       options->no_audio = true;
       options->no_video = true;
@@ -129,6 +159,140 @@ int parse_options(struct cen64_options *options, int argc, const char *argv[]) {
       options->flashram_path = argv[++i];
     }
 
+    else if (!strcmp(argv[i], "-profile")) {
+      if ((i + 1) >= (argc - 1)) {
+        printf("-profile requires a path to the output file.\n\n");
+        return 1;
+      }
+
+      options->profile_path = argv[++i];
+    }
+
+    else if (!strcmp(argv[i], "-profile-interval")) {
+      if ((i + 1) >= (argc - 1) || !(options->profile_interval =
+        strtoul(argv[i + 1], NULL, 0))) {
+        printf("-profile-interval requires a nonzero cycle count.\n\n");
+        return 1;
+      }
+
+      i++;
+    }
+
+    else if (!strcmp(argv[i], "-lockstep")) {
+      if ((i + 1) >= (argc - 1) || !(options->lockstep_interval =
+        strtoul(argv[i + 1], NULL, 0))) {
+        printf("-lockstep requires a nonzero cycle count.\n\n");
+        return 1;
+      }
+
+      i++;
+    }
+
+    else if (!strcmp(argv[i], "-lockstep-start")) {
+      if ((i + 1) >= (argc - 1)) {
+        printf("-lockstep-start requires a cycle count.\n\n");
+        return 1;
+      }
+
+      options->lockstep_start = strtoull(argv[++i], NULL, 0);
+    }
+
+    else if (!strcmp(argv[i], "-stats"))
+      options->print_stats = true;
+
+    else if (!strcmp(argv[i], "-stats-json")) {
+      if ((i + 1) >= (argc - 1)) {
+        printf("-stats-json requires a path to the output file.\n\n");
+        return 1;
+      }
+
+      options->stats_json_path = argv[++i];
+    }
+
+    else if (!strcmp(argv[i], "-telemetry")) {
+      if ((i + 1) >= (argc - 1)) {
+        printf("-telemetry requires a path for the socket.\n\n");
+        return 1;
+      }
+
+      options->telemetry_path = argv[++i];
+    }
+
+    else if (!strcmp(argv[i], "-telemetry-binary"))
+      options->telemetry_binary = true;
+
+    else if (!strcmp(argv[i], "-speed")) {
+      if ((i + 1) >= (argc - 1) ||
+        (options->speed = strtod(argv[i + 1], NULL)) <= 0) {
+        printf("-speed requires a positive multiplier.\n\n");
+        return 1;
+      }
+
+      i++;
+    }
+
+    else if (!strcmp(argv[i], "-frames")) {
+      if ((i + 1) >= (argc - 1) || !(options->frame_limit =
+        strtoul(argv[i + 1], NULL, 0))) {
+        printf("-frames requires a nonzero field count.\n\n");
+        return 1;
+      }
+
+      i++;
+    }
+
+    else if (!strcmp(argv[i], "-turbo"))
+      options->turbo = true;
+
+    else if (!strcmp(argv[i], "-texel-cache"))
+      options->texel_cache = true;
+
+    else if (!strcmp(argv[i], "-no-fast-paths"))
+      options->no_fast_paths = true;
+
+    else if (!strcmp(argv[i], "-affinity-ui") ||
+      !strcmp(argv[i], "-affinity-rcp") ||
+      !strcmp(argv[i], "-affinity-vr4300")) {
+      uint8_t cpus[CEN64_MAX_CPUS / 8];
+      unsigned role;
+
+      for (role = 0; role < NUM_CEN64_THREAD_ROLES; role++) {
+        if (!strcmp(argv[i] + sizeof("-affinity-") - 1,
+          cen64_thread_role_names[role]))
+          break;
+      }
+
+      if ((i + 1) >= (argc - 1) || parse_cpu_list(argv[i + 1], cpus)) {
+        printf("%s requires a CPU list (e.g., 0-3,8).\n\n", argv[i]);
+        return 1;
+      }
+
+      options->affinity[role] = argv[++i];
+    }
+
+    else if (!strcmp(argv[i], "-sched-fifo")) {
+      if ((i + 1) >= (argc - 1) || (options->sched_fifo =
+        strtol(argv[i + 1], NULL, 0)) < 1 || options->sched_fifo > 99) {
+        printf("-sched-fifo requires a priority between 1 and 99.\n\n");
+        return 1;
+      }
+
+      i++;
+    }
+
+    else if (!strcmp(argv[i], "-nice")) {
+      if ((i + 1) >= (argc - 1)) {
+        printf("-nice requires a nice value.\n\n");
+        return 1;
+      }
+
+      options->nice = strtol(argv[++i], NULL, 0);
+      options->renice = true;
+    }
+
+    else if (!strcmp(argv[i], "-same-l3"))
+      options->same_l3 = true;
+
     else if (!strcmp(argv[i], "-is-viewer"))
       options->is_viewer_present = 1;
 
@@ -159,6 +323,25 @@ int parse_options(struct cen64_options *options, int argc, const char *argv[]) {
     return 1;
   }
 
+  if (options->profile_path && options->multithread) {
+    printf("Profiling not supported with -multithread.\n");
+    return 1;
+  }
+
+  if (options->lockstep_interval && (options->multithread ||
+    options->profile_path)) {
+    printf("Lockstep not supported with -multithread or -profile.\n");
+    return 1;
+  }
+
+  if (options->lockstep_start && !options->lockstep_interval)
+    options->lockstep_interval = LOCKSTEP_DEFAULT_INTERVAL;
+
+  if (options->ddjournal_path && !options->ddrom_path) {
+    printf("-ddjournal requires a -ddrom argument.\n\n");
+    return 1;
+  }
+
   // Took this out to permit emulation
   // of the 64DD development package.
 #if 0
@@ -254,15 +437,47 @@ void print_command_line_usage(const char *invokation_string) {
 #endif
       "  -debug [addr][:port]       : Starts the debugger on interface:port.\n"
       "                               By default, CEN64 uses localhost:64646.\n"
-      "                               NOTE: the debugger is not implemented yet.\n"
+      "                               Requests are answered once per VI field.\n"
       "  -multithread               : Run in a threaded (but quasi-accurate) mode.\n"
       "                             : This mode cannot be run with the debugger.\n"
       "  -ddipl <path>              : Path to the 64DD IPL ROM (enables 64DD mode).\n"
       "  -ddrom <path>              : Path to the 64DD disk ROM (requires -ddipl).\n"
+      "                               Raw/NDD images, optionally gzip'd.\n"
+      "  -ddjournal <path>          : Keep 64DD disk writes in this journal; the\n"
+      "                               disk image itself is never modified.\n"
       "  -headless                  : Run emulator without user-interface components.\n"
+      "                               Runs until -frames or SIGINT/SIGTERM.\n"
       "  -noaudio                   : Run emulator without audio.\n"
       "  -novideo                   : Run emulator without video.\n"
       "  -is-viewer                 : IS Viewer 64 present.\n"
+      "  -profile <path>            : Sample the guest and write collapsed stacks\n"
+      "                               (for flamegraph.pl) to path on exit.\n"
+      "  -profile-interval <cycles> : VR4300 cycles between profiler samples.\n"
+      "  -lockstep <cycles>         : Run a headless reference instance alongside\n"
+      "                               and compare state every <cycles> VR4300\n"
+      "                               cycles, stopping at the first divergence.\n"
+      "  -lockstep-start <cycle>    : Skip comparisons before <cycle>.\n"
+      "  -speed <multiplier>        : Pace emulation at a multiple of real-time.\n"
+      "  -turbo                     : Run as fast as possible (no pacing).\n"
+      "  -frames <count>            : Exit after count VI fields.\n"
+      "  -texel-cache               : Cache decoded texels per RDP tile until\n"
+      "                               TMEM or the tile changes.\n"
+      "  -no-fast-paths             : Don't use fastmem, predecoded instructions\n"
+      "                               or cache loop batching (-lockstep's reference\n"
+      "                               always runs this way).\n"
+      "  -affinity-ui <cpus>        : Pin the window thread to a CPU list.\n"
+      "  -affinity-rcp <cpus>       : Pin the emulation (RCP) thread to a CPU list.\n"
+      "  -affinity-vr4300 <cpus>    : Pin the VR4300 thread (with -multithread).\n"
+      "  -same-l3                   : Keep unpinned threads on the CPUs that\n"
+      "                               share a L3 cache with the pinned ones.\n"
+      "  -sched-fifo <priority>     : Run the emulation threads as SCHED_FIFO.\n"
+      "  -nice <value>              : Set the nice value of all threads.\n"
+      "  -stats                     : Print frame pacing statistics and host\n"
+      "                               hot-path counters (CEN64_STATS) on exit.\n"
+      "  -stats-json <path>         : Write host hot-path counters to path as JSON.\n"
+      "  -telemetry <path>          : Publish live statistics once a second, as\n"
+      "                               newline-delimited JSON, on a Unix socket.\n"
+      "  -telemetry-binary          : Publish fixed-size binary samples instead.\n"
       "\n"
       "Controller Options:\n"
       "  -controller num=<1-4>      : Controller with no pak.\n"
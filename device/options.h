@@ -11,10 +11,12 @@
 #ifndef __options_h__
 #define __options_h__
 #include "common.h"
+#include "os/common/thread_policy.h"
 
 struct cen64_options {
   const char *ddipl_path;
   const char *ddrom_path;
+  const char *ddjournal_path;
   const char *pifrom_path;
   const char *cart_path;
   const char *debugger_addr;
@@ -23,6 +25,18 @@ struct cen64_options {
   size_t eeprom_size;
   const char *sram_path;
   const char *flashram_path;
+  const char *profile_path;
+  unsigned profile_interval;
+  unsigned lockstep_interval;
+  unsigned long long lockstep_start;
+  const char *stats_json_path;
+  const char *telemetry_path;
+  double speed;
+  unsigned long frame_limit;
+
+  const char *affinity[NUM_CEN64_THREAD_ROLES];
+  int sched_fifo;
+  int nice;
   int is_viewer_present;
 
   struct controller *controller;
@@ -33,8 +47,15 @@ struct cen64_options {
 
   bool enable_debugger;
   bool multithread;
+  bool no_fast_paths;
   bool no_audio;
   bool no_video;
+  bool print_stats;
+  bool telemetry_binary;
+  bool texel_cache;
+  bool turbo;
+  bool renice;
+  bool same_l3;
 };
 
 extern const struct cen64_options default_cen64_options;
@@ -0,0 +1,205 @@
+//
+// device/profiler.c: Guest sampling profiler.
+//
+// CEN64: Cycle-Accurate Nintendo 64 Emulator.
+// Copyright (C) 2015, Tyler J. Stachecki.
+//
+// This file is subject to the terms and conditions defined in
+// 'LICENSE', which is part of this source code package.
+//
+
+#include "common.h"
+#include "device/device.h"
+#include "device/profiler.h"
+#include "rsp/cp0.h"
+#include "rsp/cpu.h"
+#include "vr4300/cpu.h"
+
+#define PROFILER_INITIAL_CAPACITY 4096
+
+static uint64_t profiler_hash_imem(const struct rsp *rsp);
+static size_t profiler_hash_key(unsigned kind,
+  uint64_t tag, uint32_t pc, uint32_t caller);
+
+static void profiler_record(struct cen64_profiler *profiler,
+  unsigned kind, uint64_t tag, uint32_t pc, uint32_t caller);
+static int profiler_grow(struct cen64_profiler *profiler);
+
+// Hashes IMEM (FNV-1a) so RSP samples can be told apart by microcode.
+uint64_t profiler_hash_imem(const struct rsp *rsp) {
+  uint64_t hash = 0xCBF29CE484222325ULL;
+  unsigned i;
+
+  for (i = 0x1000; i < 0x2000; i++) {
+    hash ^= rsp->mem[i];
+    hash *= 0x100000001B3ULL;
+  }
+
+  return hash;
+}
+
+// Mixes the fields of a sample into a bucket index.
+size_t profiler_hash_key(unsigned kind,
+  uint64_t tag, uint32_t pc, uint32_t caller) {
+  uint64_t hash = tag ^ ((uint64_t) caller << 32 | pc) ^ kind;
+
+  hash ^= hash >> 33;
+  hash *= 0xFF51AFD7ED558CCDULL;
+  hash ^= hash >> 33;
+  return (size_t) hash;
+}
+
+// Doubles the size of the table, rehashing all entries.
+int profiler_grow(struct cen64_profiler *profiler) {
+  struct profiler_entry *old_entries = profiler->entries;
+  size_t old_capacity = profiler->capacity;
+  size_t i, capacity = old_capacity << 1;
+  struct profiler_entry *entries;
+
+  if ((entries = calloc(capacity, sizeof(*entries))) == NULL)
+    return 1;
+
+  for (i = 0; i < old_capacity; i++) {
+    const struct profiler_entry *entry = old_entries + i;
+    size_t j;
+
+    if (!entry->count)
+      continue;
+
+    j = profiler_hash_key(entry->kind, entry->tag,
+      entry->pc, entry->caller) & (capacity - 1);
+
+    while (entries[j].count)
+      j = (j + 1) & (capacity - 1);
+
+    entries[j] = *entry;
+  }
+
+  profiler->entries = entries;
+  profiler->capacity = capacity;
+
+  free(old_entries);
+  return 0;
+}
+
+// Bumps the count of a sample, inserting it if not already present.
+void profiler_record(struct cen64_profiler *profiler,
+  unsigned kind, uint64_t tag, uint32_t pc, uint32_t caller) {
+  size_t mask, i;
+
+  // Keep the load factor below 1/2 so probe sequences stay short.
+  if ((profiler->num_entries + 1) << 1 > profiler->capacity) {
+    if (profiler_grow(profiler))
+      return;
+  }
+
+  mask = profiler->capacity - 1;
+  i = profiler_hash_key(kind, tag, pc, caller) & mask;
+
+  while (profiler->entries[i].count) {
+    struct profiler_entry *entry = profiler->entries + i;
+
+    if (entry->kind == kind && entry->tag == tag &&
+      entry->pc == pc && entry->caller == caller) {
+      entry->count++;
+      return;
+    }
+
+    i = (i + 1) & mask;
+  }
+
+  profiler->entries[i].kind = kind;
+  profiler->entries[i].tag = tag;
+  profiler->entries[i].pc = pc;
+  profiler->entries[i].caller = caller;
+  profiler->entries[i].count = 1;
+  profiler->num_entries++;
+}
+
+// Releases resources acquired by profiler_init.
+void profiler_destroy(struct cen64_profiler *profiler) {
+  free(profiler->entries);
+  profiler->entries = NULL;
+}
+
+// Initializes the profiler. The interval is given in VR4300 pcycles
+// and converted to device_spin() iterations (3 pcycles apiece).
+int profiler_init(struct cen64_profiler *profiler, unsigned interval_cycles) {
+  memset(profiler, 0, sizeof(*profiler));
+
+  if ((profiler->entries = calloc(PROFILER_INITIAL_CAPACITY,
+    sizeof(*profiler->entries))) == NULL)
+    return 1;
+
+  profiler->capacity = PROFILER_INITIAL_CAPACITY;
+  profiler->interval = interval_cycles / 3 ? interval_cycles / 3 : 1;
+  return 0;
+}
+
+// Takes a sample of the VR4300 and RSP program counters.
+void profiler_sample(struct cen64_profiler *profiler,
+  const struct cen64_device *device) {
+  const struct vr4300 *vr4300 = &device->vr4300;
+  const struct rsp *rsp = &device->rsp;
+  uint32_t pc, ra;
+
+  // There's no frame pointer to walk, so use $ra as a one-level
+  // call chain. It's only meaningful when it looks like code.
+  pc = vr4300->pipeline.dcwb_latch.common.pc;
+  ra = vr4300->regs[VR4300_REGISTER_RA];
+
+  if (ra & 0x3)
+    ra = 0;
+
+  profiler_record(profiler, PROFILER_SAMPLE_VR4300, 0, pc, ra);
+
+  if (rsp->regs[RSP_CP0_REGISTER_SP_STATUS] & SP_STATUS_HALT)
+    profiler_record(profiler, PROFILER_SAMPLE_RSP_HALTED, 0, 0, 0);
+
+  else {
+    profiler_record(profiler, PROFILER_SAMPLE_RSP, profiler_hash_imem(rsp),
+      rsp->pipeline.dfwb_latch.common.pc, 0);
+  }
+
+  profiler->samples++;
+}
+
+// Dumps samples in the collapsed-stack format used by flamegraph.pl.
+int profiler_write_collapsed(
+  const struct cen64_profiler *profiler, const char *path) {
+  FILE *f;
+  size_t i;
+
+  if ((f = fopen(path, "w")) == NULL)
+    return 1;
+
+  for (i = 0; i < profiler->capacity; i++) {
+    const struct profiler_entry *entry = profiler->entries + i;
+
+    if (!entry->count)
+      continue;
+
+    switch (entry->kind) {
+      case PROFILER_SAMPLE_VR4300:
+        if (entry->caller)
+          fprintf(f, "vr4300;0x%.8X;0x%.8X %lu\n",
+            entry->caller, entry->pc, entry->count);
+        else
+          fprintf(f, "vr4300;0x%.8X %lu\n", entry->pc, entry->count);
+        break;
+
+      case PROFILER_SAMPLE_RSP:
+        fprintf(f, "rsp;ucode_%.16llX;0x%.3X %lu\n",
+          (unsigned long long) entry->tag, entry->pc, entry->count);
+        break;
+
+      case PROFILER_SAMPLE_RSP_HALTED:
+        fprintf(f, "rsp;[halted] %lu\n", entry->count);
+        break;
+    }
+  }
+
+  fclose(f);
+  return 0;
+}
+
@@ -0,0 +1,56 @@
+//
+// device/profiler.h: Guest sampling profiler.
+//
+// CEN64: Cycle-Accurate Nintendo 64 Emulator.
+// Copyright (C) 2015, Tyler J. Stachecki.
+//
+// This file is subject to the terms and conditions defined in
+// 'LICENSE', which is part of this source code package.
+//
+
+#ifndef __device_profiler_h__
+#define __device_profiler_h__
+#include "common.h"
+
+#define PROFILER_DEFAULT_INTERVAL 93750
+
+struct cen64_device;
+
+enum profiler_sample_kind {
+  PROFILER_SAMPLE_VR4300,
+  PROFILER_SAMPLE_RSP,
+  PROFILER_SAMPLE_RSP_HALTED,
+};
+
+struct profiler_entry {
+  uint64_t tag;
+  uint32_t pc;
+  uint32_t caller;
+
+  unsigned long count;
+  unsigned kind;
+};
+
+struct cen64_profiler {
+  struct profiler_entry *entries;
+  size_t num_entries;
+  size_t capacity;
+
+  // Sampling period, in device_spin() iterations.
+  unsigned interval;
+
+  unsigned long samples;
+};
+
+cen64_cold int profiler_init(struct cen64_profiler *profiler,
+  unsigned interval_cycles);
+cen64_cold void profiler_destroy(struct cen64_profiler *profiler);
+
+cen64_cold void profiler_sample(struct cen64_profiler *profiler,
+  const struct cen64_device *device);
+
+cen64_cold int profiler_write_collapsed(
+  const struct cen64_profiler *profiler, const char *path);
+
+#endif
+
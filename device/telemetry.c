@@ -0,0 +1,172 @@
+//
+// device/telemetry.c: Live telemetry over a local socket.
+//
+// CEN64: Cycle-Accurate Nintendo 64 Emulator.
+// Copyright (C) 2015, Tyler J. Stachecki.
+//
+// This file is subject to the terms and conditions defined in
+// 'LICENSE', which is part of this source code package.
+//
+
+#include "common.h"
+#include "device/device.h"
+#include "device/telemetry.h"
+#include "os/common/telemetry.h"
+#include "timer.h"
+
+#ifdef _WIN32
+#include <winsock2.h>
+#else
+#include <arpa/inet.h>
+#endif
+
+static void telemetry_accept(struct cen64_telemetry *telemetry);
+static void telemetry_publish(struct cen64_telemetry *telemetry,
+  unsigned long long ns);
+static void telemetry_snapshot(struct cen64_telemetry *telemetry);
+
+// Picks up any clients that have connected since the last sample.
+void telemetry_accept(struct cen64_telemetry *telemetry) {
+  int fd;
+
+  while (telemetry->num_clients < TELEMETRY_MAX_CLIENTS &&
+    (fd = cen64_telemetry_accept(telemetry->lfd)) >= 0)
+    telemetry->clients[telemetry->num_clients++] = fd;
+}
+
+// Called once per field, right after the governor. Everything is
+// derived from counters the device keeps anyways; rates are deltas
+// of the VR4300's cycle count, with the RCP at 2/3 of it.
+void telemetry_field(struct cen64_telemetry *telemetry) {
+  const cen64_time *now = &telemetry->device->vi.governor.last_field;
+  unsigned long long ns;
+
+  if ((ns = compute_time_difference(now, &telemetry->last_time)) < NS_PER_SEC)
+    return;
+
+  telemetry_accept(telemetry);
+
+  if (telemetry->num_clients > 0)
+    telemetry_publish(telemetry, ns);
+
+  telemetry->last_time = *now;
+  telemetry_snapshot(telemetry);
+}
+
+// Sends a sample covering the last ns nanoseconds to every client.
+// Clients that can't keep up miss samples; they never stall us.
+void telemetry_publish(struct cen64_telemetry *telemetry,
+  unsigned long long ns) {
+  const struct cen64_device *device = telemetry->device;
+  double secs = (double) ns / NS_PER_SEC;
+  double vr4300_cycles, rcp_cycles;
+  double vi_per_sec, mhz, cpi, rsp_utilization, rdp_commands, wait_ms;
+  unsigned long long fields, stall_cycles, halted_cycles;
+  unsigned long ai_underruns;
+  char buf[512];
+  size_t len;
+  unsigned i;
+
+  fields = device->vi.governor.fields - telemetry->fields;
+  vr4300_cycles = device->vr4300.cycles - telemetry->vr4300_cycles;
+  stall_cycles = device->vr4300.pipeline.stall_cycles -
+    telemetry->stall_cycles;
+  halted_cycles = device->rsp.halted_cycles - telemetry->rsp_halted_cycles;
+  ai_underruns = device->ai.underruns - telemetry->ai_underruns;
+
+  // The RCP runs 2 cycles for every 3 of the VR4300's.
+  rcp_cycles = vr4300_cycles * 2.0 / 3.0;
+
+  vi_per_sec = fields / secs;
+  mhz = vr4300_cycles / secs / 1e6;
+  cpi = vr4300_cycles > stall_cycles
+    ? vr4300_cycles / (vr4300_cycles - stall_cycles) : 0.0;
+
+  rsp_utilization = rcp_cycles > halted_cycles
+    ? 1.0 - halted_cycles / rcp_cycles : 0.0;
+
+  rdp_commands = (device->rdp.commands - telemetry->rdp_commands) / secs;
+  wait_ms = (device->rcp_wait_ns + device->vr4300_wait_ns -
+    telemetry->barrier_wait_ns) / 1e6;
+
+  telemetry->sequence++;
+
+  if (telemetry->binary) {
+    struct telemetry_sample sample;
+
+    sample.magic = htonl(TELEMETRY_MAGIC);
+    sample.version = htonl(TELEMETRY_VERSION);
+    sample.sequence = htonl(telemetry->sequence);
+    sample.interval_us = htonl(ns / 1000);
+    sample.vi_per_sec_milli = htonl(vi_per_sec * 1000.0 + 0.5);
+    sample.emulated_khz = htonl(mhz * 1000.0 + 0.5);
+    sample.cpi_milli = htonl(cpi * 1000.0 + 0.5);
+    sample.rsp_utilization_ppm = htonl(rsp_utilization * 1e6 + 0.5);
+    sample.rdp_commands_per_sec = htonl(rdp_commands + 0.5);
+    sample.ai_underruns = htonl(ai_underruns);
+    sample.barrier_wait_us = htonl(wait_ms * 1000.0 + 0.5);
+
+    memcpy(buf, &sample, sizeof(sample));
+    len = sizeof(sample);
+  }
+
+  else {
+    len = snprintf(buf, sizeof(buf), "{\"seq\": %u, \"interval\": %.3f, "
+      "\"vi_per_sec\": %.2f, \"emulated_mhz\": %.2f, \"cpi\": %.3f, "
+      "\"rsp_utilization\": %.4f, \"rdp_commands_per_sec\": %.0f, "
+      "\"ai_underruns\": %lu, \"barrier_wait_ms\": %.3f}\n",
+      telemetry->sequence, secs, vi_per_sec, mhz, cpi,
+      rsp_utilization, rdp_commands, ai_underruns, wait_ms);
+  }
+
+  for (i = 0; i < telemetry->num_clients; ) {
+    if (cen64_telemetry_send(telemetry->clients[i], buf, len) < 0) {
+      cen64_telemetry_close(telemetry->clients[i]);
+      telemetry->clients[i] = telemetry->clients[--telemetry->num_clients];
+    }
+
+    else
+      i++;
+  }
+}
+
+// Records the current counter values for the next sample.
+void telemetry_snapshot(struct cen64_telemetry *telemetry) {
+  const struct cen64_device *device = telemetry->device;
+
+  telemetry->fields = device->vi.governor.fields;
+  telemetry->vr4300_cycles = device->vr4300.cycles;
+  telemetry->stall_cycles = device->vr4300.pipeline.stall_cycles;
+  telemetry->rsp_halted_cycles = device->rsp.halted_cycles;
+  telemetry->rdp_commands = device->rdp.commands;
+  telemetry->barrier_wait_ns = device->rcp_wait_ns + device->vr4300_wait_ns;
+  telemetry->ai_underruns = device->ai.underruns;
+}
+
+// Starts listening for telemetry clients at path.
+int telemetry_start(struct cen64_telemetry *telemetry,
+  struct cen64_device *device, const char *path, bool binary) {
+  memset(telemetry, 0, sizeof(*telemetry));
+
+  if ((telemetry->lfd = cen64_telemetry_listen(path)) < 0)
+    return 1;
+
+  telemetry->device = device;
+  telemetry->path = path;
+  telemetry->binary = binary;
+
+  get_time(&telemetry->last_time);
+  telemetry_snapshot(telemetry);
+  return 0;
+}
+
+// Disconnects all clients and removes the socket.
+void telemetry_stop(struct cen64_telemetry *telemetry) {
+  unsigned i;
+
+  for (i = 0; i < telemetry->num_clients; i++)
+    cen64_telemetry_close(telemetry->clients[i]);
+
+  cen64_telemetry_unlisten(telemetry->lfd, telemetry->path);
+}
+
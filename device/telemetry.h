@@ -0,0 +1,66 @@
+//
+// device/telemetry.h: Live telemetry over a local socket.
+//
+// CEN64: Cycle-Accurate Nintendo 64 Emulator.
+// Copyright (C) 2015, Tyler J. Stachecki.
+//
+// This file is subject to the terms and conditions defined in
+// 'LICENSE', which is part of this source code package.
+//
+
+#ifndef __device_telemetry_h__
+#define __device_telemetry_h__
+#include "common.h"
+#include "timer.h"
+
+#define TELEMETRY_MAGIC 0x43363454U // "C64T"
+#define TELEMETRY_VERSION 1U
+#define TELEMETRY_MAX_CLIENTS 8
+
+struct cen64_device;
+
+// Binary sample; each field is a big-endian uint32_t.
+struct telemetry_sample {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t sequence;
+  uint32_t interval_us;
+
+  uint32_t vi_per_sec_milli;
+  uint32_t emulated_khz;
+  uint32_t cpi_milli;
+  uint32_t rsp_utilization_ppm;
+  uint32_t rdp_commands_per_sec;
+  uint32_t ai_underruns;
+  uint32_t barrier_wait_us;
+};
+
+struct cen64_telemetry {
+  struct cen64_device *device;
+  const char *path;
+  bool binary;
+
+  int lfd;
+  int clients[TELEMETRY_MAX_CLIENTS];
+  unsigned num_clients;
+  uint32_t sequence;
+
+  // Counter values as of the last sample.
+  cen64_time last_time;
+  unsigned long long fields;
+  unsigned long long vr4300_cycles;
+  unsigned long long stall_cycles;
+  unsigned long long rsp_halted_cycles;
+  unsigned long long rdp_commands;
+  unsigned long long barrier_wait_ns;
+  unsigned long ai_underruns;
+};
+
+cen64_cold int telemetry_start(struct cen64_telemetry *telemetry,
+  struct cen64_device *device, const char *path, bool binary);
+cen64_cold void telemetry_stop(struct cen64_telemetry *telemetry);
+
+cen64_cold void telemetry_field(struct cen64_telemetry *telemetry);
+
+#endif
+
@@ -0,0 +1,26 @@
+//
+// os/common/lockstep.h: Lockstep process plumbing.
+//
+// CEN64: Cycle-Accurate Nintendo 64 Emulator.
+// Copyright (C) 2015, Tyler J. Stachecki.
+//
+// This file is subject to the terms and conditions defined in
+// 'LICENSE', which is part of this source code package.
+//
+
+#ifndef CEN64_OS_COMMON_LOCKSTEP
+#define CEN64_OS_COMMON_LOCKSTEP
+#include "common.h"
+#include <stddef.h>
+
+// Implemented by the OS layer. Splits the process in two: the reference
+// instance writes to the returned channel and the other instance reads.
+cen64_cold int cen64_lockstep_fork(int *channel, bool *reference);
+cen64_cold int cen64_lockstep_finish(int channel, bool reference);
+
+cen64_cold int cen64_lockstep_read(int channel, void *data, size_t size);
+cen64_cold int cen64_lockstep_write(int channel,
+  const void *data, size_t size);
+
+#endif
+
@@ -0,0 +1,26 @@
+//
+// os/common/telemetry.h: Telemetry socket plumbing.
+//
+// CEN64: Cycle-Accurate Nintendo 64 Emulator.
+// Copyright (C) 2015, Tyler J. Stachecki.
+//
+// This file is subject to the terms and conditions defined in
+// 'LICENSE', which is part of this source code package.
+//
+
+#ifndef CEN64_OS_COMMON_TELEMETRY
+#define CEN64_OS_COMMON_TELEMETRY
+#include "common.h"
+#include <stddef.h>
+
+// Implemented by the OS layer. None of these block: a send that
+// doesn't fit in the socket buffer returns 1 and writes nothing.
+cen64_cold int cen64_telemetry_listen(const char *path);
+cen64_cold void cen64_telemetry_unlisten(int lfd, const char *path);
+
+cen64_cold int cen64_telemetry_accept(int lfd);
+cen64_cold void cen64_telemetry_close(int fd);
+cen64_cold int cen64_telemetry_send(int fd, const void *data, size_t size);
+
+#endif
+
@@ -0,0 +1,77 @@
+//
+// os/common/thread_policy.c: Thread affinity and scheduling controls.
+//
+// CEN64: Cycle-Accurate Nintendo 64 Emulator.
+// Copyright (C) 2015, Tyler J. Stachecki.
+//
+// This file is subject to the terms and conditions defined in
+// 'LICENSE', which is part of this source code package.
+//
+
+#include "common.h"
+#include "os/common/thread_policy.h"
+
+const char *cen64_thread_role_names[NUM_CEN64_THREAD_ROLES] = {
+  "ui", "rcp", "vr4300",
+};
+
+// Parses a Linux-style CPU list (e.g., "0-3,8,10-11") into a mask.
+// Returns nonzero if the list is malformed or out of range.
+int parse_cpu_list(const char *list, uint8_t *cpus) {
+  const char *s = list;
+
+  memset(cpus, 0, CEN64_MAX_CPUS / 8);
+
+  do {
+    unsigned long first, last, i;
+    char *end;
+
+    first = last = strtoul(s, &end, 10);
+
+    if (end == s)
+      return 1;
+
+    if (*end == '-') {
+      s = end + 1;
+      last = strtoul(s, &end, 10);
+
+      if (end == s || last < first)
+        return 1;
+    }
+
+    if (last >= CEN64_MAX_CPUS)
+      return 1;
+
+    for (i = first; i <= last; i++)
+      cpus[i >> 3] |= 1 << (i & 0x7);
+
+    s = end;
+  } while (*s++ == ',');
+
+  return s[-1] != '\0';
+}
+
+// Formats a CPU mask as a CPU list, collapsing runs into ranges.
+void format_cpu_list(const uint8_t *cpus, char *buf, size_t size) {
+  size_t len = 0;
+  unsigned i, j;
+
+  buf[0] = '\0';
+
+  for (i = 0; i < CEN64_MAX_CPUS && len < size; i = j) {
+    if (!(cpus[i >> 3] & (1 << (i & 0x7)))) {
+      j = i + 1;
+      continue;
+    }
+
+    for (j = i + 1; j < CEN64_MAX_CPUS &&
+      (cpus[j >> 3] & (1 << (j & 0x7))); j++);
+
+    if (j - 1 > i)
+      len += snprintf(buf + len, size - len, "%s%u-%u",
+        len ? "," : "", i, j - 1);
+    else
+      len += snprintf(buf + len, size - len, "%s%u", len ? "," : "", i);
+  }
+}
+
@@ -0,0 +1,46 @@
+//
+// os/common/thread_policy.h: Thread affinity and scheduling controls.
+//
+// CEN64: Cycle-Accurate Nintendo 64 Emulator.
+// Copyright (C) 2015, Tyler J. Stachecki.
+//
+// This file is subject to the terms and conditions defined in
+// 'LICENSE', which is part of this source code package.
+//
+
+#ifndef CEN64_OS_COMMON_THREAD_POLICY
+#define CEN64_OS_COMMON_THREAD_POLICY
+#include "common.h"
+
+#define CEN64_MAX_CPUS 1024
+
+enum cen64_thread_role {
+  CEN64_THREAD_UI,
+  CEN64_THREAD_RCP,
+  CEN64_THREAD_VR4300,
+  NUM_CEN64_THREAD_ROLES
+};
+
+struct cen64_thread_policy {
+  uint8_t cpus[CEN64_MAX_CPUS / 8];
+  bool pinned;
+
+  // SCHED_FIFO priority; zero leaves the default policy.
+  int fifo_priority;
+
+  int nice;
+  bool renice;
+};
+
+extern const char *cen64_thread_role_names[NUM_CEN64_THREAD_ROLES];
+
+cen64_cold int parse_cpu_list(const char *list, uint8_t *cpus);
+cen64_cold void format_cpu_list(const uint8_t *cpus, char *buf, size_t size);
+
+// Implemented by the OS layer. A cpu of -1 means the current CPU.
+cen64_cold int cen64_thread_apply_policy(enum cen64_thread_role role,
+  const struct cen64_thread_policy *policy);
+cen64_cold int cen64_thread_get_l3_cpus(int cpu, uint8_t *cpus);
+
+#endif
+
@@ -0,0 +1,116 @@
+//
+// os/posix/lockstep.c: Lockstep process plumbing.
+//
+// CEN64: Cycle-Accurate Nintendo 64 Emulator.
+// Copyright (C) 2015, Tyler J. Stachecki.
+//
+// This file is subject to the terms and conditions defined in
+// 'LICENSE', which is part of this source code package.
+//
+
+#include "common.h"
+#include "os/common/lockstep.h"
+#include <errno.h>
+#include <signal.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+static pid_t reference_pid;
+
+// Forks off the reference instance, connected by a pipe.
+int cen64_lockstep_fork(int *channel, bool *reference) {
+  int fds[2];
+
+  if (pipe(fds)) {
+    printf("Lockstep: failed to create a pipe.\n");
+    return 1;
+  }
+
+  // Buffered output would be flushed by both processes.
+  fflush(stdout);
+
+  if ((reference_pid = fork()) < 0) {
+    printf("Lockstep: failed to fork the reference instance.\n");
+    close(fds[0]);
+    close(fds[1]);
+    return 1;
+  }
+
+  // The reference must notice when the other side goes away
+  // rather than being killed outright.
+  if (reference_pid == 0) {
+    signal(SIGPIPE, SIG_IGN);
+    close(fds[0]);
+
+    *channel = fds[1];
+    *reference = true;
+  }
+
+  else {
+    close(fds[1]);
+
+    *channel = fds[0];
+    *reference = false;
+  }
+
+  return 0;
+}
+
+// Closes the channel; the non-reference side reaps the reference.
+int cen64_lockstep_finish(int channel, bool reference) {
+  int status;
+
+  close(channel);
+
+  if (reference)
+    return 0;
+
+  while (waitpid(reference_pid, &status, 0) < 0) {
+    if (errno != EINTR)
+      return 1;
+  }
+
+  return !WIFEXITED(status) || WEXITSTATUS(status) != 0;
+}
+
+// Reads exactly size bytes from the channel.
+int cen64_lockstep_read(int channel, void *data, size_t size) {
+  uint8_t *ptr = (uint8_t *) data;
+
+  while (size > 0) {
+    ssize_t len = read(channel, ptr, size);
+
+    if (len < 0 && errno == EINTR)
+      continue;
+
+    if (len <= 0)
+      return 1;
+
+    ptr += len;
+    size -= len;
+  }
+
+  return 0;
+}
+
+// Writes exactly size bytes to the channel.
+int cen64_lockstep_write(int channel, const void *data, size_t size) {
+  const uint8_t *ptr = (const uint8_t *) data;
+
+  while (size > 0) {
+    ssize_t len = write(channel, ptr, size);
+
+    if (len < 0 && errno == EINTR)
+      continue;
+
+    if (len <= 0)
+      return 1;
+
+    ptr += len;
+    size -= len;
+  }
+
+  return 0;
+}
+
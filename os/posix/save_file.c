@@ -22,6 +22,18 @@ int close_save_file(const struct save_file *file) {
   return 0;
 }
 
+// Remaps a save privately, so that writes no longer reach the file.
+int detach_save_file(struct save_file *file) {
+  if (file->ptr == NULL)
+    return 0;
+
+  if (mmap(file->ptr, file->size, PROT_READ|PROT_WRITE,
+    MAP_PRIVATE|MAP_FIXED, file->fd, 0) == MAP_FAILED)
+    return -1;
+
+  return 0;
+}
+
 // Maps a save into the host address space, returns a pointer.
 int open_save_file(const char *path, size_t size, struct save_file *file, int *created) {
   struct stat sb;
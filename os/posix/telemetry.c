@@ -0,0 +1,123 @@
+//
+// os/posix/telemetry.c: Telemetry socket plumbing.
+//
+// CEN64: Cycle-Accurate Nintendo 64 Emulator.
+// Copyright (C) 2015, Tyler J. Stachecki.
+//
+// This file is subject to the terms and conditions defined in
+// 'LICENSE', which is part of this source code package.
+//
+
+#include "common.h"
+#include "os/common/telemetry.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+static int cen64_telemetry_set_nonblocking(int fd);
+
+// Puts a socket into non-blocking mode.
+int cen64_telemetry_set_nonblocking(int fd) {
+  int flags;
+
+  if ((flags = fcntl(fd, F_GETFL, 0)) < 0)
+    return 1;
+
+  return fcntl(fd, F_SETFL, flags | O_NONBLOCK) < 0;
+}
+
+// Creates a listening Unix-domain socket at path.
+int cen64_telemetry_listen(const char *path) {
+  struct sockaddr_un addr;
+  struct stat st;
+  int fd;
+
+  if (strlen(path) >= sizeof(addr.sun_path)) {
+    printf("Telemetry: socket path is too long.\n");
+    return -1;
+  }
+
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  strcpy(addr.sun_path, path);
+
+  // Clean up after an earlier run, but never clobber a regular file.
+  if (lstat(path, &st) == 0 && S_ISSOCK(st.st_mode))
+    unlink(path);
+
+  if ((fd = socket(AF_UNIX, SOCK_STREAM, 0)) < 0) {
+    printf("Telemetry: failed to create a socket.\n");
+    return -1;
+  }
+
+  if (bind(fd, (struct sockaddr *) &addr, sizeof(addr)) ||
+    listen(fd, 4) || cen64_telemetry_set_nonblocking(fd)) {
+    printf("Telemetry: failed to listen on %s.\n", path);
+    close(fd);
+    return -1;
+  }
+
+  return fd;
+}
+
+// Closes the listening socket and removes it from the filesystem.
+void cen64_telemetry_unlisten(int lfd, const char *path) {
+  close(lfd);
+  unlink(path);
+}
+
+// Accepts a pending client, if there is one.
+int cen64_telemetry_accept(int lfd) {
+  int fd;
+
+  if ((fd = accept(lfd, NULL, NULL)) < 0)
+    return -1;
+
+  if (cen64_telemetry_set_nonblocking(fd)) {
+    close(fd);
+    return -1;
+  }
+
+#ifdef SO_NOSIGPIPE
+  {
+    int one = 1;
+
+    setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &one, sizeof(one));
+  }
+#endif
+
+  return fd;
+}
+
+// Closes a client socket.
+void cen64_telemetry_close(int fd) {
+  close(fd);
+}
+
+// Sends a sample without blocking. Returns 1 if the client isn't
+// keeping up (nothing was sent) and -1 if it should be dropped.
+int cen64_telemetry_send(int fd, const void *data, size_t size) {
+  ssize_t len;
+
+  do {
+    len = send(fd, data, size, MSG_DONTWAIT | MSG_NOSIGNAL);
+  } while (len < 0 && errno == EINTR);
+
+  if (len == (ssize_t) size)
+    return 0;
+
+  if (len < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+    return 1;
+
+  // A short write would leave the stream mid-record.
+  return -1;
+}
+
@@ -0,0 +1,157 @@
+//
+// os/posix/thread_policy.c: Thread affinity and scheduling controls.
+//
+// CEN64: Cycle-Accurate Nintendo 64 Emulator.
+// Copyright (C) 2015, Tyler J. Stachecki.
+//
+// This file is subject to the terms and conditions defined in
+// 'LICENSE', which is part of this source code package.
+//
+
+// Needed for the affinity interfaces (cpu_set_t and friends).
+#define _GNU_SOURCE
+
+#include "common.h"
+#include "os/common/thread_policy.h"
+#include <pthread.h>
+#include <sched.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
+
+// Applies the policy to the calling thread and reports the result.
+int cen64_thread_apply_policy(enum cen64_thread_role role,
+  const struct cen64_thread_policy *policy) {
+  const char *name = cen64_thread_role_names[role];
+  struct sched_param param;
+  char cpu_list[256];
+  int status = 0;
+  int sched;
+
+#ifdef __linux__
+  pid_t tid = syscall(SYS_gettid);
+  uint8_t cpus[CEN64_MAX_CPUS / 8];
+  cpu_set_t set;
+  unsigned i;
+
+  if (policy->pinned) {
+    CPU_ZERO(&set);
+
+    for (i = 0; i < CEN64_MAX_CPUS && i < CPU_SETSIZE; i++) {
+      if (policy->cpus[i >> 3] & (1 << (i & 0x7)))
+        CPU_SET(i, &set);
+    }
+
+    if (sched_setaffinity(tid, sizeof(set), &set)) {
+      printf("Failed to set the CPU affinity of the %s thread.\n", name);
+      status = 1;
+    }
+  }
+
+  // Linux applies nice values per thread (the TID is a PID).
+  if (policy->renice && setpriority(PRIO_PROCESS, tid, policy->nice)) {
+    printf("Failed to set the nice value of the %s thread.\n", name);
+    status = 1;
+  }
+
+  memset(cpus, 0, sizeof(cpus));
+  strcpy(cpu_list, "?");
+
+  if (!sched_getaffinity(tid, sizeof(set), &set)) {
+    for (i = 0; i < CEN64_MAX_CPUS && i < CPU_SETSIZE; i++) {
+      if (CPU_ISSET(i, &set))
+        cpus[i >> 3] |= 1 << (i & 0x7);
+    }
+
+    format_cpu_list(cpus, cpu_list, sizeof(cpu_list));
+  }
+#else
+  if (policy->pinned || policy->renice) {
+    printf("CPU affinity and per-thread nice values "
+      "are not supported on this platform.\n");
+    status = 1;
+  }
+
+  strcpy(cpu_list, "any");
+#endif
+
+  if (policy->fifo_priority) {
+    param.sched_priority = policy->fifo_priority;
+
+    if (pthread_setschedparam(pthread_self(), SCHED_FIFO, &param)) {
+      printf("Failed to make the %s thread SCHED_FIFO "
+        "(insufficient privileges?).\n", name);
+      status = 1;
+    }
+  }
+
+  if (pthread_getschedparam(pthread_self(), &sched, &param))
+    sched = SCHED_OTHER;
+
+  if (sched == SCHED_FIFO) {
+    printf("Thread %-6s: CPUs %s, SCHED_FIFO %d\n",
+      name, cpu_list, param.sched_priority);
+  }
+
+  else {
+#ifdef __linux__
+    printf("Thread %-6s: CPUs %s, nice %d\n",
+      name, cpu_list, getpriority(PRIO_PROCESS, tid));
+#else
+    printf("Thread %-6s: CPUs %s\n", name, cpu_list);
+#endif
+  }
+
+  return status;
+}
+
+// Finds the CPUs that share a L3 cache with the given CPU.
+int cen64_thread_get_l3_cpus(int cpu, uint8_t *cpus) {
+#ifdef __linux__
+  char path[128], buf[256];
+  unsigned i;
+
+  if (cpu < 0 && (cpu = sched_getcpu()) < 0)
+    return 1;
+
+  // The index numbering varies; look for the one at level 3.
+  for (i = 0; i < 8; i++) {
+    unsigned level;
+    FILE *f;
+
+    sprintf(path, "/sys/devices/system/cpu/cpu%d/cache/index%u/level", cpu, i);
+
+    if ((f = fopen(path, "r")) == NULL)
+      break;
+
+    if (fscanf(f, "%u", &level) != 1)
+      level = 0;
+
+    fclose(f);
+
+    if (level != 3)
+      continue;
+
+    sprintf(path, "/sys/devices/system/cpu/cpu%d/"
+      "cache/index%u/shared_cpu_list", cpu, i);
+
+    if ((f = fopen(path, "r")) == NULL)
+      return 1;
+
+    if (fgets(buf, sizeof(buf), f) == NULL) {
+      fclose(f);
+      return 1;
+    }
+
+    fclose(f);
+    buf[strcspn(buf, "\n")] = '\0';
+    return parse_cpu_list(buf, cpus);
+  }
+#endif
+
+  return 1;
+}
+
@@ -18,6 +18,10 @@
 #define NS_PER_USEC 1000
 #endif
 
+// Sleeps tend to overshoot by tens of microseconds (more under
+// load), so give the scheduler this much slack and spin the rest.
+#define TIMER_SPIN_NS 1000000ULL
+
 // Computes the difference, in ns, between two times.
 unsigned long long compute_time_difference(
   const cen64_time *now, const cen64_time *before) {
@@ -39,3 +43,24 @@ void get_time(cen64_time *t) {
 #endif
 }
 
+// Waits until ns nanoseconds have elapsed since base. Sleeps for
+// the bulk of the interval, then spins so we wake up on time.
+void wait_until(const cen64_time *base, unsigned long long ns) {
+  unsigned long long elapsed;
+  struct timespec req;
+  cen64_time now;
+
+  for (get_time(&now); (elapsed = compute_time_difference(
+    &now, base)) < ns; get_time(&now)) {
+    unsigned long long remaining = ns - elapsed;
+
+    if (remaining > TIMER_SPIN_NS) {
+      remaining -= TIMER_SPIN_NS;
+
+      req.tv_sec = remaining / NS_PER_SEC;
+      req.tv_nsec = remaining % NS_PER_SEC;
+      nanosleep(&req, NULL);
+    }
+  }
+}
+
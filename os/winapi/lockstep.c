@@ -0,0 +1,31 @@
+//
+// os/winapi/lockstep.c: Lockstep process plumbing.
+//
+// CEN64: Cycle-Accurate Nintendo 64 Emulator.
+// Copyright (C) 2015, Tyler J. Stachecki.
+//
+// This file is subject to the terms and conditions defined in
+// 'LICENSE', which is part of this source code package.
+//
+
+#include "common.h"
+#include "os/common/lockstep.h"
+
+// TODO: Spawn the reference instance with CreateProcess.
+int cen64_lockstep_fork(int *channel, bool *reference) {
+  printf("Lockstep: not supported on this platform.\n");
+  return 1;
+}
+
+int cen64_lockstep_finish(int channel, bool reference) {
+  return 0;
+}
+
+int cen64_lockstep_read(int channel, void *data, size_t size) {
+  return 1;
+}
+
+int cen64_lockstep_write(int channel, const void *data, size_t size) {
+  return 1;
+}
+
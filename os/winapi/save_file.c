@@ -20,6 +20,11 @@ int close_save_file(const struct save_file *file) {
   return 0;
 }
 
+// TODO: Remap copy-on-write (only lockstep needs this).
+int detach_save_file(struct save_file *file) {
+  return file->ptr == NULL ? 0 : -1;
+}
+
 // Maps a ROM into the host address space, returns a pointer.
 int open_save_file(const char *path, size_t size,
   struct save_file *file, int *created) {
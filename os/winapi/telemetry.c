@@ -0,0 +1,33 @@
+//
+// os/winapi/telemetry.c: Telemetry socket plumbing.
+//
+// CEN64: Cycle-Accurate Nintendo 64 Emulator.
+// Copyright (C) 2015, Tyler J. Stachecki.
+//
+// This file is subject to the terms and conditions defined in
+// 'LICENSE', which is part of this source code package.
+//
+
+#include "common.h"
+#include "os/common/telemetry.h"
+
+// TODO: AF_UNIX is available on recent versions of Windows 10.
+int cen64_telemetry_listen(const char *path) {
+  printf("Telemetry: not supported on this platform.\n");
+  return -1;
+}
+
+void cen64_telemetry_unlisten(int lfd, const char *path) {
+}
+
+int cen64_telemetry_accept(int lfd) {
+  return -1;
+}
+
+void cen64_telemetry_close(int fd) {
+}
+
+int cen64_telemetry_send(int fd, const void *data, size_t size) {
+  return -1;
+}
+
@@ -0,0 +1,75 @@
+//
+// os/winapi/thread_policy.c: Thread affinity and scheduling controls.
+//
+// CEN64: Cycle-Accurate Nintendo 64 Emulator.
+// Copyright (C) 2015, Tyler J. Stachecki.
+//
+// This file is subject to the terms and conditions defined in
+// 'LICENSE', which is part of this source code package.
+//
+
+#include "common.h"
+#include "os/common/thread_policy.h"
+#include <windows.h>
+
+// Applies the policy to the calling thread and reports the result.
+// Only the first 64 CPUs (one processor group) can be addressed.
+int cen64_thread_apply_policy(enum cen64_thread_role role,
+  const struct cen64_thread_policy *policy) {
+  const char *name = cen64_thread_role_names[role];
+  HANDLE thread = GetCurrentThread();
+  int priority = THREAD_PRIORITY_NORMAL;
+  char cpu_list[256];
+  int status = 0;
+
+  if (policy->pinned) {
+    DWORD_PTR mask = 0;
+    unsigned i;
+
+    for (i = 0; i < sizeof(mask) * 8; i++) {
+      if (policy->cpus[i >> 3] & (1 << (i & 0x7)))
+        mask |= (DWORD_PTR) 1 << i;
+    }
+
+    if (!SetThreadAffinityMask(thread, mask)) {
+      printf("Failed to set the CPU affinity of the %s thread.\n", name);
+      status = 1;
+    }
+
+    format_cpu_list(policy->cpus, cpu_list, sizeof(cpu_list));
+  }
+
+  else
+    strcpy(cpu_list, "any");
+
+  // There are no real-time classes here; approximate with priorities.
+  if (policy->fifo_priority)
+    priority = THREAD_PRIORITY_TIME_CRITICAL;
+
+  else if (policy->renice) {
+    if (policy->nice <= -10)
+      priority = THREAD_PRIORITY_HIGHEST;
+    else if (policy->nice < 0)
+      priority = THREAD_PRIORITY_ABOVE_NORMAL;
+    else if (policy->nice >= 10)
+      priority = THREAD_PRIORITY_LOWEST;
+    else if (policy->nice > 0)
+      priority = THREAD_PRIORITY_BELOW_NORMAL;
+  }
+
+  if (!SetThreadPriority(thread, priority)) {
+    printf("Failed to set the priority of the %s thread.\n", name);
+    status = 1;
+  }
+
+  printf("Thread %-6s: CPUs %s, priority %d\n",
+    name, cpu_list, GetThreadPriority(thread));
+
+  return status;
+}
+
+// Finds the CPUs that share a L3 cache with the given CPU.
+int cen64_thread_get_l3_cpus(int cpu, uint8_t *cpus) {
+  return 1; // TODO: GetLogicalProcessorInformationEx.
+}
+
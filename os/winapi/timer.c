@@ -26,3 +26,20 @@ void get_time(cen64_time *t) {
   *t = timeGetTime();
 }
 
+// Waits until ns nanoseconds have elapsed since base. Sleeps for
+// the bulk of the interval, then spins so we wake up on time.
+void wait_until(const cen64_time *base, unsigned long long ns) {
+  unsigned long long elapsed;
+  cen64_time now;
+
+  // timeGetTime() only has millisecond resolution (and Sleep() is
+  // coarser still), so leave a couple of ticks worth to spin.
+  for (get_time(&now); (elapsed = compute_time_difference(
+    &now, base)) < ns; get_time(&now)) {
+    unsigned long long remaining = ns - elapsed;
+
+    if (remaining > 2000000ULL)
+      Sleep((DWORD) ((remaining - 2000000ULL) / 1000000ULL));
+  }
+}
+
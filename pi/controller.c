@@ -69,7 +69,8 @@ static int pi_dma_read(struct pi_controller *pi) {
 
     // SRAM
     if (pi->sram->ptr != NULL && addr + length <= 0x8000)
-      memcpy((uint8_t *) (pi->sram->ptr) + addr, pi->bus->ri->ram + source, length);
+      ri_copy_from_rdram(pi->bus->ri, source,
+        (uint8_t *) (pi->sram->ptr) + addr, length);
 
     // FlashRAM: Save the RDRAM destination address. Writing happens
     // after the system sends the flash write command (handled in
@@ -89,17 +90,20 @@ static int pi_dma_write(struct pi_controller *pi) {
   uint32_t dest = pi->regs[PI_DRAM_ADDR_REG] & 0x7FFFFF;
   uint32_t source = pi->regs[PI_CART_ADDR_REG] & 0xFFFFFFF;
   uint32_t length = (pi->regs[PI_WR_LEN_REG] & 0xFFFFFF) + 1;
+  uint32_t written;
 
   if (length & 7)
     length = (length + 7) & ~7;
 
+  written = length;
+
   if (pi->bus->dd->ipl_rom && (source & 0x06000000) == 0x06000000) {
     source &= 0x003FFFFF;
 
     if (source + length > 0x003FFFFF)
       length = 0x003FFFFF - source;
 
-    memcpy(pi->bus->ri->ram + dest, pi->bus->dd->ipl_rom + source, length);
+    ri_copy_to_rdram(pi->bus->ri, dest, pi->bus->dd->ipl_rom + source, length);
   }
 
   else if ((source & 0x05000000) == 0x05000000)
@@ -110,18 +114,19 @@ static int pi_dma_write(struct pi_controller *pi) {
     uint32_t addr = source & 0x00FFFFF;
 
     if (pi->sram->ptr != NULL && addr + length <= 0x8000)
-      memcpy(pi->bus->ri->ram + dest, (const uint8_t *) (pi->sram->ptr) + addr, length);
+      ri_copy_to_rdram(pi->bus->ri, dest,
+        (const uint8_t *) (pi->sram->ptr) + addr, length);
 
     else if (pi->flashram.data != NULL) {
       // SRAM
       if (pi->flashram.mode == FLASHRAM_STATUS) {
         uint64_t status = htonll(pi->flashram.status);
-        memcpy(pi->bus->ri->ram + dest, &status, 8);
+        ri_copy_to_rdram(pi->bus->ri, dest, (const uint8_t *) &status, 8);
       }
 
       // FlashRAM
       else if (pi->flashram.mode == FLASHRAM_READ)
-        memcpy(pi->bus->ri->ram + dest, pi->flashram.data + addr * 2, length);
+        ri_copy_to_rdram(pi->bus->ri, dest, pi->flashram.data + addr * 2, length);
     }
   }
 
@@ -138,7 +143,8 @@ static int pi_dma_write(struct pi_controller *pi) {
       for (i = (pi->regs[PI_CART_ADDR_REG] + pi->rom_size + 3) & ~0x3;
           i < pi->regs[PI_CART_ADDR_REG] + length; i += 4) {
         uint32_t word = (i >> 16) | (i & 0xFFFF0000);
-        memcpy(pi->bus->ri->ram + dest + i, &word, sizeof(word));
+        ri_copy_to_rdram(pi->bus->ri, dest + i,
+          (const uint8_t *) &word, sizeof(word));
       }
 
       length = pi->rom_size - source;
@@ -146,9 +152,10 @@ static int pi_dma_write(struct pi_controller *pi) {
 
     // TODO: Very hacky.
     if (source < pi->rom_size)
-      memcpy(pi->bus->ri->ram + dest, pi->rom + source, length);
+      ri_copy_to_rdram(pi->bus->ri, dest, pi->rom + source, length);
   }
 
+  ri_mark_written_range(pi->bus->ri, dest, written);
   return 0;
 }
 
@@ -165,6 +172,16 @@ int pi_init(struct pi_controller *pi, struct bus_controller *bus,
   pi->is_viewer = is_viewer;
 
   pi->bytes_to_copy = 0;
+
+  // Cart ROM reads bypass read_cart_rom, except for the IS-Viewer.
+  if (rom != NULL) {
+    bus_map_fastmem(bus, ROM_CART_BASE_ADDRESS, rom_size < ROM_CART_ADDRESS_LEN
+      ? (uint32_t) rom_size : ROM_CART_ADDRESS_LEN, rom);
+
+    if (is_viewer != NULL)
+      bus_unmap_fastmem(bus, is_viewer->base_address, is_viewer->len);
+  }
+
   return 0;
 }
 
@@ -318,8 +335,8 @@ int write_flashram(void *opaque, uint32_t address, uint32_t word, uint32_t dqm)
         memset(pi->flashram.data + pi->flashram.offset, 0xFF, 0x80);
 
       else if (pi->flashram.mode == FLASHRAM_WRITE)
-        memcpy(pi->flashram.data + pi->flashram.offset,
-            pi->bus->ri->ram + pi->flashram.rdram_pointer, 0x80);
+        ri_copy_from_rdram(pi->bus->ri, pi->flashram.rdram_pointer,
+            pi->flashram.data + pi->flashram.offset, 0x80);
 
       break;
 
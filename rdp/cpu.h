@@ -26,6 +26,9 @@ extern const char *dp_register_mnemonics[NUM_DP_REGISTERS];
 struct rdp {
   uint32_t regs[NUM_DP_REGISTERS];
   struct bus_controller *bus;
+
+  unsigned long long commands;
+  bool texel_cache;
 };
 
 cen64_cold int rdp_init(struct rdp *rdp, struct bus_controller *bus);
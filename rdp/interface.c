@@ -10,8 +10,10 @@
 
 #include "common.h"
 #include "bus/address.h"
+#include "common/stats.h"
 #include "rdp/cpu.h"
 #include "rdp/interface.h"
+#include "timer.h"
 
 #define DP_XBUS_DMEM_DMA          0x00000001
 #define DP_FREEZE                 0x00000002
@@ -53,7 +55,21 @@ int write_dp_regs(void *opaque, uint32_t address, uint32_t word, uint32_t dqm) {
 
     case DPC_END_REG:
       rdp->regs[DPC_END_REG] = word;
+
+#ifdef CEN64_STATS
+      {
+        cen64_time start, end;
+
+        get_time(&start);
+        rdp_process_list();
+        get_time(&end);
+
+        stats_inc(rdp_lists);
+        stats_add(rdp_host_ns, compute_time_difference(&end, &start));
+      }
+#else
       rdp_process_list();
+#endif
       break;
 
     case DPC_STATUS_REG:
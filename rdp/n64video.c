@@ -74,6 +74,7 @@ MarathonMan
 
 #include "common.h"
 #include "bus/controller.h"
+#include "common/stats.h"
 #include "device/device.h"
 #include "ri/controller.h"
 #include "tctables.h"
@@ -187,10 +188,12 @@ static struct cen64_device *cen64;
 
 FILE *rdp_exec;
 
-uint32_t rdp_cmd_data[0x10000];
-uint32_t rdp_cmd_ptr = 0;
-uint32_t rdp_cmd_cur = 0;
-uint32_t ptr_onstart = 0;
+// Commands are decoded in place from RDRAM or DMEM. Only a command that
+// straddles the end of either (or the end of the list) is staged.
+static const uint32_t *rdp_cmd_words;
+static int rdp_cmd_swap;
+static uint32_t rdp_cmd_stage[44];
+static uint32_t rdp_cmd_staged;
 
 extern FILE* zeldainfo;
 
@@ -508,6 +511,22 @@ uint8_t TMEM[0x1000];
 
 #define tlut ((uint16_t*)(&TMEM[0x800]))
 
+// Decoded texels of each tile, packed as RGBA8888. An entry is
+// rechecked against its key and the TMEM hash whenever it is invalidated.
+#define TEXEL_CACHE_MAX_TEXELS	0x4000
+
+typedef struct
+{
+	uint64_t tmem_hash;
+	uint32_t key;
+	int32_t width, height;
+	int valid;
+	uint32_t texels[TEXEL_CACHE_MAX_TEXELS];
+} TEXEL_CACHE;
+
+static TEXEL_CACHE texel_cache[8];
+static uint64_t texel_cache_tmem_hash = 0;
+
 #define PIXELS_TO_BYTES(pix, siz) (((pix) << (siz)) >> 1)
 
 typedef struct{
@@ -526,6 +545,10 @@ static void fetch_texel(COLOR *color, int s, int t, uint32_t tilenum);
 static void fetch_texel_entlut(COLOR *color, int s, int t, uint32_t tilenum);
 static void fetch_texel_quadro(COLOR *color0, COLOR *color1, COLOR *color2, COLOR *color3, int s0, int s1, int t0, int t1, uint32_t tilenum);
 static void fetch_texel_entlut_quadro(COLOR *color0, COLOR *color1, COLOR *color2, COLOR *color3, int s0, int s1, int t0, int t1, uint32_t tilenum);
+static void texel_cache_build(uint32_t tilenum);
+static void texel_cache_tmem_changed(void);
+static inline int fetch_cached_texel(COLOR *color, int s, int t, uint32_t tilenum);
+static inline int fetch_cached_texel_quadro(COLOR *color0, COLOR *color1, COLOR *color2, COLOR *color3, int s0, int s1, int t0, int t1, uint32_t tilenum);
 static void tile_tlut_common_cs_decoder(uint32_t w1, uint32_t w2);
 static void loading_pipeline(int start, int end, int tilenum, int coord_quad, int ltlut);
 static void get_tmem_idx(int s, int t, uint32_t tilenum, uint32_t* idx0, uint32_t* idx1, uint32_t* idx2, uint32_t* idx3, uint32_t* bit3flipped, uint32_t* hibit);
@@ -740,39 +763,74 @@ CVtcmaskDERIVATIVE cvarray[0x100];
 #define RDRAM_MASK 0x007fffff
 
 
-#define RREADADDR8(rdst, in) {(in) &= RDRAM_MASK; (rdst) = ((in) <= plim) ? (rdram_8[(in)]) : 0;}
-#define RREADIDX16(rdst, in) {(in) &= (RDRAM_MASK >> 1); (rdst) = ((in) <= idxlim16) ? (byteswap_16(rdram_16[(in)])) : 0;}
-#define RREADIDX32(rdst, in) {(in) &= (RDRAM_MASK >> 2); (rdst) = ((in) <= idxlim32) ? (byteswap_32(rdram[(in)])) : 0;}
+#ifdef CEN64_NATIVE_RDRAM
+#define RDRAM_HOST16(x) (x)
+#define RDRAM_HOST32(x) (x)
+#define RDRAM_SWAP32 0
+#else
+#define RDRAM_HOST16(x) byteswap_16(x)
+#define RDRAM_HOST32(x) byteswap_32(x)
+#define RDRAM_SWAP32 1
+#endif
+#define RDRAM_HALF_XOR (RDRAM_BYTE_XOR >> 1)
+
+#define RREADADDR8(rdst, in) {(in) &= RDRAM_MASK; (rdst) = ((in) <= plim) ? (rdram_8[(in) ^ RDRAM_BYTE_XOR]) : 0;}
+#define RREADIDX16(rdst, in) {(in) &= (RDRAM_MASK >> 1); (rdst) = ((in) <= idxlim16) ? (RDRAM_HOST16(rdram_16[(in) ^ RDRAM_HALF_XOR])) : 0;}
+#define RREADIDX32(rdst, in) {(in) &= (RDRAM_MASK >> 2); (rdst) = ((in) <= idxlim32) ? (RDRAM_HOST32(rdram[(in)])) : 0;}
 
-#define RWRITEADDR8(in, val)	{(in) &= RDRAM_MASK; if ((in) <= plim) rdram_8[(in)] = (val);}
-#define RWRITEIDX16(in, val)	{(in) &= (RDRAM_MASK >> 1); if ((in) <= idxlim16) rdram_16[(in)] = byteswap_16(val);}
-#define RWRITEIDX32(in, val)	{(in) &= (RDRAM_MASK >> 2); if ((in) <= idxlim32) rdram[(in)] = byteswap_32(val);}
+#define RWRITEADDR8(in, val)	{(in) &= RDRAM_MASK; if ((in) <= plim) {rdram_8[(in) ^ RDRAM_BYTE_XOR] = (val); ri_mark_written(&cen64->ri, (in));}}
+#define RWRITEIDX16(in, val)	{(in) &= (RDRAM_MASK >> 1); if ((in) <= idxlim16) {rdram_16[(in) ^ RDRAM_HALF_XOR] = RDRAM_HOST16(val); ri_mark_written(&cen64->ri, (in) << 1);}}
+#define RWRITEIDX32(in, val)	{(in) &= (RDRAM_MASK >> 2); if ((in) <= idxlim32) {rdram[(in)] = RDRAM_HOST32(val); ri_mark_written(&cen64->ri, (in) << 2);}}
 
 
 
 #define PAIRREAD16(rdst, hdst, in)		\
 {										\
 	(in) &= (RDRAM_MASK >> 1);			\
-	if ((in) <= idxlim16) {(rdst) = byteswap_16(rdram_16[(in)]); (hdst) = hidden_bits[(in)];}	\
+	if ((in) <= idxlim16) {(rdst) = RDRAM_HOST16(rdram_16[(in) ^ RDRAM_HALF_XOR]); (hdst) = hidden_bits[(in)];}	\
 	else {(rdst) = (hdst) = 0;}			\
 }
 
 #define PAIRWRITE16(in, rval, hval)		\
 {										\
 	(in) &= (RDRAM_MASK >> 1);			\
-	if ((in) <= idxlim16) {rdram_16[(in)] = byteswap_16(rval); hidden_bits[(in)] = (hval);}	\
+	if ((in) <= idxlim16) {rdram_16[(in) ^ RDRAM_HALF_XOR] = RDRAM_HOST16(rval); hidden_bits[(in)] = (hval); ri_mark_written(&cen64->ri, (in) << 1);}	\
 }
 
 #define PAIRWRITE32(in, rval, hval0, hval1)	\
 {											\
 	(in) &= (RDRAM_MASK >> 2);				\
-	if ((in) <= idxlim32) {rdram[(in)] = byteswap_32(rval); hidden_bits[(in) << 1] = (hval0); hidden_bits[((in) << 1) + 1] = (hval1);}	\
+	if ((in) <= idxlim32) {rdram[(in)] = RDRAM_HOST32(rval); hidden_bits[(in) << 1] = (hval0); hidden_bits[((in) << 1) + 1] = (hval1); ri_mark_written(&cen64->ri, (in) << 2);}	\
 }
 
 #define PAIRWRITE8(in, rval, hval)	\
 {									\
 	(in) &= RDRAM_MASK;				\
-	if ((in) <= plim) {rdram_8[(in)] = (rval); if ((in) & 1) hidden_bits[(in) >> 1] = (hval);}	\
+	if ((in) <= plim) {rdram_8[(in) ^ RDRAM_BYTE_XOR] = (rval); if ((in) & 1) hidden_bits[(in) >> 1] = (hval); ri_mark_written(&cen64->ri, (in));}	\
+}
+
+static inline uint32_t rdp_cmd_word(unsigned i)
+{
+	return rdp_cmd_swap ? byteswap_32(rdp_cmd_words[i]) : rdp_cmd_words[i];
+}
+
+static inline void rdp_cmd_copy(int32_t *dest, unsigned first, unsigned count)
+{
+	unsigned i;
+
+	for (i = 0; i < count; i++)
+		dest[i] = rdp_cmd_word(first + i);
+}
+
+static inline uint32_t rdp_cmd_fetch(uint32_t idx, int xbus)
+{
+	uint32_t word;
+
+	if (xbus)
+		return byteswap_32(rsp_dmem[idx & 0x3ff]);
+
+	RREADIDX32(word, idx);
+	return word;
 }
 
 struct onetime
@@ -2339,7 +2397,7 @@ static void fetch_texel_entlut(COLOR *color, int s, int t, uint32_t tilenum)
 	uint32_t tpal	= tile[tilenum].palette << 4;
 	uint16_t *tc16 = (uint16_t*)TMEM;
 	uint32_t taddr = 0;
-	uint32_t c;
+	uint32_t c = 0;
 
 	
 	
@@ -3513,6 +3571,141 @@ static void fetch_texel_entlut_quadro(COLOR *color0, COLOR *color1, COLOR *color
 }
 
 
+static uint64_t texel_cache_hash_tmem(void)
+{
+	uint64_t h0 = 0xcbf29ce484222325ULL, h1 = h0, h2 = h0, h3 = h0;
+	uint64_t w[4];
+	int i;
+
+	for (i = 0; i < 0x1000; i += 32)
+	{
+		memcpy(w, &TMEM[i], sizeof(w));
+		h0 = (h0 ^ w[0]) * 0x100000001b3ULL;
+		h1 = (h1 ^ w[1]) * 0x100000001b3ULL;
+		h2 = (h2 ^ w[2]) * 0x100000001b3ULL;
+		h3 = (h3 ^ w[3]) * 0x100000001b3ULL;
+	}
+
+	return h0 ^ (h1 << 1 | h1 >> 63) ^ (h2 << 2 | h2 >> 62) ^ (h3 << 3 | h3 >> 61);
+}
+
+
+static void texel_cache_tmem_changed(void)
+{
+	int i;
+
+	if (!cen64->rdp.texel_cache)
+		return;
+
+	texel_cache_tmem_hash = texel_cache_hash_tmem();
+
+	for (i = 0; i < 8; i++)
+		if (texel_cache[i].tmem_hash != texel_cache_tmem_hash)
+			texel_cache[i].valid = 0;
+}
+
+
+void angrylion_rdp_tmem_written(void)
+{
+	texel_cache_tmem_changed();
+}
+
+
+static void texel_cache_build(uint32_t tilenum)
+{
+	TEXEL_CACHE *cache = &texel_cache[tilenum];
+	int32_t width, height, s, t;
+	uint32_t key, *texel;
+	COLOR c;
+
+	width = tile[tilenum].mask_s ? maskbits_table[tile[tilenum].mask_s] + 1 : tile[tilenum].f.clampdiffs + 2;
+	height = tile[tilenum].mask_t ? maskbits_table[tile[tilenum].mask_t] + 1 : tile[tilenum].f.clampdifft + 2;
+
+	key = (other_modes.en_tlut << 28) | (other_modes.tlut_type << 27) |
+		(tile[tilenum].format << 24) | (tile[tilenum].size << 22) |
+		(tile[tilenum].palette << 18) | (tile[tilenum].line << 9) | tile[tilenum].tmem;
+
+	cache->valid = 1;
+
+	if (tile[tilenum].format == FORMAT_YUV || (tile[tilenum].format > FORMAT_I && !other_modes.en_tlut) ||
+		width * height > TEXEL_CACHE_MAX_TEXELS)
+	{
+		cache->width = cache->height = 0;
+		return;
+	}
+
+	if (cache->key == key && cache->width == width && cache->height == height &&
+		cache->tmem_hash == texel_cache_tmem_hash)
+		return;
+
+	texel = cache->texels;
+
+	for (t = 0; t < height; t++)
+	{
+		for (s = 0; s < width; s++)
+		{
+			if (!other_modes.en_tlut)
+				fetch_texel(&c, s, t, tilenum);
+			else
+				fetch_texel_entlut(&c, s, t, tilenum);
+
+			*texel++ = c.r | (c.g << 8) | (c.b << 16) | ((uint32_t)c.a << 24);
+		}
+	}
+
+	cache->key = key;
+	cache->width = width;
+	cache->height = height;
+	cache->tmem_hash = texel_cache_tmem_hash;
+}
+
+
+static inline void texel_cache_unpack(COLOR *color, uint32_t texel)
+{
+	color->r = texel & 0xff;
+	color->g = (texel >> 8) & 0xff;
+	color->b = (texel >> 16) & 0xff;
+	color->a = texel >> 24;
+}
+
+
+static inline int fetch_cached_texel(COLOR *color, int s, int t, uint32_t tilenum)
+{
+	TEXEL_CACHE *cache = &texel_cache[tilenum];
+
+	if (!cache->valid)
+		texel_cache_build(tilenum);
+
+	if ((uint32_t)s >= (uint32_t)cache->width || (uint32_t)t >= (uint32_t)cache->height)
+		return 0;
+
+	texel_cache_unpack(color, cache->texels[t * cache->width + s]);
+	return 1;
+}
+
+
+static inline int fetch_cached_texel_quadro(COLOR *color0, COLOR *color1, COLOR *color2, COLOR *color3, int s0, int s1, int t0, int t1, uint32_t tilenum)
+{
+	TEXEL_CACHE *cache = &texel_cache[tilenum];
+	const uint32_t *row0, *row1;
+
+	if (!cache->valid)
+		texel_cache_build(tilenum);
+
+	if ((uint32_t)s0 >= (uint32_t)cache->width || (uint32_t)s1 >= (uint32_t)cache->width ||
+		(uint32_t)t0 >= (uint32_t)cache->height || (uint32_t)t1 >= (uint32_t)cache->height)
+		return 0;
+
+	row0 = &cache->texels[t0 * cache->width];
+	row1 = &cache->texels[t1 * cache->width];
+	texel_cache_unpack(color0, row0[s0]);
+	texel_cache_unpack(color1, row0[s1]);
+	texel_cache_unpack(color2, row1[s0]);
+	texel_cache_unpack(color3, row1[s1]);
+	return 1;
+}
+
+
 void get_tmem_idx(int s, int t, uint32_t tilenum, uint32_t* idx0, uint32_t* idx1, uint32_t* idx2, uint32_t* idx3, uint32_t* bit3flipped, uint32_t* hibit)
 {
 	uint32_t tbase = (tile[tilenum].line * t) & 0x1ff;
@@ -3932,10 +4125,13 @@ static inline void texture_pipeline_cycle(COLOR* TEX, COLOR* prev, int32_t SSS,
 		if (bilerp)
 		{
 			
-			if (!other_modes.en_tlut)
-				fetch_texel_quadro(&t0, &t1, &t2, &t3, sss1, sss2, sst1, sst2, tilenum);
-			else
-				fetch_texel_entlut_quadro(&t0, &t1, &t2, &t3, sss1, sss2, sst1, sst2, tilenum);
+			if (!cen64->rdp.texel_cache || !fetch_cached_texel_quadro(&t0, &t1, &t2, &t3, sss1, sss2, sst1, sst2, tilenum))
+			{
+				if (!other_modes.en_tlut)
+					fetch_texel_quadro(&t0, &t1, &t2, &t3, sss1, sss2, sst1, sst2, tilenum);
+				else
+					fetch_texel_entlut_quadro(&t0, &t1, &t2, &t3, sss1, sss2, sst1, sst2, tilenum);
+			}
 
 
 			if (!other_modes.mid_texel || sfrac != 0x10 || tfrac != 0x10)
@@ -4003,10 +4199,13 @@ static inline void texture_pipeline_cycle(COLOR* TEX, COLOR* prev, int32_t SSS,
 		}
 		else
 		{
-			if (!other_modes.en_tlut)
-				fetch_texel(&t0, sss1, sst1, tilenum);
-			else
-				fetch_texel_entlut(&t0, sss1, sst1, tilenum);
+			if (!cen64->rdp.texel_cache || !fetch_cached_texel(&t0, sss1, sst1, tilenum))
+			{
+				if (!other_modes.en_tlut)
+					fetch_texel(&t0, sss1, sst1, tilenum);
+				else
+					fetch_texel_entlut(&t0, sss1, sst1, tilenum);
+			}
 			if (convert)
 				t0 = *prev;
 
@@ -4035,10 +4234,13 @@ static inline void texture_pipeline_cycle(COLOR* TEX, COLOR* prev, int32_t SSS,
         tcmask(&sss1, &sst1, tilenum);	
 																										
 			
-		if (!other_modes.en_tlut)
-			fetch_texel(&t0, sss1, sst1, tilenum);
-		else
-			fetch_texel_entlut(&t0, sss1, sst1, tilenum);
+		if (!cen64->rdp.texel_cache || !fetch_cached_texel(&t0, sss1, sst1, tilenum))
+		{
+			if (!other_modes.en_tlut)
+				fetch_texel(&t0, sss1, sst1, tilenum);
+			else
+				fetch_texel_entlut(&t0, sss1, sst1, tilenum);
+		}
 		
 		if (bilerp)
 		{
@@ -6522,15 +6724,15 @@ static int rdp_dasm(char *buffer)
 	uint32_t length;
 	uint32_t command;
 
-	length = rdp_cmd_ptr * 4;
+	length = rdp_command_length[(rdp_cmd_word(0) >> 24) & 0x3f];
 	if (length < 8)
 	{
 		sprintf(buffer, "ERROR: length = %d\n", length);
 		return 0;
 	}
 
-	cmd[0] = rdp_cmd_data[rdp_cmd_cur+0];
-	cmd[1] = rdp_cmd_data[rdp_cmd_cur+1];
+	cmd[0] = rdp_cmd_word(0);
+	cmd[1] = rdp_cmd_word(1);
 
 	tile = (cmd[1] >> 24) & 0x7;
 	sprintf(sl, "%4.2f", (float)((cmd[0] >> 12) & 0xfff) / 4.0f);
@@ -6577,12 +6779,12 @@ static int rdp_dasm(char *buffer)
 				return 0;
 			}
 
-			cmd[2] = rdp_cmd_data[rdp_cmd_cur+2];
-			cmd[3] = rdp_cmd_data[rdp_cmd_cur+3];
-			cmd[4] = rdp_cmd_data[rdp_cmd_cur+4];
-			cmd[5] = rdp_cmd_data[rdp_cmd_cur+5];
-			cmd[6] = rdp_cmd_data[rdp_cmd_cur+6];
-			cmd[7] = rdp_cmd_data[rdp_cmd_cur+7];
+			cmd[2] = rdp_cmd_word(2);
+			cmd[3] = rdp_cmd_word(3);
+			cmd[4] = rdp_cmd_word(4);
+			cmd[5] = rdp_cmd_word(5);
+			cmd[6] = rdp_cmd_word(6);
+			cmd[7] = rdp_cmd_word(7);
 
 			sprintf(yl,		"%4.4f", (float)((cmd[0] >>  0) & 0x1fff) / 4.0f);
 			sprintf(ym,		"%4.4f", (float)((cmd[1] >> 16) & 0x1fff) / 4.0f);
@@ -6609,7 +6811,7 @@ static int rdp_dasm(char *buffer)
 
 			for (i=2; i < 24; i++)
 			{
-				cmd[i] = rdp_cmd_data[rdp_cmd_cur+i];
+				cmd[i] = rdp_cmd_word(i);
 			}
 
 			sprintf(yl,		"%4.4f", (float)((cmd[0] >>  0) & 0x1fff) / 4.0f);
@@ -6659,7 +6861,7 @@ static int rdp_dasm(char *buffer)
 
 			for (i=2; i < 24; i++)
 			{
-				cmd[i] = rdp_cmd_data[i];
+				cmd[i] = rdp_cmd_word(i);
 			}
 
 			sprintf(yl,		"%4.4f", (float)((cmd[0] >>  0) & 0x1fff) / 4.0f);
@@ -6711,7 +6913,7 @@ static int rdp_dasm(char *buffer)
 
 			for (i=2; i < 40; i++)
 			{
-				cmd[i] = rdp_cmd_data[rdp_cmd_cur+i];
+				cmd[i] = rdp_cmd_word(i);
 			}
 
 			sprintf(yl,		"%4.4f", (float)((cmd[0] >>  0) & 0x1fff) / 4.0f);
@@ -6783,8 +6985,8 @@ static int rdp_dasm(char *buffer)
 				sprintf(buffer, "ERROR: Texture_Rectangle length = %d\n", length);
 				return 0;
 			}
-			cmd[2] = rdp_cmd_data[rdp_cmd_cur+2];
-			cmd[3] = rdp_cmd_data[rdp_cmd_cur+3];
+			cmd[2] = rdp_cmd_word(2);
+			cmd[3] = rdp_cmd_word(3);
 			sprintf(s,    "%4.4f", (float)(int16_t)((cmd[2] >> 16) & 0xffff) / 32.0f);
 			sprintf(t,    "%4.4f", (float)(int16_t)((cmd[2] >>  0) & 0xffff) / 32.0f);
 			sprintf(dsdx, "%4.4f", (float)(int16_t)((cmd[3] >> 16) & 0xffff) / 1024.0f);
@@ -6845,7 +7047,7 @@ static void rdp_noop(uint32_t w1, uint32_t w2)
 static void rdp_tri_noshade(uint32_t w1, uint32_t w2)
 {
 	int32_t ewdata[44];
-	memcpy(&ewdata[0], &rdp_cmd_data[rdp_cmd_cur], 8 * sizeof(int32_t));
+	rdp_cmd_copy(&ewdata[0], 0, 8);
 	memset(&ewdata[8], 0, 36 * sizeof(int32_t));
 	edgewalker_for_prims(ewdata);
 }
@@ -6853,18 +7055,18 @@ static void rdp_tri_noshade(uint32_t w1, uint32_t w2)
 static void rdp_tri_noshade_z(uint32_t w1, uint32_t w2)
 {
 	int32_t ewdata[44];
-	memcpy(&ewdata[0], &rdp_cmd_data[rdp_cmd_cur], 8 * sizeof(int32_t));
+	rdp_cmd_copy(&ewdata[0], 0, 8);
 	memset(&ewdata[8], 0, 32 * sizeof(int32_t));
-	memcpy(&ewdata[40], &rdp_cmd_data[rdp_cmd_cur + 8], 4 * sizeof(int32_t));
+	rdp_cmd_copy(&ewdata[40], 8, 4);
 	edgewalker_for_prims(ewdata);
 }
 
 static void rdp_tri_tex(uint32_t w1, uint32_t w2)
 {
 	int32_t ewdata[44];
-	memcpy(&ewdata[0], &rdp_cmd_data[rdp_cmd_cur], 8 * sizeof(int32_t));
+	rdp_cmd_copy(&ewdata[0], 0, 8);
 	memset(&ewdata[8], 0, 16 * sizeof(int32_t));
-	memcpy(&ewdata[24], &rdp_cmd_data[rdp_cmd_cur + 8], 16 * sizeof(int32_t));
+	rdp_cmd_copy(&ewdata[24], 8, 16);
 	memset(&ewdata[40], 0, 4 * sizeof(int32_t));
 	edgewalker_for_prims(ewdata);
 }
@@ -6872,17 +7074,17 @@ static void rdp_tri_tex(uint32_t w1, uint32_t w2)
 static void rdp_tri_tex_z(uint32_t w1, uint32_t w2)
 {
 	int32_t ewdata[44];
-	memcpy(&ewdata[0], &rdp_cmd_data[rdp_cmd_cur], 8 * sizeof(int32_t));
+	rdp_cmd_copy(&ewdata[0], 0, 8);
 	memset(&ewdata[8], 0, 16 * sizeof(int32_t));
-	memcpy(&ewdata[24], &rdp_cmd_data[rdp_cmd_cur + 8], 16 * sizeof(int32_t));
-	memcpy(&ewdata[40], &rdp_cmd_data[rdp_cmd_cur + 24], 4 * sizeof(int32_t));
+	rdp_cmd_copy(&ewdata[24], 8, 16);
+	rdp_cmd_copy(&ewdata[40], 24, 4);
 	edgewalker_for_prims(ewdata);
 }
 
 static void rdp_tri_shade(uint32_t w1, uint32_t w2)
 {
 	int32_t ewdata[44];
-	memcpy(&ewdata[0], &rdp_cmd_data[rdp_cmd_cur], 24 * sizeof(int32_t));
+	rdp_cmd_copy(&ewdata[0], 0, 24);
 	memset(&ewdata[24], 0, 20 * sizeof(int32_t));
 	edgewalker_for_prims(ewdata);
 }
@@ -6890,16 +7092,16 @@ static void rdp_tri_shade(uint32_t w1, uint32_t w2)
 static void rdp_tri_shade_z(uint32_t w1, uint32_t w2)
 {
 	int32_t ewdata[44];
-	memcpy(&ewdata[0], &rdp_cmd_data[rdp_cmd_cur], 24 * sizeof(int32_t));
+	rdp_cmd_copy(&ewdata[0], 0, 24);
 	memset(&ewdata[24], 0, 16 * sizeof(int32_t));
-	memcpy(&ewdata[40], &rdp_cmd_data[rdp_cmd_cur + 24], 4 * sizeof(int32_t));
+	rdp_cmd_copy(&ewdata[40], 24, 4);
 	edgewalker_for_prims(ewdata);
 }
 
 static void rdp_tri_texshade(uint32_t w1, uint32_t w2)
 {
 	int32_t ewdata[44];
-	memcpy(&ewdata[0], &rdp_cmd_data[rdp_cmd_cur], 40 * sizeof(int32_t));
+	rdp_cmd_copy(&ewdata[0], 0, 40);
 	memset(&ewdata[40], 0, 4 * sizeof(int32_t));
 	edgewalker_for_prims(ewdata);
 }
@@ -6907,14 +7109,14 @@ static void rdp_tri_texshade(uint32_t w1, uint32_t w2)
 static void rdp_tri_texshade_z(uint32_t w1, uint32_t w2)
 {
 	int32_t ewdata[44];
-	memcpy(&ewdata[0], &rdp_cmd_data[rdp_cmd_cur], 44 * sizeof(int32_t));
+	rdp_cmd_copy(&ewdata[0], 0, 44);
 	edgewalker_for_prims(ewdata);
 }
 
 static void rdp_tex_rect(uint32_t w1, uint32_t w2)
 {
-	uint32_t w3 = rdp_cmd_data[rdp_cmd_cur + 2];
-	uint32_t w4 = rdp_cmd_data[rdp_cmd_cur + 3];
+	uint32_t w3 = rdp_cmd_word(2);
+	uint32_t w4 = rdp_cmd_word(3);
 
 	
 	uint32_t tilenum	= (w2 >> 24) & 0x7;
@@ -6973,8 +7175,8 @@ static void rdp_tex_rect(uint32_t w1, uint32_t w2)
 
 static void rdp_tex_rect_flip(uint32_t w1, uint32_t w2)
 {
-	uint32_t w3 = rdp_cmd_data[rdp_cmd_cur+2];
-	uint32_t w4 = rdp_cmd_data[rdp_cmd_cur+3];
+	uint32_t w3 = rdp_cmd_word(2);
+	uint32_t w4 = rdp_cmd_word(3);
 	
 	
 	uint32_t tilenum	= (w2 >> 24) & 0x7;
@@ -7166,6 +7368,9 @@ static void rdp_set_other_modes(uint32_t w1, uint32_t w2)
 	other_modes.dither_alpha_en		= (w2 >> 1) & 1;
 	other_modes.alpha_compare_en	= (w2) & 1;
 
+	for (int i = 0; i < 8; i++)
+		texel_cache[i].valid = 0;
+
 	SET_BLENDER_INPUT(0, 0, &blender1a_r[0], &blender1a_g[0], &blender1a_b[0], &blender1b_a[0],
 					  other_modes.blend_m1a_0, other_modes.blend_m1b_0);
 	SET_BLENDER_INPUT(0, 1, &blender2a_r[0], &blender2a_g[0], &blender2a_b[0], &blender2b_a[0],
@@ -7314,7 +7519,7 @@ static void rdp_load_block(uint32_t w1, uint32_t w2)
 	lewdata[9] = 0x20;
 
 	edgewalker_for_loads(lewdata);
-
+	texel_cache_tmem_changed();
 }
 
 static void rdp_load_tlut(uint32_t w1, uint32_t w2)
@@ -7357,6 +7562,7 @@ void tile_tlut_common_cs_decoder(uint32_t w1, uint32_t w2)
 	lewdata[9] = 0x20;
 
 	edgewalker_for_loads(lewdata);
+	texel_cache_tmem_changed();
 }
 
 static void rdp_set_tile(uint32_t w1, uint32_t w2)
@@ -7547,91 +7753,46 @@ static void (*const rdp_command_table[64])(uint32_t w1, uint32_t w2) =
 
 void rdp_process_list(void)
 {
-	int i, length;
 	uint32_t cmd, cmd_length;
-	uint32_t dp_current_al = dp_current & ~7, dp_end_al = dp_end & ~7; 
+	uint32_t idx = (dp_current & ~7) >> 2, end = (dp_end & ~7) >> 2;
+	int xbus = (dp_status & DP_STATUS_XBUS_DMA) != 0;
 
 	dp_status &= ~DP_STATUS_FREEZE;
-	
-	
-	
-	
 
-	
-
-	if (dp_end_al <= dp_current_al)
-	{
-		
-		
-		
-		
-		
-		
+	if (end <= idx)
 		return;
-	}
-
-	length = (dp_end_al - dp_current_al) >> 2;
-
-	ptr_onstart = rdp_cmd_ptr;
-
 
-
-	uint32_t remaining_length = length;
-
-
-	dp_current_al >>= 2;
-
-	while (remaining_length)
+	while (idx < end && !rdp_pipeline_crashed)
 	{
+		cmd = ((rdp_cmd_staged ? rdp_cmd_stage[0] : rdp_cmd_fetch(idx, xbus)) >> 24) & 0x3f;
+		cmd_length = rdp_command_length[cmd] >> 2;
 
-	int toload = remaining_length > 0x10000 ? 0x10000 : remaining_length;
-
-
-	if (dp_status & DP_STATUS_XBUS_DMA)
-	{
-		for (i = 0; i < toload; i ++)
+		if (!rdp_cmd_staged && end - idx >= cmd_length && (xbus
+			? (idx & 0x3ff) + cmd_length <= 0x400
+			: (idx & (RDRAM_MASK >> 2)) + cmd_length - 1 <= idxlim32))
 		{
-			rdp_cmd_data[rdp_cmd_ptr] = byteswap_32(rsp_dmem[dp_current_al & 0x3ff]);
-			rdp_cmd_ptr++;
-			dp_current_al++;
-		}
-	}
-	else
-	{
-		for (i = 0; i < toload; i ++)
-		{
-			RREADIDX32(rdp_cmd_data[rdp_cmd_ptr], dp_current_al);
-			rdp_cmd_ptr++;
-			dp_current_al++;
-		}
-	}
-
-	remaining_length -= toload;
+			rdp_cmd_words = xbus
+				? &rsp_dmem[idx & 0x3ff]
+				: &rdram[idx & (RDRAM_MASK >> 2)];
 
-	while (rdp_cmd_cur < rdp_cmd_ptr && !rdp_pipeline_crashed)
-	{
-		cmd = (rdp_cmd_data[rdp_cmd_cur] >> 24) & 0x3f;
-		cmd_length = rdp_command_length[cmd] >> 2;
+			rdp_cmd_swap = xbus || RDRAM_SWAP32;
+			idx += cmd_length;
+		}
 
-		
-		
-		if ((rdp_cmd_ptr - rdp_cmd_cur) < cmd_length)
+		else
 		{
+			while (rdp_cmd_staged < cmd_length && idx < end)
+				rdp_cmd_stage[rdp_cmd_staged++] = rdp_cmd_fetch(idx++, xbus);
 
-			if (!remaining_length)
-			{
-
-				dp_start = dp_current = dp_end;
-				return;
-			}
-			else
-			{
-				dp_current_al -= (rdp_cmd_ptr - rdp_cmd_cur);
-				remaining_length += (rdp_cmd_ptr - rdp_cmd_cur);
+			// The rest of the command comes with the next list.
+			if (rdp_cmd_staged < cmd_length)
 				break;
-			}
+
+			rdp_cmd_words = rdp_cmd_stage;
+			rdp_cmd_swap = 0;
+			rdp_cmd_staged = 0;
 		}
-		
+
 		if (LOG_RDP_EXECUTION)
 		{
 			char string[4000];
@@ -7641,27 +7802,18 @@ void rdp_process_list(void)
 
 
 			rdp_dasm(string);
-			fprintf(rdp_exec, "%08X: %08X %08X   %s\n", command_counter, rdp_cmd_data[rdp_cmd_cur+0], rdp_cmd_data[rdp_cmd_cur+1], string);
+			fprintf(rdp_exec, "%08X: %08X %08X   %s\n", command_counter, rdp_cmd_word(0), rdp_cmd_word(1), string);
 			}
 			command_counter++;
 		}
 
-		
-		
-		
-
-		
-		rdp_command_table[cmd](rdp_cmd_data[rdp_cmd_cur+0], rdp_cmd_data[rdp_cmd_cur + 1]);
-		
-		rdp_cmd_cur += cmd_length;
-	};
-	rdp_cmd_ptr = 0;
-	rdp_cmd_cur = 0;
-	};
+		cen64->rdp.commands++;
+		stats_inc(rdp_commands);
+		stats_inc(rdp_command_counts[cmd]);
+		rdp_command_table[cmd](rdp_cmd_word(0), rdp_cmd_word(1));
+	}
 
 	dp_start = dp_current = dp_end;
-
-
 }
 
 static inline int alpha_compare(int32_t comb_alpha)
@@ -8928,7 +9080,7 @@ static inline void restore_filter16(int* r, int* g, int* b, uint32_t fboffset, u
 #define VI_COMPARE_OPT(x)											\
 {																	\
 	addr = (x);														\
-	pix = byteswap_16(rdram_16[addr]);							\
+	pix = RDRAM_HOST16(rdram_16[addr ^ RDRAM_HALF_XOR]);							\
 	tempr = (pix >> 11) & 0x1f;										\
 	tempg = (pix >> 6) & 0x1f;										\
 	tempb = (pix >> 1) & 0x1f;										\
@@ -9012,7 +9164,7 @@ static inline void restore_filter32(int* r, int* g, int* b, uint32_t fboffset, u
 #define VI_COMPARE32_OPT(x)													\
 {																		\
 	addr = (x);															\
-	pix = byteswap_32(rdram[addr]);												\
+	pix = RDRAM_HOST32(rdram[addr]);												\
 	tempr = (pix >> 27) & 0x1f;											\
 	tempg = (pix >> 19) & 0x1f;											\
 	tempb = (pix >> 11) & 0x1f;											\
@@ -9175,6 +9327,7 @@ static inline void video_max_optimized(uint32_t* pixels, uint32_t* penumin, uint
 
 static void calculate_clamp_diffs(uint32_t i)
 {
+	texel_cache[i].valid = 0;
 	tile[i].f.clampdiffs = ((tile[i].sh >> 2) - (tile[i].sl >> 2)) & 0x3ff;
 	tile[i].f.clampdifft = ((tile[i].th >> 2) - (tile[i].tl >> 2)) & 0x3ff;
 }
@@ -9182,6 +9335,7 @@ static void calculate_clamp_diffs(uint32_t i)
 
 static void calculate_tile_derivs(uint32_t i)
 {
+	texel_cache[i].valid = 0;
 	tile[i].f.clampens = tile[i].cs || !tile[i].mask_s;
 	tile[i].f.clampent = tile[i].ct || !tile[i].mask_t;
 	tile[i].f.masksclamped = tile[i].mask_s <= 10 ? tile[i].mask_s : 10;
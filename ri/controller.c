@@ -39,16 +39,70 @@ int ri_init(struct ri_controller *ri, struct bus_controller *bus) {
   ri->regs[RI_SELECT_REG] = 0x14;
   ri->regs[RI_REFRESH_REG] = 0x63634;
 
+  ri->generation = 1;
   return 0;
 }
 
+// Ends the current generation and returns it. Writes from here on
+// are reported by ri_written_since() for the returned generation.
+uint32_t ri_close_generation(struct ri_controller *ri) {
+  return ri->generation++;
+}
+
+// Copies RDRAM out as the big-endian byte stream the N64 would see.
+void ri_copy_from_rdram(const struct ri_controller *ri,
+  uint32_t offset, uint8_t *dest, uint32_t length) {
+#if RDRAM_BYTE_XOR
+  uint32_t i = 0;
+
+  for (; i < length && ((offset + i) & 0x3); i++)
+    dest[i] = ri->ram[(offset + i) ^ RDRAM_BYTE_XOR];
+
+  for (; length - i >= sizeof(uint32_t); i += sizeof(uint32_t)) {
+    uint32_t word;
+
+    memcpy(&word, ri->ram + offset + i, sizeof(word));
+    word = byteswap_32(word);
+    memcpy(dest + i, &word, sizeof(word));
+  }
+
+  for (; i < length; i++)
+    dest[i] = ri->ram[(offset + i) ^ RDRAM_BYTE_XOR];
+#else
+  memcpy(dest, ri->ram + offset, length);
+#endif
+}
+
+// Copies a big-endian byte stream into RDRAM. Callers stamp the pages.
+void ri_copy_to_rdram(struct ri_controller *ri,
+  uint32_t offset, const uint8_t *src, uint32_t length) {
+#if RDRAM_BYTE_XOR
+  uint32_t i = 0;
+
+  for (; i < length && ((offset + i) & 0x3); i++)
+    ri->ram[(offset + i) ^ RDRAM_BYTE_XOR] = src[i];
+
+  for (; length - i >= sizeof(uint32_t); i += sizeof(uint32_t)) {
+    uint32_t word;
+
+    memcpy(&word, src + i, sizeof(word));
+    word = byteswap_32(word);
+    memcpy(ri->ram + offset + i, &word, sizeof(word));
+  }
+
+  for (; i < length; i++)
+    ri->ram[(offset + i) ^ RDRAM_BYTE_XOR] = src[i];
+#else
+  memcpy(ri->ram + offset, src, length);
+#endif
+}
+
 // Reads a word from RDRAM.
 int read_rdram(void *opaque, uint32_t address, uint32_t *word) {
   struct ri_controller *ri = (struct ri_controller *) opaque;
   unsigned offset = address - RDRAM_BASE_ADDRESS;
 
-  memcpy(word, ri->ram + offset, sizeof(*word));
-  *word = byteswap_32(*word);
+  *word = ri_read_word(ri, offset);
   return 0;
 }
 
@@ -78,15 +132,30 @@ int read_ri_regs(void *opaque, uint32_t address, uint32_t *word) {
 int write_rdram(void *opaque, uint32_t address, uint32_t word, uint32_t dqm) {
   struct ri_controller *ri = (struct ri_controller *) opaque;
   unsigned offset = address - RDRAM_BASE_ADDRESS;
-  uint32_t orig_word;
 
-  memcpy(&orig_word, ri->ram + offset, sizeof(orig_word));
-  orig_word = byteswap_32(orig_word) & ~dqm;
-  word = byteswap_32(orig_word | word);
-  memcpy(ri->ram + offset, &word, sizeof(word));
+  ri_write_word(ri, offset, word, dqm);
   return 0;
 }
 
+// Returns true if any page under [offset, offset + length) has been
+// written since the generation was closed. Writes racing with the
+// close (from another thread) may land in either generation.
+bool ri_written_since(const struct ri_controller *ri,
+  uint32_t offset, uint32_t length, uint32_t generation) {
+  uint32_t page = offset >> RDRAM_PAGE_SHIFT;
+  uint32_t last = (offset + length - 1) >> RDRAM_PAGE_SHIFT;
+
+  if (last >= RDRAM_NUM_PAGES)
+    last = RDRAM_NUM_PAGES - 1;
+
+  for (; length && page <= last; page++) {
+    if ((int32_t) (ri->page_generations[page] - generation) > 0)
+      return true;
+  }
+
+  return false;
+}
+
 // Writes a word to the RDRAM MMIO register space.
 int write_rdram_regs(void *opaque, uint32_t address, uint32_t word, uint32_t dqm) {
   struct ri_controller *ri = (struct ri_controller *) opaque;
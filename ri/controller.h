@@ -14,6 +14,19 @@
 
 #define MAX_RDRAM_SIZE 0x800000U
 
+// Writes to RDRAM are tracked in pages of this size.
+#define RDRAM_PAGE_SHIFT 12
+#define RDRAM_NUM_PAGES (MAX_RDRAM_SIZE >> RDRAM_PAGE_SHIFT)
+
+// RDRAM is big-endian unless CEN64_NATIVE_RDRAM is set. Then every
+// aligned word is kept in host order and byte i of the big-endian
+// image lives at i ^ RDRAM_BYTE_XOR.
+#if defined(CEN64_NATIVE_RDRAM) && !defined(BIG_ENDIAN_HOST)
+#define RDRAM_BYTE_XOR 3
+#else
+#define RDRAM_BYTE_XOR 0
+#endif
+
 struct bus_controller *bus;
 
 enum rdram_register {
@@ -44,6 +57,11 @@ struct ri_controller {
   uint32_t rdram_regs[NUM_RDRAM_REGISTERS];
   uint32_t regs[NUM_RI_REGISTERS];
 
+  // Generation during which each page was last written. Writers
+  // only stamp pages; consumers close generations and compare.
+  uint32_t page_generations[RDRAM_NUM_PAGES];
+  uint32_t generation;
+
   uint64_t force_ram_alignment;
   uint8_t ram[MAX_RDRAM_SIZE];
 };
@@ -56,8 +74,67 @@ cen64_hot int write_rdram(void *opaque, uint32_t address, uint32_t word, uint32_
 cen64_cold int read_rdram_regs(void *opaque, uint32_t address, uint32_t *word);
 cen64_cold int read_ri_regs(void *opaque, uint32_t address, uint32_t *word);
 
+cen64_cold uint32_t ri_close_generation(struct ri_controller *ri);
+
+void ri_copy_from_rdram(const struct ri_controller *ri,
+  uint32_t offset, uint8_t *dest, uint32_t length);
+void ri_copy_to_rdram(struct ri_controller *ri,
+  uint32_t offset, const uint8_t *src, uint32_t length);
+bool ri_written_since(const struct ri_controller *ri,
+  uint32_t offset, uint32_t length, uint32_t generation);
+
 cen64_cold int write_rdram_regs(void *opaque, uint32_t address, uint32_t word, uint32_t dqm);
 cen64_cold int write_ri_regs(void *opaque, uint32_t address, uint32_t word, uint32_t dqm);
 
+// Stamps the page holding offset as written in this generation.
+static inline void ri_mark_written(struct ri_controller *ri, uint32_t offset) {
+  ri->page_generations[offset >> RDRAM_PAGE_SHIFT &
+    (RDRAM_NUM_PAGES - 1)] = ri->generation;
+}
+
+// Converts between a word as stored in RDRAM and its value.
+static inline uint32_t ri_host_word(uint32_t word) {
+#ifdef CEN64_NATIVE_RDRAM
+  return word;
+#else
+  return byteswap_32(word);
+#endif
+}
+
+// Reads a word straight out of the RDRAM array.
+static inline uint32_t ri_read_word(const struct ri_controller *ri,
+  uint32_t offset) {
+  uint32_t word;
+
+  memcpy(&word, ri->ram + offset, sizeof(word));
+  return ri_host_word(word);
+}
+
+// Merges a word into the RDRAM array under dqm.
+static inline void ri_write_word(struct ri_controller *ri,
+  uint32_t offset, uint32_t word, uint32_t dqm) {
+  uint32_t orig_word;
+
+  memcpy(&orig_word, ri->ram + offset, sizeof(orig_word));
+  orig_word = ri_host_word(orig_word) & ~dqm;
+  word = ri_host_word(orig_word | (word & dqm));
+  memcpy(ri->ram + offset, &word, sizeof(word));
+
+  ri_mark_written(ri, offset);
+}
+
+// Stamps every page under [offset, offset + length) as written.
+static inline void ri_mark_written_range(struct ri_controller *ri,
+  uint32_t offset, uint32_t length) {
+  uint32_t page = offset >> RDRAM_PAGE_SHIFT;
+  uint32_t last = (offset + length - 1) >> RDRAM_PAGE_SHIFT;
+
+  if (last >= RDRAM_NUM_PAGES)
+    last = RDRAM_NUM_PAGES - 1;
+
+  for (; length && page <= last; page++)
+    ri->page_generations[page] = ri->generation;
+}
+
 #endif
 
@@ -65,6 +65,9 @@ struct rsp {
   // TODO: Only for IA32/x86_64 SSE2; sloppy?
   struct dynarec_slab vload_dynarec;
   struct dynarec_slab vstore_dynarec;
+
+  // Only counted while halted, so running cycles pay nothing.
+  unsigned long long halted_cycles;
 };
 
 cen64_cold int rsp_init(struct rsp *rsp, struct bus_controller *bus);
@@ -74,8 +77,10 @@ cen64_cold void rsp_destroy(struct rsp *rsp);
 cen64_flatten cen64_hot void rsp_cycle_(struct rsp *rsp);
 
 cen64_flatten cen64_hot static inline void rsp_cycle(struct rsp *rsp) {
-  if (unlikely(rsp->regs[RSP_CP0_REGISTER_SP_STATUS] & SP_STATUS_HALT))
+  if (unlikely(rsp->regs[RSP_CP0_REGISTER_SP_STATUS] & SP_STATUS_HALT)) {
+    rsp->halted_cycles++;
     return;
+  }
 
   rsp_cycle_(rsp);
 }
@@ -11,6 +11,8 @@
 #include "common.h"
 #include "bus/address.h"
 #include "bus/controller.h"
+#include "common/stats.h"
+#include "ri/controller.h"
 #include "rsp/cp0.h"
 #include "rsp/cpu.h"
 #include "rsp/interface.h"
@@ -20,6 +22,7 @@ void rsp_dma_read(struct rsp *rsp) {
   uint32_t length = (rsp->regs[RSP_CP0_REGISTER_DMA_READ_LENGTH] & 0xFFF) + 1;
   uint32_t skip = rsp->regs[RSP_CP0_REGISTER_DMA_READ_LENGTH] >> 20 & 0xFFF;
   unsigned count = rsp->regs[RSP_CP0_REGISTER_DMA_READ_LENGTH] >> 12 & 0xFF;
+  struct ri_controller *ri = rsp->bus->ri;
   unsigned j, i = 0;
 
   // Force alignment.
@@ -31,19 +34,21 @@ void rsp_dma_read(struct rsp *rsp) {
   if (((rsp->regs[RSP_CP0_REGISTER_DMA_CACHE] & 0xFFF) + length) > 0x1000)
     length = 0x1000 - (rsp->regs[RSP_CP0_REGISTER_DMA_CACHE] & 0xFFF);
 
+  stats_inc(rsp_dma_reads);
+  stats_add(rsp_dma_bytes, (unsigned long long) length * (count + 1));
+
   do {
     uint32_t source = rsp->regs[RSP_CP0_REGISTER_DMA_DRAM] & 0x7FFFFC;
     uint32_t dest = rsp->regs[RSP_CP0_REGISTER_DMA_CACHE] & 0x1FFC;
     j = 0;
 
+    // The DRAM side is always RDRAM, so skip the bus. DMEM is kept
+    // big-endian; IMEM is host order and feeds the decoder.
     do {
       uint32_t source_addr = (source + j) & 0x7FFFFC;
       uint32_t dest_addr = (dest + j) & 0x1FFC;
-      uint32_t word;
+      uint32_t word = ri_read_word(ri, source_addr);
 
-      bus_read_word(rsp, source_addr, &word);
-
-      // Update opcode cache.
       if (dest_addr & 0x1000) {
         rsp->opcode_cache[(dest_addr - 0x1000) >> 2] =
           *rsp_decode_instruction(word);
@@ -65,6 +70,7 @@ void rsp_dma_write(struct rsp *rsp) {
   uint32_t length = (rsp->regs[RSP_CP0_REGISTER_DMA_WRITE_LENGTH] & 0xFFF) + 1;
   uint32_t skip = rsp->regs[RSP_CP0_REGISTER_DMA_WRITE_LENGTH] >> 20 & 0xFFF;
   unsigned count = rsp->regs[RSP_CP0_REGISTER_DMA_WRITE_LENGTH] >> 12 & 0xFF;
+  struct ri_controller *ri = rsp->bus->ri;
   unsigned j, i = 0;
 
   // Force alignment.
@@ -76,6 +82,9 @@ void rsp_dma_write(struct rsp *rsp) {
   if (((rsp->regs[RSP_CP0_REGISTER_DMA_CACHE] & 0xFFF) + length) > 0x1000)
     length = 0x1000 - (rsp->regs[RSP_CP0_REGISTER_DMA_CACHE] & 0xFFF);
 
+  stats_inc(rsp_dma_writes);
+  stats_add(rsp_dma_bytes, (unsigned long long) length * (count + 1));
+
   do {
     uint32_t dest = rsp->regs[RSP_CP0_REGISTER_DMA_DRAM] & 0x7FFFFC;
     uint32_t source = rsp->regs[RSP_CP0_REGISTER_DMA_CACHE] & 0x1FFC;
@@ -91,7 +100,9 @@ void rsp_dma_write(struct rsp *rsp) {
       if (!(source_addr & 0x1000))
         word = byteswap_32(word);
 
-      bus_write_word(rsp, dest_addr, word, ~0U);
+      word = ri_host_word(word);
+      memcpy(ri->ram + dest_addr, &word, sizeof(word));
+      ri_mark_written(ri, dest_addr);
       j += 4;
     } while (j < length);
 
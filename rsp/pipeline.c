@@ -9,6 +9,7 @@
 //
 
 #include "common.h"
+#include "common/stats.h"
 #include "rsp/cp0.h"
 #include "rsp/cp2.h"
 #include "rsp/cpu.h"
@@ -66,6 +67,7 @@ static inline int rsp_rd_stage(struct rsp *rsp) {
       rdex_latch->opcode = rsp_rf_kill_op;
       rdex_latch->iw = 0x00000000U;
 
+      stats_inc(rsp_load_use_stalls);
       return 1;
     }
   }
@@ -206,6 +208,8 @@ static inline void rsp_wb_stage(struct rsp *rsp) {
 
 // Advances the processor pipeline by one clock.
 void rsp_cycle_(struct rsp *rsp) {
+  stats_inc(rsp_cycles);
+
   rsp_wb_stage(rsp);
   rsp_df_stage(rsp);
 
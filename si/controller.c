@@ -354,8 +354,8 @@ int write_si_regs(void *opaque, uint32_t address, uint32_t word, uint32_t dqm) {
     uint32_t offset = si->regs[SI_DRAM_ADDR_REG] & 0x1FFFFFFF;
 
     pif_process(si);
-    memcpy(si->bus->ri->ram + offset,
-      si->ram, sizeof(si->ram));
+    ri_copy_to_rdram(si->bus->ri, offset, si->ram, sizeof(si->ram));
+    ri_mark_written_range(si->bus->ri, offset, sizeof(si->ram));
 
     signal_rcp_interrupt(si->bus->vr4300, MI_INTR_SI);
     si->regs[SI_STATUS_REG] |= 0x1000;
@@ -364,7 +364,7 @@ int write_si_regs(void *opaque, uint32_t address, uint32_t word, uint32_t dqm) {
   else if (reg == SI_PIF_ADDR_WR64B_REG) {
     uint32_t offset = si->regs[SI_DRAM_ADDR_REG] & 0x1FFFFFFF;
 
-    memcpy(si->ram, si->bus->ri->ram + offset, sizeof(si->ram));
+    ri_copy_from_rdram(si->bus->ri, offset, si->ram, sizeof(si->ram));
     memcpy(si->command, si->ram, sizeof(si->command));
 
     signal_rcp_interrupt(si->bus->vr4300, MI_INTR_SI);
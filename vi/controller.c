@@ -13,6 +13,9 @@
 #include "bus/address.h"
 #include "bus/controller.h"
 #include "device/device.h"
+#include "device/netapi.h"
+#include "device/telemetry.h"
+#include "fpu/fpu.h"
 #include "os/main.h"
 #include "timer.h"
 #include "ri/controller.h"
@@ -21,7 +24,6 @@
 #include "vi/window.h"
 #include "vr4300/interface.h"
 
-#define VI_COUNTER_START ((62500000.0 / 60.0) + 1)
 #define VI_BLANKING_DONE (unsigned) ((VI_COUNTER_START - VI_COUNTER_START / 525.0 * 39))
 
 #ifdef DEBUG_MMIO_REGISTER_ACCESS
@@ -62,6 +64,7 @@ int read_vi_regs(void *opaque, uint32_t address, uint32_t *word) {
 // Advances the controller by one clock cycle.
 void vi_cycle(struct vi_controller *vi) {
   cen64_gl_window window;
+  fpu_state_t fpu_state;
   size_t copy_size;
 
   unsigned counter;
@@ -88,6 +91,9 @@ void vi_cycle(struct vi_controller *vi) {
   if (likely(counter != VI_BLANKING_DONE))
     return;
 
+  // Host floating point below mustn't leak into the guest's FCR31.
+  fpu_state = fpu_get_state();
+
   vi->field = !vi->field;
   window = vi->window;
 
@@ -128,9 +134,8 @@ void vi_cycle(struct vi_controller *vi) {
       copy_size = sizeof(vi->window->frame_buffer);
 
     memcpy(&bus, vi, sizeof(bus));
-    memcpy(vi->window->frame_buffer,
-      bus->ri->ram + (vi->regs[VI_ORIGIN_REG] & 0xFFFFFF),
-      copy_size);
+    ri_copy_from_rdram(bus->ri, vi->regs[VI_ORIGIN_REG] & 0xFFFFFF,
+      vi->window->frame_buffer, copy_size);
 
     cen64_mutex_unlock(&vi->window->render_mutex);
     cen64_gl_window_push_frame(window);
@@ -147,6 +152,21 @@ void vi_cycle(struct vi_controller *vi) {
 
     printf("VI/s: %.2f\n", (60 / (ns / NS_PER_SEC)));
   }
+
+  vi_governor_field(&vi->governor);
+
+  if (unlikely(vi->telemetry != NULL))
+    telemetry_field(vi->telemetry);
+
+  // Field boundaries are the safe point for debugger requests.
+  if (unlikely(vi->debugger != NULL))
+    netapi_debug_service(vi->debugger);
+
+  fpu_set_state(fpu_state);
+
+  // Stop after a fixed number of fields, if asked to.
+  if (unlikely(vi->field_limit) && --vi->field_limit == 0)
+    device_exit(vi->bus);
 }
 
 // Initializes the VI.
@@ -17,8 +17,15 @@
 #include "gl_screen.h"
 #include "gl_window.h"
 #include "timer.h"
+#include "vi/governor.h"
+
+// RCP cycles per field. Fields are this long whatever the VI timing
+// registers say, and the governor paces them to match.
+#define VI_COUNTER_START ((62500000.0 / 60.0) + 1)
 
 struct bus_controller *bus;
+struct netapi_debugger;
+struct cen64_telemetry;
 
 enum vi_register {
 #define X(reg) reg,
@@ -63,9 +70,13 @@ struct vi_controller {
   float viuv[8];
   float quad[8];
 
+  struct vi_governor governor;
+  struct netapi_debugger *debugger;
+  struct cen64_telemetry *telemetry;
   cen64_time last_update_time;
   unsigned intr_counter;
   unsigned frame_count;
+  unsigned long field_limit;
   unsigned field;
 };
 
@@ -0,0 +1,136 @@
+//
+// vi/governor.c: Real-time speed governor.
+//
+// CEN64: Cycle-Accurate Nintendo 64 Emulator.
+// Copyright (C) 2015, Tyler J. Stachecki.
+//
+// This file is subject to the terms and conditions defined in
+// 'LICENSE', which is part of this source code package.
+//
+
+#include "common.h"
+#include "timer.h"
+#include "vi/controller.h"
+#include "vi/governor.h"
+
+static double vi_governor_sqrt(double x);
+
+// Initializes the governor. A speed of zero runs unthrottled
+// (turbo), but frame-time statistics are still collected. Fields are
+// VI_COUNTER_START RCP cycles long whatever the sync registers say.
+void vi_governor_init(struct vi_governor *governor, double speed) {
+  memset(governor, 0, sizeof(*governor));
+
+  if (speed > 0) {
+    governor->period = NS_PER_SEC * VI_COUNTER_START /
+      (VI_GOVERNOR_RCP_CLOCK * speed);
+  }
+}
+
+// Called once per field, when the VI leaves vertical blanking.
+// Holds the emulator back until the field is due, if need be.
+void vi_governor_field(struct vi_governor *governor) {
+  unsigned long long field_time;
+  cen64_time now;
+
+  if (unlikely(!governor->started)) {
+    get_time(&governor->base);
+    governor->last_field = governor->base;
+    governor->deadline = governor->period;
+    governor->min_field_time = ~0ULL;
+    governor->started = true;
+    return;
+  }
+
+  if (governor->period) {
+    unsigned long long elapsed;
+
+    get_time(&now);
+    elapsed = compute_time_difference(&now, &governor->base);
+
+    if (elapsed <= governor->deadline)
+      wait_until(&governor->base, governor->deadline);
+
+    else {
+      governor->late_fields++;
+
+      // If we've fallen more than a field behind, don't try to
+      // make it up with a burst of unthrottled fields; rebase.
+      if (elapsed > governor->deadline + governor->period) {
+        governor->base = now;
+        governor->deadline = 0;
+      }
+    }
+
+    governor->deadline += governor->period;
+  }
+
+  get_time(&now);
+  field_time = compute_time_difference(&now, &governor->last_field);
+  governor->last_field = now;
+
+  if (field_time < governor->min_field_time)
+    governor->min_field_time = field_time;
+
+  if (field_time > governor->max_field_time)
+    governor->max_field_time = field_time;
+
+  governor->sum_field_time += field_time;
+  governor->sum_field_time_sq += (double) field_time * field_time;
+  governor->fields++;
+}
+
+// Newton's method; saves pulling in libm for one call.
+double vi_governor_sqrt(double x) {
+  double y = x;
+  unsigned i;
+
+  if (x <= 0)
+    return 0;
+
+  for (i = 0; i < 64; i++)
+    y = (y + x / y) / 2;
+
+  return y;
+}
+
+// Prints frame pacing statistics.
+void vi_governor_print_summary(const struct vi_governor *governor) {
+  double mean, variance;
+
+  if (governor->fields == 0)
+    return;
+
+  mean = governor->sum_field_time / governor->fields;
+  variance = governor->sum_field_time_sq / governor->fields - mean * mean;
+
+  printf("###############################\n"
+         " VI Frame Pacing Summary\n"
+         "###############################\n"
+         "\n");
+
+  if (governor->period) {
+    printf("   %16s: %.3f ms\n", "Target",
+      governor->period / 1000000.0);
+  }
+
+  else
+    printf("   %16s: %s\n", "Target", "unthrottled");
+
+  printf("   %16s: %llu\n"
+         "   %16s: %llu\n"
+         "   %16s: %.3f ms\n"
+         "   %16s: %.3f ms\n"
+         "   %16s: %.3f ms\n"
+         "   %16s: %.3f ms\n"
+         "\n",
+
+    "Fields", governor->fields,
+    "Late fields", governor->late_fields,
+    "Mean", mean / 1000000.0,
+    "Std. deviation", vi_governor_sqrt(variance) / 1000000.0,
+    "Min", governor->min_field_time / 1000000.0,
+    "Max", governor->max_field_time / 1000000.0
+  );
+}
+
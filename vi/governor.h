@@ -0,0 +1,42 @@
+//
+// vi/governor.h: Real-time speed governor.
+//
+// CEN64: Cycle-Accurate Nintendo 64 Emulator.
+// Copyright (C) 2015, Tyler J. Stachecki.
+//
+// This file is subject to the terms and conditions defined in
+// 'LICENSE', which is part of this source code package.
+//
+
+#ifndef __vi_governor_h__
+#define __vi_governor_h__
+#include "common.h"
+#include "timer.h"
+
+// The VI counts fields in RCP cycles.
+#define VI_GOVERNOR_RCP_CLOCK 62500000.0
+
+struct vi_governor {
+  cen64_time base;
+  cen64_time last_field;
+
+  // Target field period in ns; zero when unthrottled.
+  unsigned long long period;
+  unsigned long long deadline;
+  bool started;
+
+  // Frame-time (jitter) statistics, in ns.
+  unsigned long long fields;
+  unsigned long long late_fields;
+  unsigned long long min_field_time;
+  unsigned long long max_field_time;
+  double sum_field_time;
+  double sum_field_time_sq;
+};
+
+cen64_cold void vi_governor_init(struct vi_governor *governor, double speed);
+cen64_cold void vi_governor_field(struct vi_governor *governor);
+cen64_cold void vi_governor_print_summary(const struct vi_governor *governor);
+
+#endif
+
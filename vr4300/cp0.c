@@ -12,6 +12,7 @@
 #include "tlb/tlb.h"
 #include "vr4300/cp0.h"
 #include "vr4300/cpu.h"
+#include "vr4300/debug.h"
 
 static const uint64_t vr4300_cp0_reg_masks[32] = {
   0x000000008000003FULL, //  0: VR4300_CP0_REGISTER_INDEX
@@ -62,8 +63,7 @@ int VR4300_DMFC0(struct vr4300 *vr4300,
   unsigned src = GET_RD(iw);
 
   if (src == (VR4300_CP0_REGISTER_COUNT - VR4300_REGISTER_CP0_0)) {
-    exdc_latch->result = (uint32_t)
-      (vr4300->regs[VR4300_CP0_REGISTER_COUNT] >> 1);
+    exdc_latch->result = (uint32_t) (vr4300_get_count(vr4300) >> 1);
   }
 
   else if (vr4300_cp0_reg_masks[src] == 0x0000000000000BADULL)
@@ -91,9 +91,20 @@ int VR4300_DMTC0(struct vr4300 *vr4300,
   if (vr4300_cp0_reg_masks[dest] == 0x0000000000000BADULL)
     vr4300->regs[VR4300_REGISTER_CP0_0 + 7] = rt;
 
+  else if ((dest + VR4300_REGISTER_CP0_0) == VR4300_CP0_REGISTER_COUNT)
+    vr4300_set_count(vr4300, rt);
+
   else
     vr4300->regs[VR4300_REGISTER_CP0_0 + dest] = rt;
 
+  if ((dest + VR4300_REGISTER_CP0_0) == VR4300_CP0_REGISTER_COMPARE)
+    vr4300_schedule_compare(vr4300);
+
+  vr4300_update_intr_pending(vr4300);
+
+  if ((dest + VR4300_REGISTER_CP0_0) == VR4300_CP0_REGISTER_WATCHLO)
+    vr4300_debug_update_watch(vr4300);
+
   return 0;
 }
 
@@ -129,6 +140,7 @@ int VR4300_ERET(struct vr4300 *vr4300,
   pipeline->fault_present = true;
 
   vr4300->regs[VR4300_CP0_REGISTER_STATUS] = status;
+  vr4300_update_intr_pending(vr4300);
 
   pipeline->icrf_latch.segment = get_segment(icrf_latch->pc, status);
   pipeline->exdc_latch.segment = get_default_segment();
@@ -146,8 +158,7 @@ int VR4300_MFC0(struct vr4300 *vr4300,
   unsigned src = GET_RD(iw);
 
   if (src == (VR4300_CP0_REGISTER_COUNT - VR4300_REGISTER_CP0_0)) {
-    exdc_latch->result = (int32_t)
-      (vr4300->regs[VR4300_CP0_REGISTER_COUNT] >> 1);
+    exdc_latch->result = (int32_t) (vr4300_get_count(vr4300) >> 1);
   }
 
   else if (vr4300_cp0_reg_masks[src] == 0x0000000000000BADULL)
@@ -182,9 +193,20 @@ int VR4300_MTC0(struct vr4300 *vr4300,
   if (vr4300_cp0_reg_masks[dest] == 0x0000000000000BADULL)
     vr4300->regs[VR4300_REGISTER_CP0_0 + 7] = (int32_t) rt;
 
+  else if ((dest + VR4300_REGISTER_CP0_0) == VR4300_CP0_REGISTER_COUNT)
+    vr4300_set_count(vr4300, rt);
+
   else
     vr4300->regs[VR4300_REGISTER_CP0_0 + dest] = (int32_t) rt;
 
+  if ((dest + VR4300_REGISTER_CP0_0) == VR4300_CP0_REGISTER_COMPARE)
+    vr4300_schedule_compare(vr4300);
+
+  vr4300_update_intr_pending(vr4300);
+
+  if ((dest + VR4300_REGISTER_CP0_0) == VR4300_CP0_REGISTER_WATCHLO)
+    vr4300_debug_update_watch(vr4300);
+
   return 0;
 }
 
@@ -210,18 +232,15 @@ int VR4300_TLBP(struct vr4300 *vr4300,
 int VR4300_TLBR(struct vr4300 *vr4300,
   uint32_t iw, uint64_t rs, uint64_t rt) {
   unsigned index = vr4300->regs[VR4300_CP0_REGISTER_INDEX] & 0x3F;
-  uint64_t entry_hi;
+  uint64_t entry_hi, entry_lo_0, entry_lo_1;
+  uint32_t page_mask;
 
-  uint32_t page_mask = (vr4300->cp0.page_mask[index] << 1) & 0x1FFE000U;
-  uint32_t pfn0 = vr4300->cp0.pfn[index][0];
-  uint32_t pfn1 = vr4300->cp0.pfn[index][1];
-  uint8_t state0 = vr4300->cp0.state[index][0];
-  uint8_t state1 = vr4300->cp0.state[index][1];
+  vr4300_cp0_read_tlb_entry(vr4300, index,
+    &entry_hi, &entry_lo_0, &entry_lo_1, &page_mask);
 
-  tlb_read(&vr4300->cp0.tlb, index, &entry_hi);
   vr4300->regs[VR4300_CP0_REGISTER_ENTRYHI] = entry_hi;
-  vr4300->regs[VR4300_CP0_REGISTER_ENTRYLO0] = (pfn0 >> 6) | state0;
-  vr4300->regs[VR4300_CP0_REGISTER_ENTRYLO1] = (pfn1 >> 6) | state1;
+  vr4300->regs[VR4300_CP0_REGISTER_ENTRYLO0] = entry_lo_0;
+  vr4300->regs[VR4300_CP0_REGISTER_ENTRYLO1] = entry_lo_1;
   vr4300->regs[VR4300_CP0_REGISTER_PAGEMASK] = page_mask;
   return 0;
 }
@@ -231,19 +250,14 @@ int VR4300_TLBR(struct vr4300 *vr4300,
 //
 int VR4300_TLBWI(struct vr4300 *vr4300,
   uint32_t iw, uint64_t rs, uint64_t rt) {
-  uint64_t entry_hi = mask_reg(10, vr4300->regs[VR4300_CP0_REGISTER_ENTRYHI]);
-  uint64_t entry_lo_0 = mask_reg(2, vr4300->regs[VR4300_CP0_REGISTER_ENTRYLO0]);
-  uint64_t entry_lo_1 = mask_reg(3, vr4300->regs[VR4300_CP0_REGISTER_ENTRYLO1]);
-  uint32_t page_mask = mask_reg(5, vr4300->regs[VR4300_CP0_REGISTER_PAGEMASK]);
   unsigned index = vr4300->regs[VR4300_CP0_REGISTER_INDEX] & 0x3F;
 
-  tlb_write(&vr4300->cp0.tlb, index, entry_hi, entry_lo_0, entry_lo_1, page_mask);
+  vr4300_cp0_write_tlb_entry(vr4300, index,
+    vr4300->regs[VR4300_CP0_REGISTER_ENTRYHI],
+    vr4300->regs[VR4300_CP0_REGISTER_ENTRYLO0],
+    vr4300->regs[VR4300_CP0_REGISTER_ENTRYLO1],
+    vr4300->regs[VR4300_CP0_REGISTER_PAGEMASK]);
 
-  vr4300->cp0.page_mask[index] = (page_mask | 0x1FFF) >> 1;
-  vr4300->cp0.pfn[index][0] = (entry_lo_0 << 6) & ~0xFFFU;
-  vr4300->cp0.pfn[index][1] = (entry_lo_1 << 6) & ~0xFFFU;
-  vr4300->cp0.state[index][0] = entry_lo_0 & 0x3F;
-  vr4300->cp0.state[index][1] = entry_lo_1 & 0x3F;
   return 0;
 }
 
@@ -252,13 +266,38 @@ int VR4300_TLBWI(struct vr4300 *vr4300,
 //
 int VR4300_TLBWR(struct vr4300 *vr4300,
   uint32_t iw, uint64_t rs, uint64_t rt) {
-  uint64_t entry_hi = mask_reg(10, vr4300->regs[VR4300_CP0_REGISTER_ENTRYHI]);
-  uint64_t entry_lo_0 = mask_reg(2, vr4300->regs[VR4300_CP0_REGISTER_ENTRYLO0]);
-  uint64_t entry_lo_1 = mask_reg(3, vr4300->regs[VR4300_CP0_REGISTER_ENTRYLO1]);
-  uint32_t page_mask = mask_reg(5, vr4300->regs[VR4300_CP0_REGISTER_PAGEMASK]);
   unsigned index = vr4300->regs[VR4300_CP0_REGISTER_WIRED] & 0x3F;
 
   index = rand() % (32 - index) + index;
+  vr4300_cp0_write_tlb_entry(vr4300, index,
+    vr4300->regs[VR4300_CP0_REGISTER_ENTRYHI],
+    vr4300->regs[VR4300_CP0_REGISTER_ENTRYLO0],
+    vr4300->regs[VR4300_CP0_REGISTER_ENTRYLO1],
+    vr4300->regs[VR4300_CP0_REGISTER_PAGEMASK]);
+
+  return 0;
+}
+
+// Reads back a TLB entry in the layout of the CP0 registers.
+void vr4300_cp0_read_tlb_entry(const struct vr4300 *vr4300, unsigned index,
+  uint64_t *entry_hi, uint64_t *entry_lo_0, uint64_t *entry_lo_1,
+  uint32_t *page_mask) {
+  *page_mask = (vr4300->cp0.page_mask[index] << 1) & 0x1FFE000U;
+  *entry_lo_0 = (vr4300->cp0.pfn[index][0] >> 6) | vr4300->cp0.state[index][0];
+  *entry_lo_1 = (vr4300->cp0.pfn[index][1] >> 6) | vr4300->cp0.state[index][1];
+
+  tlb_read(&vr4300->cp0.tlb, index, entry_hi);
+}
+
+// Writes a TLB entry, masking the fields as the CP0 registers would.
+void vr4300_cp0_write_tlb_entry(struct vr4300 *vr4300, unsigned index,
+  uint64_t entry_hi, uint64_t entry_lo_0, uint64_t entry_lo_1,
+  uint32_t page_mask) {
+  entry_hi = mask_reg(10, entry_hi);
+  entry_lo_0 = mask_reg(2, entry_lo_0);
+  entry_lo_1 = mask_reg(3, entry_lo_1);
+  page_mask = mask_reg(5, page_mask);
+
   tlb_write(&vr4300->cp0.tlb, index, entry_hi, entry_lo_0, entry_lo_1, page_mask);
 
   vr4300->cp0.page_mask[index] = (page_mask | 0x1FFF) >> 1;
@@ -266,11 +305,39 @@ int VR4300_TLBWR(struct vr4300 *vr4300,
   vr4300->cp0.pfn[index][1] = (entry_lo_1 << 6) & ~0xFFFU;
   vr4300->cp0.state[index][0] = entry_lo_0 & 0x3F;
   vr4300->cp0.state[index][1] = entry_lo_1 & 0x3F;
-  return 0;
+}
+
+// Raises the timer interrupt and arms the next COMPARE match.
+void vr4300_compare_event(struct vr4300 *vr4300) {
+  vr4300->regs[VR4300_CP0_REGISTER_CAUSE] |= 0x8000;
+  vr4300_update_intr_pending(vr4300);
+
+  vr4300_schedule_compare(vr4300);
+}
+
+// Computes the cycle on which COUNT next equals COMPARE. COUNT ticks
+// every other pclock, so it matches for two pclocks out of every 2^33.
+void vr4300_schedule_compare(struct vr4300 *vr4300) {
+  uint64_t target = (uint64_t) (uint32_t)
+    vr4300->regs[VR4300_CP0_REGISTER_COMPARE] << 1;
+  uint64_t delta = (target - vr4300_get_count(vr4300)) & 0x1FFFFFFFFULL;
+
+  vr4300->compare_cycle = vr4300->cycles + (delta ? delta : 1);
+}
+
+// Rebases COUNT at the current cycle and reschedules the match.
+void vr4300_set_count(struct vr4300 *vr4300, uint32_t count) {
+  vr4300->regs[VR4300_CP0_REGISTER_COUNT] = (uint64_t) count << 1;
+  vr4300->count_base = vr4300->cycles;
+
+  vr4300_schedule_compare(vr4300);
 }
 
 // Initializes the coprocessor.
 void vr4300_cp0_init(struct vr4300 *vr4300) {
   tlb_init(&vr4300->cp0.tlb);
+  vr4300_debug_update_watch(vr4300);
+
+  vr4300_set_count(vr4300, 0);
 }
 
@@ -21,6 +21,10 @@ struct vr4300_cp0 {
   uint32_t page_mask[32];
   uint32_t pfn[32][2];
   uint8_t state[32][2];
+
+  // Filter in front of the WatchLo compare (see vr4300/debug.c).
+  uint32_t watch_address;
+  uint32_t watch_mask;
 };
 
 // Registers list.
@@ -65,5 +69,16 @@ int VR4300_TLBWR(struct vr4300 *vr4300, uint32_t iw, uint64_t rs, uint64_t rt);
 
 cen64_cold void vr4300_cp0_init(struct vr4300 *vr4300);
 
+cen64_cold void vr4300_compare_event(struct vr4300 *vr4300);
+void vr4300_schedule_compare(struct vr4300 *vr4300);
+void vr4300_set_count(struct vr4300 *vr4300, uint32_t count);
+
+void vr4300_cp0_read_tlb_entry(const struct vr4300 *vr4300, unsigned index,
+  uint64_t *entry_hi, uint64_t *entry_lo_0, uint64_t *entry_lo_1,
+  uint32_t *page_mask);
+void vr4300_cp0_write_tlb_entry(struct vr4300 *vr4300, unsigned index,
+  uint64_t entry_hi, uint64_t entry_lo_0, uint64_t entry_lo_1,
+  uint32_t page_mask);
+
 #endif
 
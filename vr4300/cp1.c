@@ -9,17 +9,58 @@
 //
 
 #include "common.h"
+#include "common/stats.h"
 #include "fpu/fpu.h"
 #include "vr4300/cp1.h"
 #include "vr4300/cpu.h"
 #include "vr4300/decoder.h"
 #include "vr4300/fault.h"
 
+cen64_cold static int vr4300_cp1_trap_check(struct vr4300 *vr4300);
+static void vr4300_cp1_merge_fcr31(struct vr4300 *vr4300,
+  uint32_t clear, uint32_t set);
+static uint32_t vr4300_cp1_take_flags(void);
+
+//
+// Checks for a trap if FCR31 enables any. Otherwise, exception flags
+// pile up in the host's sticky bits until FCR31 is read (see CFC1).
+//
+static inline int vr4300_cp1_trap(struct vr4300 *vr4300) {
+  return unlikely(vr4300->cp1_enables != 0) && vr4300_cp1_trap_check(vr4300);
+}
+
+// Host rounding modes, indexed by FCR31.RM.
+static const fpu_state_t vr4300_cp1_round_modes[4] = {
+  FPU_ROUND_NEAREST, FPU_ROUND_TOZERO, FPU_ROUND_POSINF, FPU_ROUND_NEGINF,
+};
+
+//
+// The host's rounding mode tracks FCR31 while the guest runs, so
+// only the fixed-mode conversions ever switch it, and only if the
+// guest isn't already using the mode they need.
+//
+static inline void vr4300_cp1_enter_round(
+  const struct vr4300 *vr4300, fpu_state_t mode) {
+  if (unlikely(mode != vr4300->cp1_round))
+    fpu_set_state((fpu_get_state() & ~FPU_ROUND_MASK) | mode);
+}
+
+static inline void vr4300_cp1_leave_round(
+  const struct vr4300 *vr4300, fpu_state_t mode) {
+  if (unlikely(mode != vr4300->cp1_round))
+    fpu_set_state((fpu_get_state() & ~FPU_ROUND_MASK) | vr4300->cp1_round);
+}
+
 //
 // Raises a MCI interlock for a set number of cycles.
 //
 static inline int vr4300_do_mci(struct vr4300 *vr4300, unsigned cycles) {
+  if (vr4300_cp1_trap(vr4300))
+    return 1;
+
+  stats_add(vr4300_mci_stall_cycles, cycles - 1);
   vr4300->pipeline.cycles_to_stall = cycles - 1;
+  vr4300->pipeline.stall_cycles += cycles - 1;
   vr4300->regs[PIPELINE_CYCLE_TYPE] = 3;
   return 1;
 }
@@ -183,7 +224,7 @@ int VR4300_CP1_C_EQ_C_SEQ(struct vr4300 *vr4300,
 
   exdc_latch->result = result | (flag << 23);
   exdc_latch->dest = dest;
-  return 0;
+  return vr4300_cp1_trap(vr4300);
 }
 
 //
@@ -222,7 +263,7 @@ int VR4300_CP1_C_F_C_SF(struct vr4300 *vr4300,
 
   exdc_latch->result = result | (flag << 23);
   exdc_latch->dest = dest;
-  return 0;
+  return vr4300_cp1_trap(vr4300);
 }
 
 //
@@ -261,7 +302,7 @@ int VR4300_CP1_C_OLE_C_LE(struct vr4300 *vr4300,
 
   exdc_latch->result = result | (flag << 23);
   exdc_latch->dest = dest;
-  return 0;
+  return vr4300_cp1_trap(vr4300);
 }
 
 //
@@ -300,7 +341,7 @@ int VR4300_CP1_C_OLT_C_LT(struct vr4300 *vr4300,
 
   exdc_latch->result = result | (flag << 23);
   exdc_latch->dest = dest;
-  return 0;
+  return vr4300_cp1_trap(vr4300);
 }
 
 //
@@ -339,7 +380,7 @@ int VR4300_CP1_C_UEQ_C_NGL(struct vr4300 *vr4300,
 
   exdc_latch->result = result | (flag << 23);
   exdc_latch->dest = dest;
-  return 0;
+  return vr4300_cp1_trap(vr4300);
 }
 
 //
@@ -378,7 +419,7 @@ int VR4300_CP1_C_ULE_C_NGT(struct vr4300 *vr4300,
 
   exdc_latch->result = result | (flag << 23);
   exdc_latch->dest = dest;
-  return 0;
+  return vr4300_cp1_trap(vr4300);
 }
 
 //
@@ -417,7 +458,7 @@ int VR4300_CP1_C_ULT_C_NGE(struct vr4300 *vr4300,
 
   exdc_latch->result = result | (flag << 23);
   exdc_latch->dest = dest;
-  return 0;
+  return vr4300_cp1_trap(vr4300);
 }
 
 //
@@ -456,7 +497,7 @@ int VR4300_CP1_C_UN_C_NGLE(struct vr4300 *vr4300,
 
   exdc_latch->result = result | (flag << 23);
   exdc_latch->dest = dest;
-  return 0;
+  return vr4300_cp1_trap(vr4300);
 }
 
 //
@@ -473,8 +514,7 @@ int VR4300_CP1_CEIL_L(struct vr4300 *vr4300,
   uint64_t result;
 
 #ifndef CEN64_ARCH_HAS_CEIL
-  fpu_state_t saved_state = fpu_get_state();
-  fpu_set_state((saved_state & ~FPU_ROUND_MASK) | FPU_ROUND_POSINF);
+  vr4300_cp1_enter_round(vr4300, FPU_ROUND_POSINF);
 
   switch (fmt) {
     case VR4300_FMT_S:
@@ -488,12 +528,12 @@ int VR4300_CP1_CEIL_L(struct vr4300 *vr4300,
       break;
 
     default:
+      vr4300_cp1_leave_round(vr4300, FPU_ROUND_POSINF);
       VR4300_INV(vr4300);
       return 1;
   }
 
-  fpu_set_state((saved_state & FPU_ROUND_MASK) |
-    (fpu_get_state() & ~FPU_ROUND_MASK));
+  vr4300_cp1_leave_round(vr4300, FPU_ROUND_POSINF);
 #else
   switch (fmt) {
     case VR4300_FMT_S:
@@ -531,8 +571,7 @@ int VR4300_CP1_CEIL_W(struct vr4300 *vr4300,
   uint32_t result;
 
 #ifndef CEN64_ARCH_HAS_CEIL
-  fpu_state_t saved_state = fpu_get_state();
-  fpu_set_state((saved_state & ~FPU_ROUND_MASK) | FPU_ROUND_POSINF);
+  vr4300_cp1_enter_round(vr4300, FPU_ROUND_POSINF);
 
   switch (fmt) {
     case VR4300_FMT_S:
@@ -546,12 +585,12 @@ int VR4300_CP1_CEIL_W(struct vr4300 *vr4300,
       break;
 
     default:
+      vr4300_cp1_leave_round(vr4300, FPU_ROUND_POSINF);
       VR4300_INV(vr4300);
       return 1;
   }
 
-  fpu_set_state((saved_state & FPU_ROUND_MASK) |
-    (fpu_get_state() & ~FPU_ROUND_MASK));
+  vr4300_cp1_leave_round(vr4300, FPU_ROUND_POSINF);
 #else
   switch (fmt) {
     case VR4300_FMT_S:
@@ -597,6 +636,10 @@ int VR4300_CFC1(struct vr4300 *vr4300,
       break;
   }
 
+  // Fold in any exception flags the host has picked up since.
+  if (src == VR4300_CP1_FCR31)
+    vr4300_cp1_merge_fcr31(vr4300, 0, vr4300_cp1_take_flags());
+
   result = vr4300->regs[src];
 
   // XXX: The VR4300 manual says that the results of a FPU
@@ -624,9 +667,18 @@ int VR4300_CTC1(struct vr4300 *vr4300,
   struct vr4300_exdc_latch *exdc_latch = &vr4300->pipeline.exdc_latch;
   unsigned dest = GET_RD(iw);
 
-  if (dest == 31)
+  if (dest == 31) {
     dest = VR4300_CP1_FCR31;
 
+    // Pending flags are overwritten along with the rest of FCR31.
+    // This is the only place the host's rounding mode changes.
+    vr4300->cp1_round = vr4300_cp1_round_modes[rt & 0x3];
+    vr4300->cp1_enables = rt & 0xF80;
+
+    fpu_set_state((fpu_get_state() & ~(FPU_ROUND_MASK | FPU_EXCPS)) |
+      vr4300->cp1_round);
+  }
+
   else {
     assert(0 && "CTC1: Write to fixed/reserved FCR.");
 
@@ -679,7 +731,7 @@ int VR4300_CP1_CVT_D(struct vr4300 *vr4300,
   exdc_latch->dest = dest;
   return fmt != VR4300_FMT_S
     ? vr4300_do_mci(vr4300, 5)
-    : 0;
+    : vr4300_cp1_trap(vr4300);
 }
 
 //
@@ -861,8 +913,7 @@ int VR4300_CP1_FLOOR_L(struct vr4300 *vr4300,
   uint64_t result;
 
 #ifndef CEN64_ARCH_HAS_FLOOR
-  fpu_state_t saved_state = fpu_get_state();
-  fpu_set_state((saved_state & ~FPU_ROUND_MASK) | FPU_ROUND_NEGINF);
+  vr4300_cp1_enter_round(vr4300, FPU_ROUND_NEGINF);
 
   switch (fmt) {
     case VR4300_FMT_S:
@@ -876,12 +927,12 @@ int VR4300_CP1_FLOOR_L(struct vr4300 *vr4300,
       break;
 
     default:
+      vr4300_cp1_leave_round(vr4300, FPU_ROUND_NEGINF);
       VR4300_INV(vr4300);
       return 1;
   }
 
-  fpu_set_state((saved_state & FPU_ROUND_MASK) |
-    (fpu_get_state() & ~FPU_ROUND_MASK));
+  vr4300_cp1_leave_round(vr4300, FPU_ROUND_NEGINF);
 #else
   switch (fmt) {
     case VR4300_FMT_S:
@@ -918,8 +969,7 @@ int VR4300_CP1_FLOOR_W(struct vr4300 *vr4300,
   uint32_t result;
 
 #ifndef CEN64_ARCH_HAS_FLOOR
-  fpu_state_t saved_state = fpu_get_state();
-  fpu_set_state((saved_state & ~FPU_ROUND_MASK) | FPU_ROUND_NEGINF);
+  vr4300_cp1_enter_round(vr4300, FPU_ROUND_NEGINF);
 
   switch (fmt) {
     case VR4300_FMT_S:
@@ -933,12 +983,12 @@ int VR4300_CP1_FLOOR_W(struct vr4300 *vr4300,
       break;
 
     default:
+      vr4300_cp1_leave_round(vr4300, FPU_ROUND_NEGINF);
       VR4300_INV(vr4300);
       return 1;
   }
 
-  fpu_set_state((saved_state & FPU_ROUND_MASK) |
-    (fpu_get_state() & ~FPU_ROUND_MASK));
+  vr4300_cp1_leave_round(vr4300, FPU_ROUND_NEGINF);
 #else
   switch (fmt) {
     case VR4300_FMT_S:
@@ -1165,8 +1215,7 @@ int VR4300_CP1_ROUND_L(struct vr4300 *vr4300,
   uint64_t result;
 
 #ifndef CEN64_ARCH_HAS_ROUND
-  fpu_state_t saved_state = fpu_get_state();
-  fpu_set_state((saved_state & ~FPU_ROUND_MASK) | FPU_ROUND_NEAREST);
+  vr4300_cp1_enter_round(vr4300, FPU_ROUND_NEAREST);
 
   switch (fmt) {
     case VR4300_FMT_S:
@@ -1180,12 +1229,12 @@ int VR4300_CP1_ROUND_L(struct vr4300 *vr4300,
       break;
 
     default:
+      vr4300_cp1_leave_round(vr4300, FPU_ROUND_NEAREST);
       VR4300_INV(vr4300);
       return 1;
   }
 
-  fpu_set_state((saved_state & FPU_ROUND_MASK) |
-    (fpu_get_state() & ~FPU_ROUND_MASK));
+  vr4300_cp1_leave_round(vr4300, FPU_ROUND_NEAREST);
 #else
   switch (fmt) {
     case VR4300_FMT_S:
@@ -1222,8 +1271,7 @@ int VR4300_CP1_ROUND_W(struct vr4300 *vr4300,
   uint32_t result;
 
 #ifndef CEN64_ARCH_HAS_ROUND
-  fpu_state_t saved_state = fpu_get_state();
-  fpu_set_state((saved_state & ~FPU_ROUND_MASK) | FPU_ROUND_NEAREST);
+  vr4300_cp1_enter_round(vr4300, FPU_ROUND_NEAREST);
 
   switch (fmt) {
     case VR4300_FMT_S:
@@ -1237,13 +1285,13 @@ int VR4300_CP1_ROUND_W(struct vr4300 *vr4300,
       break;
 
     default:
+      vr4300_cp1_leave_round(vr4300, FPU_ROUND_NEAREST);
       VR4300_INV(vr4300);
       return 1;
 
   }
 
-  fpu_set_state((saved_state & FPU_ROUND_MASK) |
-    (fpu_get_state() & ~FPU_ROUND_MASK));
+  vr4300_cp1_leave_round(vr4300, FPU_ROUND_NEAREST);
 #else
   switch (fmt) {
     case VR4300_FMT_S:
@@ -1448,6 +1496,77 @@ int VR4300_CP1_TRUNC_W(struct vr4300 *vr4300,
 
 // Initializes the coprocessor.
 void vr4300_cp1_init(struct vr4300 *vr4300) {
-  fpu_set_state(FPU_ROUND_NEAREST | FPU_MASK_EXCPS);
+  vr4300->cp1_round = vr4300_cp1_round_modes[
+    vr4300->regs[VR4300_CP1_FCR31] & 0x3];
+
+  fpu_set_state(vr4300->cp1_round | FPU_MASK_EXCPS);
 }
 
+//
+// Updates FCR31, including any copy of it still in the pipeline.
+//
+void vr4300_cp1_merge_fcr31(struct vr4300 *vr4300,
+  uint32_t clear, uint32_t set) {
+  struct vr4300_exdc_latch *exdc_latch = &vr4300->pipeline.exdc_latch;
+  struct vr4300_dcwb_latch *dcwb_latch = &vr4300->pipeline.dcwb_latch;
+  uint64_t *fcr31 = vr4300->regs + VR4300_CP1_FCR31;
+
+  *fcr31 = (*fcr31 & ~(uint64_t) clear) | set;
+
+  if (dcwb_latch->dest == VR4300_CP1_FCR31)
+    dcwb_latch->result = (dcwb_latch->result & ~(uint64_t) clear) | set;
+
+  if (exdc_latch->dest == VR4300_CP1_FCR31)
+    exdc_latch->result = (exdc_latch->result & ~(uint64_t) clear) | set;
+}
+
+//
+// Collects and clears the host's sticky exception flags,
+// returning them in the layout of the FCR31 flags field.
+//
+uint32_t vr4300_cp1_take_flags(void) {
+  fpu_state_t state = fpu_get_state();
+  uint32_t flags = 0;
+
+  if (likely(!(state & FPU_EXCPS)))
+    return 0;
+
+  fpu_set_state(state & ~FPU_EXCPS);
+
+  if (state & FPU_EXCP_INEXACT)
+    flags |= 0x04;
+
+  if (state & FPU_EXCP_UNDERFLOW)
+    flags |= 0x08;
+
+  if (state & FPU_EXCP_OVERFLOW)
+    flags |= 0x10;
+
+  if (state & FPU_EXCP_DIVBYZERO)
+    flags |= 0x20;
+
+  if (state & FPU_EXCP_INVALID)
+    flags |= 0x40;
+
+  return flags;
+}
+
+//
+// Only called while FCR31 enables exceptions. Every operation checks
+// in that case, so the host flags are exactly those of the current
+// operation and double as the cause bits. Enabled exceptions trap
+// without setting their flag bits.
+//
+int vr4300_cp1_trap_check(struct vr4300 *vr4300) {
+  uint32_t flags = vr4300_cp1_take_flags();
+  uint32_t cause = flags << 10;
+
+  if (flags << 5 & vr4300->cp1_enables) {
+    vr4300_cp1_merge_fcr31(vr4300, 0x1F000, cause);
+    VR4300_FPE(vr4300);
+    return 1;
+  }
+
+  vr4300_cp1_merge_fcr31(vr4300, 0x1F000, cause | flags);
+  return 0;
+}
@@ -14,6 +14,7 @@
 #include "vr4300/cp0.h"
 #include "vr4300/cp1.h"
 #include "vr4300/dcache.h"
+#include "vr4300/debug.h"
 #include "vr4300/icache.h"
 #include "vr4300/opcodes.h"
 #include "vr4300/pipeline.h"
@@ -99,9 +100,30 @@ struct vr4300 {
   unsigned signals;
   struct vr4300_cp0 cp0;
 
+  // Set when an interrupt may be deliverable. Anything that changes
+  // Status or Cause raises it; only the DC stage clears it.
+  uint8_t intr_pending;
+
+  // COUNT is regs[COUNT] plus the pclocks elapsed since count_base;
+  // the COMPARE match is an event due when cycles hits compare_cycle.
+  uint64_t cycles;
+  uint64_t count_base;
+  uint64_t compare_cycle;
+
   struct vr4300_dcache dcache;
   struct vr4300_icache icache;
 
+  // FCR31 enable bits; FPU operations only check for traps when set.
+  uint32_t cp1_enables;
+
+  // Host rounding mode matching FCR31.RM.
+  fpu_state_t cp1_round;
+
+  // Only set while breakpoints or watchpoints exist.
+  struct vr4300_debug *debug;
+
+  // Set to skip predecoding and cache loop batching.
+  bool slow_paths;
 };
 
 struct vr4300_stats {
@@ -116,15 +138,26 @@ cen64_cold void vr4300_print_summary(struct vr4300_stats *stats);
 
 cen64_flatten cen64_hot void vr4300_cycle_(struct vr4300 *vr4300);
 
+// Raises the interrupt-pending flag if Status and Cause allow it.
+static inline void vr4300_update_intr_pending(struct vr4300 *vr4300) {
+  uint32_t cp0_status = vr4300->regs[VR4300_CP0_REGISTER_STATUS];
+  uint32_t cp0_cause = vr4300->regs[VR4300_CP0_REGISTER_CAUSE];
+
+  if (cp0_cause & cp0_status & 0xFF00 && ((cp0_status ^ 6) & 0x7) == 0x7)
+    vr4300->intr_pending = 1;
+}
+
+// Returns COUNT in pclocks (the register ticks at half this rate).
+static inline uint64_t vr4300_get_count(const struct vr4300 *vr4300) {
+  return vr4300->regs[VR4300_CP0_REGISTER_COUNT] +
+    (vr4300->cycles - vr4300->count_base);
+}
+
 cen64_flatten cen64_hot static inline void vr4300_cycle(struct vr4300 *vr4300) {
   struct vr4300_pipeline *pipeline = &vr4300->pipeline;
 
-  // Increment counters.
-  vr4300->regs[VR4300_CP0_REGISTER_COUNT]++;
-
-  if ((uint32_t) (vr4300->regs[VR4300_CP0_REGISTER_COUNT] >> 1) ==
-    (uint32_t) vr4300->regs[VR4300_CP0_REGISTER_COMPARE])
-    vr4300->regs[VR4300_CP0_REGISTER_CAUSE] |= 0x8000;
+  if (unlikely(++vr4300->cycles == vr4300->compare_cycle))
+    vr4300_compare_event(vr4300);
 
   // We're stalling for something...
   if (pipeline->cycles_to_stall > 0)
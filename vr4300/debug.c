@@ -0,0 +1,220 @@
+//
+// vr4300/debug.c: VR4300 breakpoints and watchpoints.
+//
+// CEN64: Cycle-Accurate Nintendo 64 Emulator.
+// Copyright (C) 2015, Tyler J. Stachecki.
+//
+// This file is subject to the terms and conditions defined in
+// 'LICENSE', which is part of this source code package.
+//
+
+// Neither costs anything on the paths that run every cycle:
+//
+// Breakpoints trap the icache lines that could hold them. A trapped
+// line misses in vr4300_icache_probe(), so fetches from it fall into
+// the (already cold) ICB path, which checks the table and then uses
+// the line as a hit. Uncached fetches always go through there anyway.
+//
+// Watchpoints widen the WatchLo compare that vr4300_dc_stage() does
+// for every access: the filter admits WatchLo's doubleword and every
+// watchpoint, and only the candidates it lets through are looked up.
+
+#include "common.h"
+#include "vr4300/cpu.h"
+#include "vr4300/debug.h"
+#include "vr4300/icache.h"
+
+#define WATCH_ADDRESS_MASK (~0x80000007U)
+
+static unsigned vr4300_debug_hash(uint64_t key);
+static int vr4300_debug_find(const struct vr4300_debug_table *table,
+  uint64_t key);
+static int vr4300_debug_insert(struct vr4300_debug_table *table,
+  uint64_t key, uint8_t flags);
+static int vr4300_debug_remove(struct vr4300_debug_table *table,
+  uint64_t key);
+
+static void vr4300_debug_attach(struct vr4300 *vr4300,
+  struct vr4300_debug *debug);
+
+// Hashes an address into the table.
+unsigned vr4300_debug_hash(uint64_t key) {
+  return (key >> 2) * 0x9E3779B97F4A7C15ULL >> 57;
+}
+
+// Returns the slot holding key, or -1 if it isn't present.
+int vr4300_debug_find(const struct vr4300_debug_table *table, uint64_t key) {
+  unsigned i, slot = vr4300_debug_hash(key);
+
+  for (i = 0; i < VR4300_DEBUG_HASH_SIZE; i++) {
+    if (!table->flags[slot])
+      return -1;
+
+    if (table->keys[slot] == key)
+      return slot;
+
+    slot = (slot + 1) & (VR4300_DEBUG_HASH_SIZE - 1);
+  }
+
+  return -1;
+}
+
+// Adds key to the table, or updates its flags if it's there.
+int vr4300_debug_insert(struct vr4300_debug_table *table,
+  uint64_t key, uint8_t flags) {
+  unsigned slot = vr4300_debug_hash(key);
+  int existing;
+
+  if ((existing = vr4300_debug_find(table, key)) >= 0) {
+    table->flags[existing] = flags;
+    return 0;
+  }
+
+  if (table->count == VR4300_DEBUG_MAX_POINTS)
+    return -1;
+
+  while (table->flags[slot])
+    slot = (slot + 1) & (VR4300_DEBUG_HASH_SIZE - 1);
+
+  table->keys[slot] = key;
+  table->flags[slot] = flags;
+  table->count++;
+  return 0;
+}
+
+// Removes key from the table. The table is small, so just rebuild it
+// rather than patch up the probe sequences.
+int vr4300_debug_remove(struct vr4300_debug_table *table, uint64_t key) {
+  struct vr4300_debug_table old = *table;
+  int i, slot;
+
+  if ((slot = vr4300_debug_find(table, key)) < 0)
+    return -1;
+
+  memset(table, 0, sizeof(*table));
+
+  for (i = 0; i < VR4300_DEBUG_HASH_SIZE; i++) {
+    if (old.flags[i] && i != slot)
+      vr4300_debug_insert(table, old.keys[i], old.flags[i]);
+  }
+
+  return 0;
+}
+
+// Hooks the tables into the VR4300 only while they're in use.
+void vr4300_debug_attach(struct vr4300 *vr4300, struct vr4300_debug *debug) {
+  vr4300->debug = (debug->breakpoints.count || debug->watchpoints.count)
+    ? debug : NULL;
+
+  vr4300_debug_update_watch(vr4300);
+}
+
+// Initializes an empty set of breakpoints and watchpoints.
+void vr4300_debug_init(struct vr4300_debug *debug,
+  vr4300_debug_hook hook, void *opaque) {
+  memset(debug, 0, sizeof(*debug));
+
+  debug->hook = hook;
+  debug->opaque = opaque;
+}
+
+// Sets an execution breakpoint at a virtual address.
+int vr4300_debug_add_breakpoint(struct vr4300 *vr4300,
+  struct vr4300_debug *debug, uint64_t vaddr) {
+  vaddr &= ~0x3ULL;
+
+  if (vr4300_debug_find(&debug->breakpoints, vaddr) >= 0)
+    return 0;
+
+  if (vr4300_debug_insert(&debug->breakpoints, vaddr, 1))
+    return -1;
+
+  vr4300_icache_trap(&vr4300->icache, vaddr, true);
+  vr4300_debug_attach(vr4300, debug);
+  return 0;
+}
+
+// Clears an execution breakpoint.
+int vr4300_debug_remove_breakpoint(struct vr4300 *vr4300,
+  struct vr4300_debug *debug, uint64_t vaddr) {
+  vaddr &= ~0x3ULL;
+
+  if (vr4300_debug_remove(&debug->breakpoints, vaddr))
+    return -1;
+
+  vr4300_icache_trap(&vr4300->icache, vaddr, false);
+  vr4300_debug_attach(vr4300, debug);
+  return 0;
+}
+
+// Sets a watchpoint on the doubleword at a physical address.
+int vr4300_debug_add_watchpoint(struct vr4300 *vr4300,
+  struct vr4300_debug *debug, uint32_t paddr, unsigned type) {
+  if (!(type &= 0x3))
+    return -1;
+
+  if (vr4300_debug_insert(&debug->watchpoints,
+    paddr & WATCH_ADDRESS_MASK, type))
+    return -1;
+
+  vr4300_debug_attach(vr4300, debug);
+  return 0;
+}
+
+// Clears a watchpoint.
+int vr4300_debug_remove_watchpoint(struct vr4300 *vr4300,
+  struct vr4300_debug *debug, uint32_t paddr) {
+  if (vr4300_debug_remove(&debug->watchpoints, paddr & WATCH_ADDRESS_MASK))
+    return -1;
+
+  vr4300_debug_attach(vr4300, debug);
+  return 0;
+}
+
+// Called for fetches that missed the fast path.
+void vr4300_debug_fetch(struct vr4300 *vr4300, uint64_t vaddr) {
+  struct vr4300_debug *debug = vr4300->debug;
+
+  if (vr4300_debug_find(&debug->breakpoints, vaddr) >= 0)
+    debug->hook(debug->opaque, VR4300_DEBUG_BREAKPOINT, vaddr);
+}
+
+// Called for accesses that made it through the watch filter.
+void vr4300_debug_access(struct vr4300 *vr4300,
+  uint32_t paddr, unsigned type) {
+  struct vr4300_debug *debug = vr4300->debug;
+  int slot;
+
+  slot = vr4300_debug_find(&debug->watchpoints, paddr & WATCH_ADDRESS_MASK);
+
+  if (slot >= 0 && (debug->watchpoints.flags[slot] & type & 0x3))
+    debug->hook(debug->opaque, VR4300_DEBUG_WATCHPOINT, paddr);
+}
+
+// Recomputes the watch filter. Must be called whenever WatchLo or the
+// set of watchpoints changes.
+void vr4300_debug_update_watch(struct vr4300 *vr4300) {
+  const struct vr4300_debug *debug = vr4300->debug;
+  uint32_t address, diff = 0;
+  unsigned i;
+
+  address = vr4300->regs[VR4300_CP0_REGISTER_WATCHLO] & WATCH_ADDRESS_MASK;
+
+  if (debug != NULL) {
+    for (i = 0; i < VR4300_DEBUG_HASH_SIZE; i++) {
+      if (debug->watchpoints.flags[i])
+        diff |= debug->watchpoints.keys[i] ^ address;
+    }
+  }
+
+  // Ignore every bit at or below the highest one that differs.
+  diff |= diff >> 1;
+  diff |= diff >> 2;
+  diff |= diff >> 4;
+  diff |= diff >> 8;
+  diff |= diff >> 16;
+
+  vr4300->cp0.watch_address = address;
+  vr4300->cp0.watch_mask = WATCH_ADDRESS_MASK & ~diff;
+}
+
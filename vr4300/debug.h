@@ -0,0 +1,63 @@
+//
+// vr4300/debug.h: VR4300 breakpoints and watchpoints.
+//
+// CEN64: Cycle-Accurate Nintendo 64 Emulator.
+// Copyright (C) 2015, Tyler J. Stachecki.
+//
+// This file is subject to the terms and conditions defined in
+// 'LICENSE', which is part of this source code package.
+//
+
+#ifndef __vr4300_debug_h__
+#define __vr4300_debug_h__
+#include "common.h"
+
+#define VR4300_DEBUG_MAX_POINTS 64
+#define VR4300_DEBUG_HASH_SIZE 128
+
+struct vr4300;
+
+enum vr4300_debug_event {
+  VR4300_DEBUG_BREAKPOINT,
+  VR4300_DEBUG_WATCHPOINT,
+};
+
+typedef void (*vr4300_debug_hook)(void *opaque,
+  enum vr4300_debug_event event, uint64_t address);
+
+// Open-addressed set of addresses. Flags of zero mark a free slot;
+// watchpoints use the bus request types (read = 1, write = 2).
+struct vr4300_debug_table {
+  uint64_t keys[VR4300_DEBUG_HASH_SIZE];
+  uint8_t flags[VR4300_DEBUG_HASH_SIZE];
+  unsigned count;
+};
+
+struct vr4300_debug {
+  struct vr4300_debug_table breakpoints;
+  struct vr4300_debug_table watchpoints;
+
+  vr4300_debug_hook hook;
+  void *opaque;
+};
+
+cen64_cold void vr4300_debug_init(struct vr4300_debug *debug,
+  vr4300_debug_hook hook, void *opaque);
+
+cen64_cold int vr4300_debug_add_breakpoint(struct vr4300 *vr4300,
+  struct vr4300_debug *debug, uint64_t vaddr);
+cen64_cold int vr4300_debug_remove_breakpoint(struct vr4300 *vr4300,
+  struct vr4300_debug *debug, uint64_t vaddr);
+cen64_cold int vr4300_debug_add_watchpoint(struct vr4300 *vr4300,
+  struct vr4300_debug *debug, uint32_t paddr, unsigned type);
+cen64_cold int vr4300_debug_remove_watchpoint(struct vr4300 *vr4300,
+  struct vr4300_debug *debug, uint32_t paddr);
+
+cen64_cold void vr4300_debug_fetch(struct vr4300 *vr4300, uint64_t vaddr);
+cen64_cold void vr4300_debug_access(struct vr4300 *vr4300,
+  uint32_t paddr, unsigned type);
+
+cen64_cold void vr4300_debug_update_watch(struct vr4300 *vr4300);
+
+#endif
+
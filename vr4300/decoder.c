@@ -336,3 +336,24 @@ const struct vr4300_opcode* vr4300_decode_instruction(uint32_t iw) {
   return group + index;
 }
 
+
+// Decodes an instruction word and extracts its source registers. FPU
+// operands are biased into the CP1 registers; EX still has to fold them
+// onto even registers when Status.FR is clear.
+void vr4300_predecode_instruction(
+  struct vr4300_predecode *predecode, uint32_t iw) {
+  const struct vr4300_opcode *opcode = vr4300_decode_instruction(iw);
+  unsigned rs = GET_RS(iw), rt = GET_RT(iw);
+
+  if (opcode->flags & OPCODE_INFO_FPU) {
+    unsigned rslutidx = opcode->flags & 0x1;
+    unsigned rtlutidx = opcode->flags & 0x2;
+
+    rs = (iw >> (rslutidx ? 11 : 21) & 0x1F) | (rslutidx << 6);
+    rt |= (rtlutidx << 5);
+  }
+
+  predecode->opcode = *opcode;
+  predecode->rs = rs;
+  predecode->rt = rt;
+}
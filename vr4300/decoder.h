@@ -44,7 +44,15 @@ struct vr4300_opcode {
   uint32_t flags;
 };
 
+// An instruction decoded ahead of time, with its operands extracted.
+struct vr4300_predecode {
+  struct vr4300_opcode opcode;
+  uint32_t rs, rt;
+};
+
 cen64_hot const struct vr4300_opcode* vr4300_decode_instruction(uint32_t);
+cen64_hot void vr4300_predecode_instruction(
+  struct vr4300_predecode *predecode, uint32_t iw);
 
 #endif
 
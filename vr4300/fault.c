@@ -10,9 +10,11 @@
 
 #include "common.h"
 #include "bus/controller.h"
+#include "common/stats.h"
 #include "vr4300/cp0.h"
 #include "vr4300/cpu.h"
 #include "vr4300/dcache.h"
+#include "vr4300/debug.h"
 #include "vr4300/fault.h"
 #include "vr4300/icache.h"
 #include "vr4300/pipeline.h"
@@ -40,6 +42,7 @@ static void vr4300_common_interlocks(struct vr4300 *vr4300,
   unsigned cycles_to_stall, unsigned skip_stages) {
   struct vr4300_pipeline *pipeline = &vr4300->pipeline;
   pipeline->cycles_to_stall = cycles_to_stall;
+  pipeline->stall_cycles += cycles_to_stall;
   vr4300->regs[PIPELINE_CYCLE_TYPE] = skip_stages;
 }
 
@@ -189,6 +192,7 @@ void vr4300_exception_epilogue(struct vr4300 *vr4300,
   pipeline->exception_history = 0;
   pipeline->fault_present = true;
   pipeline->cycles_to_stall = 2;
+  pipeline->stall_cycles += 2;
 
   // Set CP0 registers in accordance with the exception.
   if (vr4300->regs[VR4300_CP0_REGISTER_STATUS] & 0x2) {
@@ -230,6 +234,7 @@ void VR4300_DADE(struct vr4300 *vr4300) {
 void VR4300_DCB(struct vr4300 *vr4300) {
   vr4300->pipeline.dcwb_latch.last_op_was_cache_store = false;
   vr4300_common_interlocks(vr4300, 0, 1);
+  stats_inc(vr4300_dcb_interlocks);
 }
 
 // DCM: Data cache busy interlock.
@@ -287,6 +292,8 @@ void VR4300_DCM(struct vr4300 *vr4300) {
       bus_write_word(vr4300, paddr, data, dqm);
     }
 
+    stats_inc(vr4300_uncached_accesses);
+    stats_add(vr4300_memory_stall_cycles, MEMORY_WORD_DELAY);
     vr4300_common_interlocks(vr4300, MEMORY_WORD_DELAY, 2);
     return;
   }
@@ -303,9 +310,13 @@ void VR4300_DCM(struct vr4300 *vr4300) {
     for (i = 0; i < 4; i++)
       bus_write_word(vr4300, bus_address + i * 4,
         data[i ^ (WORD_ADDR_XOR >> 2)], ~0);
+
+    stats_inc(vr4300_dcache_writebacks);
   }
 
   // Raise interlock condition, get virtual address.
+  stats_inc(vr4300_dcache_fills);
+  stats_add(vr4300_memory_stall_cycles, DCACHE_ACCESS_DELAY);
   vr4300_common_interlocks(vr4300, DCACHE_ACCESS_DELAY, 1);
   paddr &= ~0xF;
 
@@ -335,6 +346,7 @@ void VR4300_DTLB(struct vr4300 *vr4300, unsigned miss, unsigned inv, unsigned mo
     type = 0x1;
 
   vr4300_dc_fault(vr4300, VR4300_FAULT_DTLB);
+  stats_inc(vr4300_dtlb_exceptions);
   vr4300_tlb_exception_prolog(vr4300, common, &cause, &status,
     &epc, exdc_latch->segment, exdc_latch->request.vaddr, &offs);
 
@@ -347,6 +359,18 @@ void VR4300_DTLB(struct vr4300 *vr4300, unsigned miss, unsigned inv, unsigned mo
     status, epc, offs);
 }
 
+// FPE: Floating-point exception.
+void VR4300_FPE(struct vr4300 *vr4300) {
+  struct vr4300_latch *common = &vr4300->pipeline.exdc_latch.common;
+  uint32_t cause, status;
+  uint64_t epc;
+
+  vr4300_ex_fault(vr4300, VR4300_FAULT_FPE);
+  vr4300_exception_prolog(vr4300, common, &cause, &status, &epc);
+  vr4300_exception_epilogue(vr4300, (cause & ~0xFF) | 0x3C,
+    status, epc, 0x180);
+}
+
 // IADE: Instruction address error exception.
 void VR4300_IADE(struct vr4300 *vr4300) {
   abort(); // Hammertime!
@@ -363,6 +387,8 @@ void VR4300_ICB(struct vr4300 *vr4300) {
   if (!rfex_latch->cached) {
     bus_read_word(vr4300, paddr, &rfex_latch->iw);
     delay = MEMORY_WORD_DELAY;
+
+    stats_inc(vr4300_uncached_fetches);
   }
 
   else {
@@ -378,8 +404,14 @@ void VR4300_ICB(struct vr4300 *vr4300) {
     memcpy(&rfex_latch->iw, line + (vaddr >> 2 & 0x7), sizeof(rfex_latch->iw));
     vr4300_icache_fill(&vr4300->icache, icrf_latch->common.pc, paddr, line);
     delay = ICACHE_ACCESS_DELAY;
+
+    stats_inc(vr4300_icache_fills);
   }
 
+  if (unlikely(vr4300->debug != NULL))
+    vr4300_debug_fetch(vr4300, vaddr);
+
+  stats_add(vr4300_memory_stall_cycles, delay);
   vr4300_common_interlocks(vr4300, delay, 4);
 }
 
@@ -394,6 +426,7 @@ void VR4300_INTR(struct vr4300 *vr4300) {
   vr4300_exception_epilogue(vr4300, cause & ~0xFF, status, epc, 0x180);
 
   vr4300_dc_fault(vr4300, VR4300_FAULT_INTR);
+  stats_inc(vr4300_interrupts);
 }
 
 // INV: Invalid operation exception.
@@ -411,6 +444,7 @@ void VR4300_ITLB(struct vr4300 *vr4300, unsigned miss) {
   unsigned offs;
 
   vr4300_rf_fault(vr4300, VR4300_FAULT_ITLB);
+  stats_inc(vr4300_itlb_exceptions);
   vr4300_tlb_exception_prolog(vr4300, common, &cause, &status,
     &epc, icrf_latch->segment, icrf_latch->common.pc, &offs);
 
@@ -430,6 +464,7 @@ void VR4300_LDI(struct vr4300 *vr4300) {
   // We'll do EX again, but clear the 'busy' flag.
   exdc_latch->request.type = VR4300_BUS_REQUEST_NONE;
   vr4300_common_interlocks(vr4300, 0, 2);
+  stats_inc(vr4300_ldi_interlocks);
 }
 
 // RST: External reset exception.
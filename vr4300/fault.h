@@ -29,6 +29,7 @@ cen64_cold void VR4300_CPU(struct vr4300 *vr4300);
 cen64_cold void VR4300_DADE(struct vr4300 *vr4300);
 cen64_cold void VR4300_DCB(struct vr4300 *vr4300);
 cen64_cold void VR4300_DCM(struct vr4300 *vr4300);
+cen64_cold void VR4300_FPE(struct vr4300 *vr4300);
 cen64_cold void VR4300_IADE(struct vr4300 *vr4300);
 cen64_cold void VR4300_ICB(struct vr4300 *vr4300);
 cen64_cold void VR4300_INTR(struct vr4300 *vr4300);
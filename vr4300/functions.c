@@ -13,6 +13,7 @@
 
 #include "common.h"
 #include "bus/controller.h"
+#include "common/stats.h"
 #include "vr4300/cp0.h"
 #include "vr4300/cp1.h"
 #include "vr4300/cpu.h"
@@ -99,7 +100,9 @@ static inline uint64_t VR4300_LWR_forceset(unsigned offset)
 // Raises a MCI interlock for a set number of cycles.
 //
 static inline int vr4300_do_mci(struct vr4300 *vr4300, unsigned cycles) {
+  stats_add(vr4300_mci_stall_cycles, cycles - 1);
   vr4300->pipeline.cycles_to_stall = cycles - 1;
+  vr4300->pipeline.stall_cycles += cycles - 1;
   vr4300->regs[PIPELINE_CYCLE_TYPE] = 3;
   return 1;
 }
@@ -569,6 +572,143 @@ cen64_cold static int vr4300_cacheop_dc_hit_wb(
   return 0;
 }
 
+#ifdef VR4300_CACHE_LOOP_DETECTION
+//
+// If VR4300_CACHE_LOOP_DETECTION is defined, CACHE instructions
+// check whether they are the head of one of libultra's cache
+// maintenance loops:
+//
+// loop:
+//   cache op, offset(base)
+//   sltu  cmp, base, end
+//   bnez  cmp, loop
+//   addiu base, base, linesize
+//
+// When they are, the operations for the current and following
+// iterations are done at once over the cache lines. base is then
+// advanced to the last of those iterations (so the sltu lets the
+// loop fall through, or resume past them) and the pipeline stalls
+// for exactly the cycles the skipped iterations would have taken.
+//
+// The current iteration's operation still runs in DC afterwards;
+// only ops that are no-ops the second time around are accepted:
+// everything but Index_Load_Tag and Create_Dirty_Exclusive.
+//
+// XXX: Nothing outside the loop can tell it apart from the real
+//      thing only if it runs out of the ICache in KSEG0, touches
+//      unmapped addresses, can't be interrupted and isn't being
+//      watched. Bail out on anything else.
+//
+//      In practice that limits it to loops run with interrupts
+//      disabled (boot code, and libultra when called that way). An
+//      RCP interrupt can be raised on any cycle, so batching can't
+//      tell in advance where one would have landed mid-loop.
+//
+#define VR4300_CACHE_LOOP_OPS 0x7515U
+#define VR4300_CACHE_LOOP_MAX 512
+
+static void vr4300_cacheop_loop(struct vr4300 *vr4300, uint32_t iw,
+  uint64_t base_reg, unsigned op, vr4300_cacheop_func_t cacheop) {
+  const struct vr4300_icrf_latch *icrf_latch = &vr4300->pipeline.icrf_latch;
+  const struct vr4300_rfex_latch *rfex_latch = &vr4300->pipeline.rfex_latch;
+  struct vr4300_dcwb_latch *dcwb_latch = &vr4300->pipeline.dcwb_latch;
+
+  uint32_t cp0_status = vr4300->regs[VR4300_CP0_REGISTER_STATUS];
+  uint32_t cp0_cause = vr4300->regs[VR4300_CP0_REGISTER_CAUSE];
+  uint64_t pc = rfex_latch->common.pc;
+
+  const struct vr4300_icache_line *head, *tail;
+  unsigned base, cmp, end, linesize, i;
+  bool icache_op = !(op & 0x18);
+  uint64_t end_reg, vaddr;
+  uint32_t loop[3];
+  int delay = 0;
+
+  if (!(VR4300_CACHE_LOOP_OPS >> op & 0x1) || vr4300->slow_paths ||
+    vr4300->debug != NULL || (vr4300->regs[VR4300_CP0_REGISTER_WATCHLO] & 0x3))
+    return;
+
+  // Interrupts must be disabled, or only ones we can't get enabled.
+  if (((cp0_status ^ 6) & 0x7) == 0x7 &&
+    ((cp0_status & 0xFC00) || (cp0_cause & cp0_status & 0xFF00)))
+    return;
+
+  // The loop must be fetched from the ICache (in KSEG0) and this
+  // must not be a delay slot; the next fetches have to be the loop.
+  if ((pc - 0xFFFFFFFF80000000ULL) >= 0x20000000ULL - 12 ||
+    icrf_latch->common.pc != pc + 4)
+    return;
+
+  if (!(head = vr4300_icache_probe(&vr4300->icache, pc, pc & 0x1FFFFFFF)) ||
+    !(tail = vr4300_icache_probe(&vr4300->icache,
+    pc + 12, (pc + 12) & 0x1FFFFFFF)))
+    return;
+
+  for (i = 0; i < 3; i++) {
+    uint64_t next = pc + (i + 1) * 4;
+
+    memcpy(loop + i, ((next ^ pc) & 0x20 ? tail : head)->data +
+      (next & 0x1C), sizeof(*loop));
+  }
+
+  base = GET_RS(iw);
+  cmp = GET_RD(loop[0]);
+  end = GET_RT(loop[0]);
+  linesize = icache_op ? 32 : 16;
+
+  if ((loop[0] & 0xFC0007FFU) != 0x2B || GET_RS(loop[0]) != base ||
+    loop[1] != (0x1400FFFDU | cmp << 21) ||
+    loop[2] != (0x24000000U | base << 21 | base << 16 | linesize))
+    return;
+
+  if (base == 0 || cmp == 0 || cmp == base || cmp == end)
+    return;
+
+  // The end register may still be on its way to the register file.
+  end_reg = dcwb_latch->dest == end
+    ? (uint64_t) dcwb_latch->result : vr4300->regs[end];
+
+  if (base_reg >= end_reg)
+    return;
+
+  // Do the current iteration and as many of the next ones as we can.
+  for (i = 0; i < VR4300_CACHE_LOOP_MAX; i++) {
+    uint64_t iteration = base_reg + i * linesize;
+    vaddr = iteration + (int16_t) iw;
+
+    if ((iteration - 0xFFFFFFFF80000000ULL) >= 0x40000000ULL ||
+      (vaddr - 0xFFFFFFFF80000000ULL) >= 0x40000000ULL)
+      break;
+
+    // Don't pull the loop itself out of the ICache.
+    if (icache_op && (((vaddr ^ pc) >> 5 & 0x1FF) == 0 ||
+      ((vaddr ^ (pc + 12)) >> 5 & 0x1FF) == 0))
+      break;
+
+    delay += cacheop(vr4300, vaddr, vaddr & 0x1FFFFFFF);
+
+    if (iteration >= end_reg) {
+      i++;
+      break;
+    }
+  }
+
+  if (i == 0)
+    return;
+
+  // Iteration i - 1 becomes the one the pipeline is about to finish.
+  base_reg += (i - 1) * linesize;
+
+  if (dcwb_latch->dest == base)
+    dcwb_latch->result = base_reg;
+  else
+    vr4300->regs[base] = base_reg;
+
+  vr4300->pipeline.cycles_to_stall = delay + (i - 1) * 4;
+  vr4300->pipeline.stall_cycles += delay + (i - 1) * 4;
+}
+#endif
+
 int VR4300_CACHE(struct vr4300 *vr4300,
   uint32_t iw, uint64_t rs, uint64_t rt) {
 
@@ -606,6 +746,10 @@ int VR4300_CACHE(struct vr4300 *vr4300,
     ? VR4300_BUS_REQUEST_CACHE_WRITE
     : VR4300_BUS_REQUEST_CACHE_IDX;
 
+#ifdef VR4300_CACHE_LOOP_DETECTION
+  vr4300_cacheop_loop(vr4300, iw, rs, op, cacheop_lut[op]);
+#endif
+
   return 0;
 }
 
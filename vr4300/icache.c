@@ -18,8 +18,11 @@ static inline const struct vr4300_icache_line* get_line_const(
 
 static inline uint32_t get_tag(const struct vr4300_icache_line *line);
 static inline bool is_valid(const struct vr4300_icache_line *line);
+static inline uint32_t get_trap(const struct vr4300_icache *icache,
+  uint64_t vaddr);
 
 static void invalidate_line(struct vr4300_icache_line *line);
+static void predecode_line(struct vr4300_icache *icache, uint64_t vaddr);
 static void set_taglo(struct vr4300_icache_line *line, uint32_t taglo);
 static void validate_line(struct vr4300_icache_line *line, uint32_t tag);
 
@@ -50,6 +53,25 @@ bool is_valid(const struct vr4300_icache_line *line) {
   return (line->metadata & 0x1) == 0x1;
 }
 
+// Returns the trap bit for the line associated with vaddr.
+uint32_t get_trap(const struct vr4300_icache *icache, uint64_t vaddr) {
+  return icache->traps[vaddr >> 5 & 0x1FF] ? 0x2 : 0x0;
+}
+
+// Decodes the instructions held by the line associated with vaddr.
+void predecode_line(struct vr4300_icache *icache, uint64_t vaddr) {
+  const struct vr4300_icache_line *line = get_line_const(icache, vaddr);
+  struct vr4300_predecode *predecode = icache->predecode[vaddr >> 5 & 0x1FF];
+  unsigned i;
+
+  for (i = 0; i < 8; i++) {
+    uint32_t iw;
+
+    memcpy(&iw, line->data + i * 4, sizeof(iw));
+    vr4300_predecode_instruction(predecode + i, iw);
+  }
+}
+
 // Sets the tag of the specified line and valid bit.
 void set_taglo(struct vr4300_icache_line *line, uint32_t taglo) {
   line->metadata = (taglo << 4 & 0xFFFFF000) | (taglo >> 7 & 0x1);
@@ -67,6 +89,9 @@ void vr4300_icache_fill(struct vr4300_icache *icache,
 
   memcpy(line->data, data, sizeof(line->data));
   validate_line(line, paddr & ~0xFFFU);
+  line->metadata |= get_trap(icache, vaddr);
+
+  predecode_line(icache, vaddr);
 }
 
 // Returns the tag of the line associated with vaddr.
@@ -79,6 +104,10 @@ uint32_t vr4300_icache_get_tag(const struct vr4300_icache *icache,
 
 // Initializes the instruction cache.
 void vr4300_icache_init(struct vr4300_icache *icache) {
+  unsigned i;
+
+  for (i = 0; i < 512; i++)
+    predecode_line(icache, i << 5);
 }
 
 // Invalidates an instruction cache line (regardless if hit or miss).
@@ -104,8 +133,26 @@ const struct vr4300_icache_line* vr4300_icache_probe(
   const struct vr4300_icache_line *line = get_line_const(icache, vaddr);
   uint32_t ptag = get_tag(line);
 
-  // Virtually index, and physically tagged.
-  if (ptag == (paddr & ~0xFFFU) && is_valid(line))
+  // Virtually index, and physically tagged. Trapped lines miss.
+  if (ptag == (paddr & ~0xFFFU) && (line->metadata & 0x3) == 0x1)
+    return line;
+
+  return NULL;
+}
+
+// Returns the predecoded instruction at vaddr (for a line that hit).
+const struct vr4300_predecode *vr4300_icache_predecode(
+  const struct vr4300_icache *icache, uint64_t vaddr) {
+  return &icache->predecode[vaddr >> 5 & 0x1FF][vaddr >> 2 & 0x7];
+}
+
+// Probes the instruction cache for a trapped line that would have hit.
+const struct vr4300_icache_line* vr4300_icache_probe_trapped(
+  const struct vr4300_icache *icache, uint64_t vaddr, uint32_t paddr) {
+  const struct vr4300_icache_line *line = get_line_const(icache, vaddr);
+  uint32_t ptag = get_tag(line);
+
+  if (ptag == (paddr & ~0xFFFU) && (line->metadata & 0x3) == 0x3)
     return line;
 
   return NULL;
@@ -117,5 +164,15 @@ void vr4300_icache_set_taglo(struct vr4300_icache *icache,
   struct vr4300_icache_line *line = get_line(icache, vaddr);
 
   set_taglo(line, taglo);
+  line->metadata |= get_trap(icache, vaddr);
+}
+
+// Adds or removes a breakpoint's trap on the line associated with vaddr.
+void vr4300_icache_trap(struct vr4300_icache *icache,
+  uint64_t vaddr, bool trap) {
+  struct vr4300_icache_line *line = get_line(icache, vaddr);
+
+  icache->traps[vaddr >> 5 & 0x1FF] += trap ? 1 : -1;
+  line->metadata = (line->metadata & ~0x2U) | get_trap(icache, vaddr);
 }
 
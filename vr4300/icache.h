@@ -11,6 +11,7 @@
 #ifndef __vr4300_icache_h__
 #define __vr4300_icache_h__
 #include "common.h"
+#include "vr4300/decoder.h"
 
 struct vr4300_icache_line {
   uint8_t data[8 * 4];
@@ -19,12 +20,25 @@ struct vr4300_icache_line {
 
 struct vr4300_icache {
   struct vr4300_icache_line lines[512];
+
+  // Breakpoints per line; lines with any are kept out of the fast path.
+  uint16_t traps[512];
+
+  // Each line's instructions, decoded when the line is filled.
+  struct vr4300_predecode predecode[512][8];
 };
 
 cen64_cold void vr4300_icache_init(struct vr4300_icache *icache);
 
 cen64_hot const struct vr4300_icache_line* vr4300_icache_probe(
   const struct vr4300_icache *icache, uint64_t vaddr, uint32_t paddr);
+cen64_hot const struct vr4300_predecode *vr4300_icache_predecode(
+  const struct vr4300_icache *icache, uint64_t vaddr);
+
+cen64_cold const struct vr4300_icache_line* vr4300_icache_probe_trapped(
+  const struct vr4300_icache *icache, uint64_t vaddr, uint32_t paddr);
+cen64_cold void vr4300_icache_trap(struct vr4300_icache *icache,
+  uint64_t vaddr, bool trap);
 
 void vr4300_icache_fill(struct vr4300_icache *icache,
   uint64_t vaddr, uint32_t paddr, const void *data);
@@ -50,13 +50,15 @@ static void lower_rcp_interrupt(struct vr4300 *vr4300) {
 #endif
 }
 
-// Asserts the interrupt signal from the RCP.
+// Asserts the interrupt signal from the RCP. Status may be changing
+// on another thread, so the DC stage is left to decide.
 static void raise_rcp_interrupt(struct vr4300 *vr4300) {
 #ifdef _MSC_VER
   InterlockedOr(&vr4300->regs[VR4300_CP0_REGISTER_CAUSE], 0x400);
 #else
   __sync_or_and_fetch(&vr4300->regs[VR4300_CP0_REGISTER_CAUSE], 0x400);
 #endif
+  vr4300->intr_pending = 1;
 }
 
 // Deasserts the interrupt signal from the 64DD.
@@ -75,6 +77,7 @@ void signal_dd_interrupt(struct vr4300 *vr4300) {
 #else
   __sync_or_and_fetch(&vr4300->regs[VR4300_CP0_REGISTER_CAUSE], 0x800);
 #endif
+  vr4300->intr_pending = 1;
 }
 
 // Callback: An RCP component is signaling an interrupt.
@@ -12,11 +12,15 @@
 #include "bus/controller.h"
 #include "vr4300/cp0.h"
 #include "vr4300/cpu.h"
+#include "vr4300/debug.h"
 #include "vr4300/decoder.h"
 #include "vr4300/fault.h"
 #include "vr4300/opcodes.h"
 #include "vr4300/pipeline.h"
 #include "vr4300/segment.h"
+#ifdef _WIN32
+#include <windows.h>
+#endif
 
 typedef void (*pipeline_function)(struct vr4300 *vr4300);
 
@@ -26,6 +30,7 @@ static void vr4300_cycle_slow_ex(struct vr4300 *vr4300);
 static void vr4300_cycle_slow_rf(struct vr4300 *vr4300);
 static void vr4300_cycle_slow_ic(struct vr4300 *vr4300);
 static void vr4300_cycle_busywait(struct vr4300 *vr4300);
+cen64_cold static bool vr4300_confirm_interrupt(struct vr4300 *vr4300);
 
 // Prints out instructions and their virtual address as they are executed.
 // Note: Some of these instructions _may_ be speculative and killed later...
@@ -36,14 +41,26 @@ cen64_flatten static void vr4300_ic_stage(struct vr4300 *vr4300) {
   struct vr4300_rfex_latch *rfex_latch = &vr4300->pipeline.rfex_latch;
   struct vr4300_icrf_latch *icrf_latch = &vr4300->pipeline.icrf_latch;
 
+  const struct vr4300_predecode *predecode = rfex_latch->predecode;
   const struct segment *segment = icrf_latch->segment;
   struct vr4300_opcode *opcode = &rfex_latch->opcode;
+  struct vr4300_predecode decoded;
   uint64_t pc = icrf_latch->pc;
   uint32_t decode_iw;
 
-  // Finish decoding instruction in RF.
+  // Finish decoding instruction in RF. Words that came out of the
+  // instruction cache (and weren't nullified) were decoded on the fill.
   decode_iw = rfex_latch->iw &= rfex_latch->iw_mask;
-  *opcode = *vr4300_decode_instruction(decode_iw);
+
+  if (unlikely(predecode == NULL || !rfex_latch->iw_mask)) {
+    vr4300_predecode_instruction(&decoded, decode_iw);
+    predecode = &decoded;
+  }
+
+  *opcode = predecode->opcode;
+  rfex_latch->rs = predecode->rs;
+  rfex_latch->rt = predecode->rt;
+  rfex_latch->predecode = NULL;
   rfex_latch->iw_mask = ~0U;
 
   // Latch common pipeline values.
@@ -108,6 +125,16 @@ static int vr4300_rf_stage(struct vr4300 *vr4300) {
     rfex_latch->paddr = paddr;
     rfex_latch->cached = cached;
 
+    // Lines holding a breakpoint miss on purpose; they're really hits.
+    if (unlikely(vr4300->debug != NULL) && cached && (line =
+      vr4300_icache_probe_trapped(&vr4300->icache, vaddr, paddr))) {
+      memcpy(&rfex_latch->iw, line->data + (paddr & 0x1C),
+        sizeof(rfex_latch->iw));
+
+      vr4300_debug_fetch(vr4300, vaddr);
+      return 0;
+    }
+
     VR4300_ICB(vr4300);
     return 1;
   }
@@ -115,6 +142,8 @@ static int vr4300_rf_stage(struct vr4300 *vr4300) {
   memcpy(&rfex_latch->iw, line->data + (paddr & 0x1C),
     sizeof(rfex_latch->iw));
 
+  rfex_latch->predecode = likely(!vr4300->slow_paths)
+    ? vr4300_icache_predecode(&vr4300->icache, vaddr) : NULL;
   return 0;
 }
 
@@ -125,19 +154,18 @@ static int vr4300_ex_stage(struct vr4300 *vr4300) {
   struct vr4300_exdc_latch *exdc_latch = &vr4300->pipeline.exdc_latch;
   uint32_t cp0_status = vr4300->regs[VR4300_CP0_REGISTER_STATUS];
 
-  unsigned rs, rt, rslutidx, rtlutidx;
   uint64_t rs_reg, rt_reg, temp;
   uint32_t flags, iw;
+  unsigned rs, rt;
 
   exdc_latch->common = rfex_latch->common;
   flags = rfex_latch->opcode.flags;
   iw = rfex_latch->iw;
 
-  rs = GET_RS(iw);
-  rt = GET_RT(iw);
+  rs = rfex_latch->rs;
+  rt = rfex_latch->rt;
 
   if (flags & OPCODE_INFO_FPU) {
-    cen64_align(static const unsigned fpu_select_lut[2], 8) = {21, 11};
     unsigned fr;
 
     // Dealing with FPU state, is CP1 usable?
@@ -146,17 +174,12 @@ static int vr4300_ex_stage(struct vr4300 *vr4300) {
       return 1;
     }
 
-    // Check if one of the sources is an FPU register. Furthermore,
-    // if Status.FR bit is clear, we depend on even registers only.
+    // If one of the sources is an FPU register (the decoder already
+    // picked it out) and Status.FR is clear, use even registers only.
     fr = (cp0_status >> 26 & 0x1) ^ 0x1;
-    rtlutidx = flags & 0x2;
-    rslutidx = flags & 0x1;
-
-    rs = (iw >> fpu_select_lut[rslutidx] & 0x1F) | (rslutidx << 6);
-    rt |= (rtlutidx << 5);
 
-    rs &= ~((rslutidx) & fr);
-    rt &= ~((rtlutidx >> 1) & fr);
+    rs &= ~((flags & 0x1) & fr);
+    rt &= ~((flags >> 1 & 0x1) & fr);
   }
 
   // Check to see if we should hold off execution due to a LDI.
@@ -191,13 +214,32 @@ static int vr4300_ex_stage(struct vr4300 *vr4300) {
     vr4300, iw, rs_reg, rt_reg);
 }
 
+// Clears the interrupt-pending flag and then checks Status and Cause.
+// Clearing first means an interrupt raised by another thread meanwhile
+// leaves the flag set rather than being lost.
+bool vr4300_confirm_interrupt(struct vr4300 *vr4300) {
+  uint32_t cp0_status, cp0_cause;
+
+  vr4300->intr_pending = 0;
+#ifdef _MSC_VER
+  MemoryBarrier();
+#else
+  __sync_synchronize();
+#endif
+
+  cp0_status = vr4300->regs[VR4300_CP0_REGISTER_STATUS];
+  cp0_cause = vr4300->regs[VR4300_CP0_REGISTER_CAUSE];
+
+  return cp0_cause & cp0_status & 0xFF00 &&
+    ((cp0_status ^ 6) & 0x7) == 0x7;
+}
+
 // Data cache fetch stage.
 static int vr4300_dc_stage(struct vr4300 *vr4300) {
   struct vr4300_exdc_latch *exdc_latch = &vr4300->pipeline.exdc_latch;
   struct vr4300_dcwb_latch *dcwb_latch = &vr4300->pipeline.dcwb_latch;
 
   uint32_t cp0_status = vr4300->regs[VR4300_CP0_REGISTER_STATUS];
-  uint32_t cp0_cause = vr4300->regs[VR4300_CP0_REGISTER_CAUSE];
   const struct segment *segment = exdc_latch->segment;
   bool cached;
 
@@ -214,8 +256,7 @@ static int vr4300_dc_stage(struct vr4300 *vr4300) {
   }
 
   // Check if we should raise an interrupt (and effectively kill this insn).
-  if (unlikely(cp0_cause & cp0_status & 0xFF00 &&
-    (((cp0_status ^ 6) & 0x7) == 0x7))) {
+  if (unlikely(vr4300->intr_pending) && vr4300_confirm_interrupt(vr4300)) {
     VR4300_INTR(vr4300);
     return 1;
   }
@@ -263,13 +304,21 @@ static int vr4300_dc_stage(struct vr4300 *vr4300) {
       paddr = (vr4300->cp0.pfn[index][select]) | (vaddr & page_mask);
     }
 
-    // Check to see if we should raise a WAT exception.
-    if (unlikely((paddr & ~0x80000007U) == (vr4300->regs[
-      VR4300_CP0_REGISTER_WATCHLO] & ~0x80000007U))) {
+    // Check to see if we should raise a WAT exception. Debugger
+    // watchpoints widen the filter, so recheck WatchLo on a match.
+    // DCB and DCM resume at DC (cycle type 1); don't report twice.
+    if (unlikely(((paddr ^ vr4300->cp0.watch_address) &
+      vr4300->cp0.watch_mask) == 0)) {
+      uint32_t watch_lo = vr4300->regs[VR4300_CP0_REGISTER_WATCHLO];
+
+      if (unlikely(vr4300->debug != NULL) &&
+        vr4300->regs[PIPELINE_CYCLE_TYPE] != 1)
+        vr4300_debug_access(vr4300, paddr, request->type);
 
       // We hit the address, just check load/store.
       // TODO: Postposted if EXL bit is set.
-      if (vr4300->regs[VR4300_CP0_REGISTER_WATCHLO] & request->type & 0x3) {
+      if (((paddr ^ watch_lo) & ~0x80000007U) == 0 &&
+        (watch_lo & request->type & 0x3)) {
         VR4300_WAT(vr4300);
         return 1;
       }
@@ -348,6 +397,7 @@ static int vr4300_dc_stage(struct vr4300 *vr4300) {
 
       if ((delay = request->cacheop(vr4300, vaddr, paddr))) {
         vr4300->pipeline.cycles_to_stall = delay - 1;
+        vr4300->pipeline.stall_cycles += delay - 1;
         vr4300->regs[PIPELINE_CYCLE_TYPE] = 2;
         return 1;
       }
@@ -464,12 +514,9 @@ void vr4300_cycle_slow_ic(struct vr4300 *vr4300) {
 
 // Special-cased busy wait handler.
 void vr4300_cycle_busywait(struct vr4300 *vr4300) {
-  uint32_t cp0_status = vr4300->regs[VR4300_CP0_REGISTER_STATUS];
-  uint32_t cp0_cause = vr4300->regs[VR4300_CP0_REGISTER_CAUSE];
 
   // Check if the busy wait period is over (due to an interrupt condition).
-  if (unlikely(cp0_cause & cp0_status & 0xFF00)
-    && (cp0_status & 0x1) && !(cp0_status & 0x6)) {
+  if (unlikely(vr4300->intr_pending) && vr4300_confirm_interrupt(vr4300)) {
     //debug("Busy wait done @ %llu cycles\n", vr4300->cycles);
 
     VR4300_INTR(vr4300);
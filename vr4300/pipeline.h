@@ -62,7 +62,9 @@ struct vr4300_icrf_latch {
 struct vr4300_rfex_latch {
   struct vr4300_latch common;
   struct vr4300_opcode opcode;
+  const struct vr4300_predecode *predecode;
   uint32_t iw, iw_mask, paddr;
+  uint32_t rs, rt;
   bool cached;
 };
 
@@ -89,6 +91,8 @@ struct vr4300_pipeline {
   struct vr4300_rfex_latch rfex_latch;
   struct vr4300_icrf_latch icrf_latch;
 
+  // Running total of cycles_to_stall, added where it's set.
+  unsigned long long stall_cycles;
   unsigned exception_history;
   unsigned cycles_to_stall;
   bool fault_present;